@@ -20,8 +20,12 @@
 #include "colors.h"
 
 #include <cwidget/curses++.h>
+#include <cwidget/generic/threads/threads.h>
 
-#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
 namespace cwidget
 {
@@ -29,97 +33,355 @@ namespace cwidget
   {
     static bool colors_avail=false;
     static bool default_colors_avail = false;
+    static bool direct_colors_avail = false;
     static int colors = 0;
+    // Read without the allocator lock, on every use of an interned
+    // style.
+    static std::atomic<int> color_generation(0);
 
-    // Simplistic allocation scheme for colors: (fg,bg) => fg*COLORS+bg
+    namespace
+    {
+      // Color pairs are allocated the first time a combination of
+      // colors is used.  Pairs are numbered from 1; pair 0 is the
+      // terminal's default colors and is never touched.
+      //
+      // A pair is never redefined once it is allocated: its number is
+      // stored in the screen, in window buffers and in cached
+      // layouts, and all of them would silently change color.  When
+      // the pairs run out, a new combination shares the allocated
+      // pair whose colors are closest to it.
+      //
+      // The number of pairs is limited by COLOR_PAIRS and by the bits
+      // available for a pair in an attribute word (A_COLOR), since
+      // that is how pairs are passed around.
+
+      /** The largest number of colors for which the (fg,bg) -> pair
+       *  table is stored as a flat array.
+       */
+      const int max_dense_colors = 256;
+
+      struct pair_info
+      {
+	/** The colors this pair is defined as. */
+	int fg, bg;
+      };
+
+      /** Protects the allocator; styles are applied from the layout
+       *  worker threads as well as the main thread.
+       */
+      threads::mutex &get_pairs_mutex()
+      {
+	static threads::mutex m;
+	return m;
+      }
+
+      /** The number of usable pair numbers, including pair 0. */
+      int num_pairs = 0;
+
+      /** The next pair that has never been used. */
+      int next_unused_pair = 1;
+
+      /** The colors of each allocated pair, indexed by pair number. */
+      std::vector<pair_info> pairs;
+
+      /** For palettes of up to max_dense_colors colors, the pair
+       *  assigned to (fg,bg) is stored at (fg+1)*(colors+1)+(bg+1);
+       *  0 means that no pair is assigned.
+       */
+      std::vector<short> dense_pairs;
+
+      /** For direct-color terminals, where the palette is too large
+       *  for a flat table.
+       */
+      std::unordered_map<long long, short> sparse_pairs;
+
+      long long pair_key(int fg, int bg)
+      {
+	return ((long long)(fg + 1) << 32) | (unsigned int)(bg + 1);
+      }
+
+      /** \return the pair assigned to (fg,bg), or 0 if there isn't one. */
+      int lookup_pair(int fg, int bg)
+      {
+	if(colors <= max_dense_colors)
+	  return dense_pairs[(fg + 1) * (colors + 1) + (bg + 1)];
+	else
+	  {
+	    std::unordered_map<long long, short>::const_iterator found =
+	      sparse_pairs.find(pair_key(fg, bg));
+
+	    return found == sparse_pairs.end() ? 0 : found->second;
+	  }
+      }
+
+      void set_pair_mapping(int fg, int bg, int pair)
+      {
+	if(colors <= max_dense_colors)
+	  dense_pairs[(fg + 1) * (colors + 1) + (bg + 1)] = pair;
+	else if(pair == 0)
+	  sparse_pairs.erase(pair_key(fg, bg));
+	else
+	  sparse_pairs[pair_key(fg, bg)] = pair;
+      }
+
+      /** Find the red, green and blue levels of a color, the
+       *  inverse of rgb_color().
+       */
+      void color_levels(int color, int &r, int &g, int &b)
+      {
+	if(direct_colors_avail ? color >= 8 : color >= 256)
+	  {
+	    r = (color >> 16) & 0xff;
+	    g = (color >> 8) & 0xff;
+	    b = color & 0xff;
+	  }
+	else if(color >= 232)
+	  r = g = b = 8 + 10 * (color - 232);
+	else if(color >= 16)
+	  {
+	    static const int cube_levels[6] = {0, 95, 135, 175, 215, 255};
+
+	    r = cube_levels[(color - 16) / 36];
+	    g = cube_levels[(color - 16) / 6 % 6];
+	    b = cube_levels[(color - 16) % 6];
+	  }
+	else if(color == 8)
+	  r = g = b = 127;
+	else
+	  {
+	    const int level = color >= 8 ? 255 : 205;
+
+	    r = (color & COLOR_RED) != 0 ? level : 0;
+	    g = (color & COLOR_GREEN) != 0 ? level : 0;
+	    b = (color & COLOR_BLUE) != 0 ? level : 0;
+	  }
+      }
+
+      /** \return how different two colors look, as a squared
+       *  distance between their levels.  The terminal's default
+       *  color (-1) is only close to itself.
+       */
+      long color_distance(int color1, int color2)
+      {
+	if(color1 == color2)
+	  return 0;
+	else if(color1 == -1 || color2 == -1)
+	  return 3L * 256 * 256;
+
+	int r1, g1, b1, r2, g2, b2;
+	color_levels(color1, r1, g1, b1);
+	color_levels(color2, r2, g2, b2);
+
+	return long(r1 - r2) * (r1 - r2) +
+	  long(g1 - g2) * (g1 - g2) +
+	  long(b1 - b2) * (b1 - b2);
+      }
+
+      /** \return the allocated pair that looks most like (fg,bg). */
+      int nearest_pair(int fg, int bg)
+      {
+	int best = 1;
+	long best_distance = -1;
+
+	for(int pair = 1; pair < next_unused_pair; ++pair)
+	  {
+	    const long distance =
+	      color_distance(pairs[pair].fg, fg) +
+	      color_distance(pairs[pair].bg, bg);
+
+	    if(best_distance == -1 || distance < best_distance)
+	      {
+		best = pair;
+		best_distance = distance;
+	      }
+	  }
+
+	return best;
+      }
+
+      /** Assign a pair to (fg,bg): a new pair if any are left,
+       *  otherwise the nearest existing one.
+       */
+      int allocate_pair(int fg, int bg)
+      {
+	if(next_unused_pair >= num_pairs)
+	  {
+	    const int pair = nearest_pair(fg, bg);
+	    set_pair_mapping(fg, bg, pair);
+	    return pair;
+	  }
+
+	const int pair = next_unused_pair++;
+
+#ifdef NCURSES_EXT_COLORS
+	init_extended_pair(pair, fg, bg);
+#else
+	init_pair(pair, fg, bg);
+#endif
+
+	pairs[pair].fg = fg;
+	pairs[pair].bg = bg;
+	set_pair_mapping(fg, bg, pair);
+
+	return pair;
+      }
+
+      /** Forget every pair and start allocating them from 1 again. */
+      void reset_pairs()
+      {
+	next_unused_pair = 1;
+	pairs.assign(num_pairs, pair_info());
+
+	dense_pairs.clear();
+	sparse_pairs.clear();
+	if(colors <= max_dense_colors)
+	  dense_pairs.assign((colors + 1) * (colors + 1), 0);
+      }
+    }
 
     void init_colors()
     {
-      if(COLOR_PAIRS < COLORS * COLORS)
-	colors = (int) floor(sqrt(COLOR_PAIRS));
-      else
-	colors = COLORS;
+      threads::mutex::lock l(get_pairs_mutex());
+
+      ++color_generation;
+
+      colors_avail = false;
+      colors = COLORS;
+      // The number of pairs that fit in A_COLOR.
+      num_pairs = std::min(COLOR_PAIRS, (int)PAIR_NUMBER(A_COLOR) + 1);
 
-      if(colors < 8)
+      if(colors < 8 || num_pairs < 2)
 	return;
-      else
-	colors = std::min(colors, 8);
 
       colors_avail=true;
       default_colors_avail = (use_default_colors() != ERR);
+#ifdef NCURSES_EXT_COLORS
+      direct_colors_avail = tigetflag(const_cast<char *>("RGB")) > 0;
+#else
+      direct_colors_avail = false;
+#endif
 
-      for(short fg = 0; fg < colors; ++fg)
-	for(short bg = 0; bg < colors; ++bg)
-	  {
-	    eassert(fg * colors + bg < COLOR_PAIRS);
-
-	    if(default_colors_avail && fg == bg)
-	      init_pair(fg * colors + bg, fg, -1);
-	    else if(fg == 0 && bg == 0)
-	      // do nothing; on some terminals, doing this causes the
-	      // cursor to become INVISIBLE, and black-on-black text is a
-	      // bad idea anyway..
-	      ;
-	    /*assume_default_colors(0, 0);*/
-	    else
-	      init_pair(fg * colors + bg, fg, bg);
-	  }
+      reset_pairs();
     }
 
-    int get_color_pair(short fg, short bg)
+    void init_colors(int num_colors, int max_pairs)
     {
-      if(!colors_avail)
-	return 0;
-      else
-	{
-	  // Fall back to the default color if the user asked for too
-	  // much.
-	  if(fg >= colors)
-	    fg = 0;
+      threads::mutex::lock l(get_pairs_mutex());
+
+      ++color_generation;
 
-	  if(bg >= colors)
-	    bg = 0;
+      colors = num_colors;
+      num_pairs = std::min(max_pairs, (int)PAIR_NUMBER(A_COLOR) + 1);
+      colors_avail = (colors >= 8 && num_pairs >= 2);
+      default_colors_avail = false;
+      // Only direct-color terminals have more colors than this.
+      direct_colors_avail = (colors > max_dense_colors);
 
-	  eassert(fg >= 0 && bg >= -1 && fg < colors && bg < colors);
+      if(colors_avail)
+	reset_pairs();
+    }
+
+    int get_color_generation()
+    {
+      return color_generation.load();
+    }
 
-	  if(bg == -1)
-	    return fg * colors + fg;
-	  else if(fg == bg && default_colors_avail)
-	    // Pick an arbitrary distinct foreground color to match with
-	    // the background.
+    int get_num_colors()
+    {
+      return colors_avail ? colors : 0;
+    }
+
+    int rgb_color(unsigned char r, unsigned char g, unsigned char b)
+    {
+      if(direct_colors_avail)
+	// Values below 8 select the basic colors rather than shades
+	// of blue.
+	return std::max((r << 16) | (g << 8) | b, 8);
+      else if(colors >= 256)
+	{
+	  // The xterm palette: a 6x6x6 color cube starting at 16 and
+	  // a 24-step gray ramp starting at 232.
+	  const int r6 = (r * 5 + 127) / 255;
+	  const int g6 = (g * 5 + 127) / 255;
+	  const int b6 = (b * 5 + 127) / 255;
+
+	  if(r6 == g6 && g6 == b6)
 	    {
-	      if(bg == COLOR_WHITE)
-		return COLOR_BLACK * colors + COLOR_WHITE;
-	      else
-		return COLOR_WHITE * colors + bg;
+	      const int gray = (r + g + b) / 3;
+	      if(gray >= 8 && gray <= 238)
+		return 232 + (gray - 8) / 10;
 	    }
-	  else
-	    return fg * colors + bg;
+
+	  return 16 + 36 * r6 + 6 * g6 + b6;
 	}
+      else
+	return (r > 127 ? COLOR_RED : 0) |
+	  (g > 127 ? COLOR_GREEN : 0) |
+	  (b > 127 ? COLOR_BLUE : 0);
     }
 
-    int mix_color(short color, short fg, short bg)
+    int get_color_pair(int fg, int bg)
+    {
+      if(!colors_avail)
+	return 0;
+
+      // Fall back to the default color if the user asked for too
+      // much.
+      if(fg >= colors)
+	fg = 0;
+
+      if(bg >= colors)
+	bg = 0;
+
+      if(bg == -1 && !default_colors_avail)
+	bg = 0;
+
+      eassert(fg >= 0 && bg >= -1);
+
+      // The caller applies A_INVIS to text whose foreground and
+      // background match, so pick an arbitrary visible foreground
+      // and share its pair.
+      if(fg == bg)
+	fg = (bg == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+
+      threads::mutex::lock l(get_pairs_mutex());
+
+      const int pair = lookup_pair(fg, bg);
+      if(pair == 0)
+	return allocate_pair(fg, bg);
+      else
+	return pair;
+    }
+
+    int mix_color(attr_t color, int fg, int bg)
     {
       if(!colors_avail)
 	return 0;
       else if(fg == -1 && bg == -2)
 	return color & A_COLOR;
+      else if(bg == -1 && !default_colors_avail)
+	return 0;
+      else if(fg != -1 && bg != -2)
+	return COLOR_PAIR(get_color_pair(fg, bg));
       else
 	{
-	  short old_fg = PAIR_NUMBER(color) / colors;
-	  short old_bg = PAIR_NUMBER(color) % colors;
+	  int old_fg = 0, old_bg = default_colors_avail ? -1 : 0;
 
-	  if(old_fg == old_bg && default_colors_avail)
-	    old_bg = -1;
+	  {
+	    threads::mutex::lock l(get_pairs_mutex());
+
+	    const int old_pair = PAIR_NUMBER(color);
+	    if(old_pair > 0 && old_pair < next_unused_pair)
+	      {
+		old_fg = pairs[old_pair].fg;
+		old_bg = pairs[old_pair].bg;
+	      }
+	  }
 
-	  if(bg == -1 && !default_colors_avail)
-	    return 0;
-	  else if(fg == -1)
+	  if(fg == -1)
 	    return COLOR_PAIR(get_color_pair(old_fg, bg));
-	  else if(bg == -2)
-	    return COLOR_PAIR(get_color_pair(fg, old_bg));
 	  else
-	    return COLOR_PAIR(get_color_pair(fg, bg));
+	    return COLOR_PAIR(get_color_pair(fg, old_bg));
 	}
     }
   }
@@ -18,25 +18,27 @@
 //  Boston, MA 02111-1307, USA.
 //
 //  Manages color allocation so as to allow any combination of
-//  foreground/background colors to be used.  If there aren't enough
-//  color pairs available to handle all color combinations, this will
-//  act as though no colors are available.  NOTE: colors whose
-//  foreground and background are the same will be reduced to an
-//  arbitrary color of that background; it is expected that the caller
-//  will apply A_INVIS to such colors.  This is done to conserve color
-//  pairs so as to allow the use of the 'default' color.
+//  foreground/background colors to be used.  Color pairs are defined
+//  the first time a combination is used; once the terminal runs out of
+//  pairs, new combinations share the closest pair that is already
+//  defined.  NOTE: colors whose foreground and background are the
+//  same will be reduced to an arbitrary color of that background; it
+//  is expected that the caller will apply A_INVIS to such colors.
+//  This is done to conserve color pairs.
 
 #ifndef COLORS_H
 #define COLORS_H
 
+#include <ncursesw/curses.h>
+
 /** \file colors.h
  *
  *  \brief Routines to support independently changing foreground and
  *  background colors.
  *
- *  cwidget can only support colors on terminals that allow at least
- *  64 color pairs to be defined.  However, on those terminals, it can
- *  mix foreground and background colors independently of one another.
+ *  cwidget supports colors on any terminal with at least 8 colors,
+ *  including 256-color and direct-color (RGB) terminals, and mixes
+ *  foreground and background colors independently of one another.
  *  Normally colors are accessed through the style system (see
  *  style.h).
  */
@@ -59,8 +61,43 @@ namespace cwidget
      */
     void init_colors();
 
-    /** \return a color pair for the given foreground and background. */
-    int get_color_pair(short fg, short bg);
+    /** Set up the colors for a terminal with the given number of
+     *  colors and color pairs, instead of asking curses about the
+     *  current one.  Pairs are still defined in curses as they are
+     *  allocated.  Used to test the pair allocator without a
+     *  terminal; passing 0 colors turns colors off again.
+     *
+     *  \param num_colors the number of colors; more than 256 colors
+     *  are treated as a direct-color (RGB) palette.
+     *  \param max_pairs the number of color pairs, including pair 0.
+     */
+    void init_colors(int num_colors, int max_pairs);
+
+    /** \return a number that changes whenever the mapping from
+     *  colors to color pairs is reset by init_colors(), so that
+     *  callers that remember the results of mix_color() know when to
+     *  throw them away.  This does not lock anything, so it is cheap
+     *  enough to check on every use.
+     */
+    int get_color_generation();
+
+    /** \return the number of colors that can be used in styles, or 0
+     *  if colors are not available.
+     */
+    int get_num_colors();
+
+    /** \return the color that best matches the given red, green and
+     *  blue levels: the exact color on a direct-color terminal, the
+     *  closest entry of the xterm palette on a 256-color terminal, or
+     *  the closest basic color otherwise.  Only meaningful after
+     *  init_colors() has been called.
+     */
+    int rgb_color(unsigned char r, unsigned char g, unsigned char b);
+
+    /** \return a color pair for the given foreground and background,
+     *  defining it if necessary.
+     */
+    int get_color_pair(int fg, int bg);
 
     /** \param color attributes containing the starting color value
      *  \param fg the new foreground (-1 to use color)
@@ -69,7 +106,7 @@ namespace cwidget
      *  \return a color pair created by mixing the given foreground
      *  and background into color.
      */
-    int mix_color(short color, short fg, short bg);
+    int mix_color(attr_t color, int fg, int bg);
   }
 }
 
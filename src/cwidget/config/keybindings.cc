@@ -71,6 +71,8 @@ namespace cwidget
 
       // Keys that are to be treated as identical to one another.
       std::map<key, int> key_equivalence_classes;
+      // The first key of each equivalence class, indexed by class.
+      std::map<int, key> key_equivalence_class_representatives;
       void init_equivalence_classes()
       {
 	if(equivalence_classes_initialized)
@@ -83,6 +85,7 @@ namespace cwidget
 	keys.push_back(key(L'\n', false));
 
 	make_equivalence_class(key_equivalence_classes, keys);
+	key_equivalence_class_representatives[key_equivalence_classes[keys.front()]] = keys.front();
 
 	keys.clear();
 	keys.push_back(key(KEY_BACKSPACE, true));
@@ -92,6 +95,7 @@ namespace cwidget
 					 // in some terminals.
 
 	make_equivalence_class(key_equivalence_classes, keys);
+	key_equivalence_class_representatives[key_equivalence_classes[keys.front()]] = keys.front();
 	equivalence_classes_initialized = true;
       }
     }
@@ -314,44 +318,261 @@ namespace cwidget
       }
     };
 
+    namespace
+    {
+      /** Incremented whenever a binding in any scope changes. */
+      int bindings_generation = 0;
+
+      /** Function names as passed to get_action_id(), mapped to
+       *  their IDs.
+       */
+      std::map<string, action_id> &get_action_aliases()
+      {
+	static std::map<string, action_id> aliases;
+	return aliases;
+      }
+
+      /** Upper-cased function names mapped to their IDs. */
+      std::map<string, action_id> &get_action_ids()
+      {
+	static std::map<string, action_id> ids;
+	return ids;
+      }
+
+      /** \return the key that stands for k's equivalence class. */
+      key canonical_key(const key &k)
+      {
+	std::map<key, int>::const_iterator found =
+	  key_equivalence_classes.find(k);
+
+	if(found == key_equivalence_classes.end())
+	  return k;
+	else
+	  return key_equivalence_class_representatives[found->second];
+      }
+    }
+
+    action_id get_action_id(const string &tag)
+    {
+      std::map<string, action_id> &aliases(get_action_aliases());
+      std::map<string, action_id>::const_iterator found = aliases.find(tag);
+
+      if(found != aliases.end())
+	return found->second;
+
+      string realtag(tag);
+      transform(realtag.begin(), realtag.end(),
+		realtag.begin(), toupper_struct());
+
+      std::map<string, action_id> &ids(get_action_ids());
+      std::map<string, action_id>::const_iterator found_id = ids.find(realtag);
+
+      action_id rval;
+      if(found_id != ids.end())
+	rval = found_id->second;
+      else
+	{
+	  rval = ids.size();
+	  ids[realtag] = rval;
+	}
+
+      aliases[tag] = rval;
+      return rval;
+    }
+
+    namespace
+    {
+      /** The first code used for the keys that stand for sequences;
+       *  well outside both Unicode and the curses function keys.
+       */
+      const wint_t sequence_key_base = 0x40000000;
+
+      struct sequence_entry
+      {
+	/** The sequence, as canonical keys. */
+	key_sequence seq;
+
+	sequence_entry(const key_sequence &_seq)
+	  : seq(_seq)
+	{
+	}
+      };
+
+      /** Every sequence that has been bound, and the number of the
+       *  key that stands for it.
+       */
+      struct sequence_registry
+      {
+	std::vector<sequence_entry> entries;
+	std::map<key_sequence, int> indices;
+      };
+
+      sequence_registry &get_sequence_registry()
+      {
+	static sequence_registry *registry = new sequence_registry;
+	return *registry;
+      }
+
+      /** \return the key standing for the given sequence. */
+      key intern_sequence(const key_sequence &seq)
+      {
+	init_equivalence_classes();
+
+	key_sequence canonical;
+	for(key_sequence::const_iterator it = seq.begin(); it != seq.end(); ++it)
+	  canonical.push_back(canonical_key(*it));
+
+	sequence_registry &registry(get_sequence_registry());
+	std::map<key_sequence, int>::const_iterator found =
+	  registry.indices.find(canonical);
+
+	int index;
+	if(found != registry.indices.end())
+	  index = found->second;
+	else
+	  {
+	    index = registry.entries.size();
+	    registry.entries.push_back(sequence_entry(canonical));
+	    registry.indices[canonical] = index;
+	  }
+
+	return key(sequence_key_base + index, true);
+      }
+
+      bool is_sequence_key(const key &k)
+      {
+	return k.function_key && k.ch >= sequence_key_base &&
+	  k.ch - sequence_key_base < get_sequence_registry().entries.size();
+      }
+
+    }
+
+    std::vector<key_sequence> keybindings::get_sequences(const string &tag) const
+    {
+      string realtag(tag);
+      transform(realtag.begin(), realtag.end(),
+		realtag.begin(), toupper_struct());
+
+      std::map<string, std::vector<key_sequence> >::const_iterator found =
+	seqmap.find(realtag);
+
+      if(found == seqmap.end())
+	return std::vector<key_sequence>();
+      else
+	return found->second;
+    }
+
+    void keybindings::set_sequences(string tag, const std::vector<key_sequence> &sequences)
+    {
+      transform(tag.begin(), tag.end(),
+		tag.begin(), toupper_struct());
+
+      seqmap[tag] = sequences;
+      ++bindings_generation;
+    }
+
     void keybindings::set(string tag, keybinding strokes)
     {
       transform(tag.begin(), tag.end(),
 		tag.begin(), toupper_struct());
 
       keymap[tag]=strokes;
+      ++bindings_generation;
     }
 
-    bool keybindings::key_matches(const key &k, string tag) const
+    void keybindings::update_actions() const
     {
+      if(actions_generation == bindings_generation)
+	return;
+
       init_equivalence_classes();
-      transform(tag.begin(), tag.end(),
-		tag.begin(), toupper_struct());
 
-      auto it = keymap.find(tag);
-      if(it == keymap.end())
-	return parent ? parent->key_matches(k, tag) : false;
-      else
+      actions.clear();
+      sequences.clear();
+      last_actions = NULL;
+
+      // Bindings in this scope hide the bindings of the same function
+      // in the parent scopes.
+      std::map<string, const keybindings *> effective;
+      for(const keybindings *scope = this; scope != NULL; scope = scope->parent)
 	{
-	  auto k_eq_class = key_equivalence_classes.find(k);
+	  for(std::map<string, keybinding>::const_iterator it = scope->keymap.begin();
+	      it != scope->keymap.end(); ++it)
+	    effective.insert(std::make_pair(it->first, scope));
+	  for(std::map<string, std::vector<key_sequence> >::const_iterator it = scope->seqmap.begin();
+	      it != scope->seqmap.end(); ++it)
+	    effective.insert(std::make_pair(it->first, scope));
+	}
 
-	  for(keybinding::const_iterator i = it->second.begin(); i != it->second.end(); i++)
+      for(std::map<string, const keybindings *>::const_iterator it = effective.begin();
+	  it != effective.end(); ++it)
+	{
+	  const action_id action = get_action_id(it->first);
+
+	  keybinding strokes;
+
+	  std::map<string, keybinding>::const_iterator found_keys =
+	    it->second->keymap.find(it->first);
+	  if(found_keys != it->second->keymap.end())
+	    strokes = found_keys->second;
+
+	  std::map<string, std::vector<key_sequence> >::const_iterator found_seqs =
+	    it->second->seqmap.find(it->first);
+	  if(found_seqs != it->second->seqmap.end())
+	    for(std::vector<key_sequence>::const_iterator s = found_seqs->second.begin();
+		s != found_seqs->second.end(); ++s)
+	      {
+		if(s->size() == 1)
+		  strokes.push_back(s->front());
+		else if(s->size() > 1)
+		  {
+		    const key seq_key = intern_sequence(*s);
+		    strokes.push_back(seq_key);
+		    sequences.push_back(get_key_sequence(seq_key));
+		  }
+	      }
+
+	  for(keybinding::const_iterator k = strokes.begin();
+	      k != strokes.end(); ++k)
 	    {
-	      if(k_eq_class != key_equivalence_classes.end())
-		{
-		  std::map<key, int>::const_iterator i_eq_class(key_equivalence_classes.find(*i));
-		  if(i_eq_class != key_equivalence_classes.end() &&
-		     k_eq_class->second == i_eq_class->second)
-		    {
-		      return true;
-		    }
-		}
-
-	      if(k==*i)
-		return true;
+	      std::vector<action_id> &bound(actions[canonical_key(*k)]);
+	      if(std::find(bound.begin(), bound.end(), action) == bound.end())
+		bound.push_back(action);
 	    }
-	  return false;
 	}
+
+      actions_generation = bindings_generation;
+    }
+
+    const std::vector<key_sequence> &keybindings::get_bound_sequences() const
+    {
+      update_actions();
+
+      return sequences;
+    }
+
+    const std::vector<action_id> &keybindings::get_actions(const key &k) const
+    {
+      static const std::vector<action_id> no_actions;
+
+      update_actions();
+
+      if(last_actions != NULL && last_key == k)
+	return *last_actions;
+
+      action_table::const_iterator found = actions.find(canonical_key(k));
+
+      last_key = k;
+      last_actions = (found == actions.end()) ? &no_actions : &found->second;
+
+      return *last_actions;
+    }
+
+    bool keybindings::key_matches(const key &k, action_id action) const
+    {
+      const std::vector<action_id> &bound(get_actions(k));
+
+      return std::find(bound.begin(), bound.end(), action) != bound.end();
     }
 
     key parse_key(const wstring &keystr)
@@ -421,10 +642,69 @@ namespace cwidget
 	}
     }
 
+    key_sequence parse_key_sequence(const wstring &seqstr)
+    {
+      key_sequence rval;
+
+      wstring::size_type start = seqstr.find_first_not_of(L" \t");
+      while(start != wstring::npos)
+	{
+	  wstring::size_type end = seqstr.find_first_of(L" \t", start);
+	  const key k = parse_key(seqstr.substr(start, end == wstring::npos ? wstring::npos : end - start));
+
+	  if(k.ch == (wint_t) ERR)
+	    return key_sequence();
+
+	  rval.push_back(k);
+	  start = end == wstring::npos ? end : seqstr.find_first_not_of(L" \t", end);
+	}
+
+      return rval;
+    }
+
+    wstring keyname(const key_sequence &seq)
+    {
+      wstring rval;
+
+      for(key_sequence::const_iterator it = seq.begin(); it != seq.end(); ++it)
+	{
+	  if(it != seq.begin())
+	    rval += L' ';
+	  rval += keyname(*it);
+	}
+
+      return rval;
+    }
+
+    wstring readable_keyname(const key_sequence &seq)
+    {
+      wstring rval;
+
+      for(key_sequence::const_iterator it = seq.begin(); it != seq.end(); ++it)
+	{
+	  if(it != seq.begin())
+	    rval += L' ';
+	  rval += readable_keyname(*it);
+	}
+
+      return rval;
+    }
+
+    key_sequence get_key_sequence(const key &k)
+    {
+      if(is_sequence_key(k))
+	return get_sequence_registry().entries[k.ch - sequence_key_base].seq;
+      else
+	return key_sequence();
+    }
+
     wstring keyname(const key &k)
     {
       init_key_tables();
 
+      if(is_sequence_key(k))
+	return keyname(get_sequence_registry().entries[k.ch - sequence_key_base].seq);
+
       // This is a nasty special-case..all of this stuff is nasty special-cases..
       // someday I need to learn the underlying logic, if there is any..
       if(k.ch==31 && k.function_key)
@@ -457,6 +737,8 @@ namespace cwidget
     {
       if(k == key(L',', false))
 	return L",";
+      else if(is_sequence_key(k))
+	return readable_keyname(get_sequence_registry().entries[k.ch - sequence_key_base].seq);
       else
 	return keyname(k);
     }
@@ -472,6 +754,11 @@ namespace cwidget
 
       if (it != keymap.end())
 	return config::keyname(it->second.front());
+
+      auto seq_it = seqmap.find(realtag);
+
+      if (seq_it != seqmap.end() && !seq_it->second.empty())
+	return config::keyname(seq_it->second.front());
       else
 	return L"";
     }
@@ -486,8 +773,157 @@ namespace cwidget
 
       if (it != keymap.end())
 	return config::readable_keyname(it->second.front());
+
+      auto seq_it = seqmap.find(realtag);
+
+      if (seq_it != seqmap.end() && !seq_it->second.empty())
+	return config::readable_keyname(seq_it->second.front());
       else
 	return L"";
     }
+
+    key_sequence_matcher::key_sequence_matcher()
+      : trie_generation(-1), node(0), complete_node(0), complete_length(0)
+    {
+    }
+
+    void key_sequence_matcher::reset()
+    {
+      node = 0;
+      pending.clear();
+      complete_node = 0;
+      complete_length = 0;
+    }
+
+    void key_sequence_matcher::set_scopes(const std::vector<const keybindings *> &new_scopes)
+    {
+      if(new_scopes != scopes)
+	{
+	  scopes = new_scopes;
+	  trie_generation = -1;
+	}
+    }
+
+    void key_sequence_matcher::update_trie(std::vector<matched_key> &output)
+    {
+      if(trie_generation == bindings_generation)
+	return;
+
+      init_equivalence_classes();
+
+      trie.clear();
+      trie.push_back(trie_node());
+
+      for(std::vector<const keybindings *>::const_iterator scope = scopes.begin();
+	  scope != scopes.end(); ++scope)
+	{
+	  const std::vector<key_sequence> &bound((*scope)->get_bound_sequences());
+
+	  for(std::vector<key_sequence>::const_iterator seq = bound.begin();
+	      seq != bound.end(); ++seq)
+	    {
+	      int n = 0;
+	      for(key_sequence::const_iterator it = seq->begin();
+		  it != seq->end(); ++it)
+		{
+		  std::unordered_map<key, int, key_hash>::const_iterator found =
+		    trie[n].children.find(*it);
+
+		  if(found != trie[n].children.end())
+		    n = found->second;
+		  else
+		    {
+		      const int child = trie.size();
+		      trie.push_back(trie_node());
+		      trie[n].children[*it] = child;
+		      n = child;
+		    }
+		}
+
+	      trie[n].terminal = true;
+	      trie[n].sequence_key = intern_sequence(*seq);
+	    }
+	}
+
+      trie_generation = bindings_generation;
+
+      // The saved node numbers are meaningless now; start over with
+      // the pending keys.
+      key_sequence old_pending;
+      old_pending.swap(pending);
+      reset();
+
+      for(key_sequence::const_iterator it = old_pending.begin();
+	  it != old_pending.end(); ++it)
+	do_feed(*it, output);
+    }
+
+    void key_sequence_matcher::feed(const key &k, std::vector<matched_key> &output)
+    {
+      update_trie(output);
+      do_feed(k, output);
+    }
+
+    void key_sequence_matcher::do_feed(const key &k, std::vector<matched_key> &output)
+    {
+      std::unordered_map<key, int, key_hash>::const_iterator found =
+	trie[node].children.find(canonical_key(k));
+
+      if(found == trie[node].children.end())
+	{
+	  if(pending.empty())
+	    output.push_back(matched_key(k));
+	  else
+	    {
+	      flush(output);
+	      do_feed(k, output);
+	    }
+
+	  return;
+	}
+
+      node = found->second;
+      pending.push_back(k);
+
+      if(trie[node].terminal)
+	{
+	  complete_node = node;
+	  complete_length = pending.size();
+	}
+
+      if(trie[node].children.empty())
+	{
+	  output.push_back(matched_key(trie[node].sequence_key, pending));
+	  reset();
+	}
+    }
+
+    void key_sequence_matcher::flush(std::vector<matched_key> &output)
+    {
+      update_trie(output);
+
+      if(pending.empty())
+	return;
+
+      key_sequence rest;
+
+      if(complete_length > 0)
+	{
+	  output.push_back(matched_key(trie[complete_node].sequence_key,
+				       key_sequence(pending.begin(),
+						    pending.begin() + complete_length)));
+	  rest.assign(pending.begin() + complete_length, pending.end());
+	}
+      else
+	{
+	  output.push_back(matched_key(pending.front()));
+	  rest.assign(pending.begin() + 1, pending.end());
+	}
+
+      reset();
+
+      for(key_sequence::const_iterator it = rest.begin(); it != rest.end(); ++it)
+	do_feed(*it, output);
+    }
   }
 }
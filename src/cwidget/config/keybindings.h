@@ -22,6 +22,7 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <cwidget/curses++.h>
@@ -70,9 +71,37 @@ namespace cwidget
       }
     };
 
+    /** \brief Hashes keys, so that they can be used in unordered maps. */
+    struct key_hash
+    {
+      size_t operator()(const key &k) const
+      {
+	return k.ch * 2 + (k.function_key ? 1 : 0);
+      }
+    };
+
     /** \brief The type used to store the keybindings of a function. */
     typedef std::vector<key> keybinding;
 
+    /** \brief A series of keystrokes that is bound as a unit, such as
+     *  "C-x C-s".
+     */
+    typedef std::vector<key> key_sequence;
+
+    /** \brief An integer that identifies a bindable function.
+     *
+     *  Testing a key against a function name means normalizing the
+     *  name and searching for it; code that tests the same functions
+     *  on every keystroke should look their IDs up once with
+     *  get_action_id() and pass those to keybindings::key_matches().
+     */
+    typedef int action_id;
+
+    /** \return the ID of the function with the given name.  Names are
+     *  case-insensitive, and the same name always has the same ID.
+     */
+    action_id get_action_id(const std::string &tag);
+
     /** \brief Stores the keys bound to various functions.
      *
      *  Functions are simply arbitrary strings chosen by the user of
@@ -88,8 +117,41 @@ namespace cwidget
     {
       std::map<std::string, keybinding> keymap;
 
+      /** The multi-key sequences bound to each function. */
+      std::map<std::string, std::vector<key_sequence> > seqmap;
+
       keybindings *parent;
 
+      typedef std::unordered_map<key, std::vector<action_id>, key_hash> action_table;
+
+      /** Maps each key (or the first member of its equivalence class)
+       *  to the functions that it triggers in this scope, taking
+       *  inherited bindings into account.  Built on demand and thrown
+       *  away whenever any scope is modified.
+       */
+      mutable action_table actions;
+
+      /** The value of the global bindings generation when actions
+       *  was built, or -1 if it has never been built.
+       */
+      mutable int actions_generation;
+
+      /** The multi-key sequences bound in this scope, taking
+       *  inherited bindings into account, as canonical keys.  Built
+       *  along with actions.
+       */
+      mutable std::vector<key_sequence> sequences;
+
+      /** The result of the most recent lookup in actions, so that
+       *  testing one keystroke against many functions only searches
+       *  the table once.
+       */
+      mutable key last_key;
+      mutable const std::vector<action_id> *last_actions;
+
+      /** Rebuild actions if any scope changed since it was built. */
+      void update_actions() const;
+
       // It's way too easy to accidentally invoke the automatic copy
       // constructor instead of the real one.
       keybindings(const keybindings &_parent);
@@ -98,7 +160,10 @@ namespace cwidget
        *
        *  \param _parent   The parent of this scope, if any, or NULL for no parent.
        */
-      keybindings(keybindings *_parent = nullptr) : parent(_parent) {}
+      keybindings(keybindings *_parent = nullptr)
+	: parent(_parent), actions_generation(-1), last_actions(NULL)
+      {
+      }
 
       /** \return the first binding of the given function, in a format
        *  that can be passed to parse_key().
@@ -153,6 +218,55 @@ namespace cwidget
 	set(tag, strokes);
       }
 
+      /** \brief Retrieve the key sequences bound to the given function
+       *  in this scope.
+       */
+      std::vector<key_sequence> get_sequences(const std::string &tag) const;
+
+      /** \brief Bind key sequences to a function in this scope.
+       *
+       *  \param tag        The name of the function to be bound.
+       *  \param sequences  The key sequences to bind to the function.
+       *
+       *  This routine throws away any previous sequences bound to the
+       *  given function and replaces them with sequences; the
+       *  single-key bindings made with set() are not affected.  A
+       *  function that is bound in a scope, either to keys or to
+       *  sequences, hides both kinds of bindings of that function in
+       *  the parent scopes.
+       *
+       *  When a sequence is typed, the function is triggered by the
+       *  key returned from key_sequence_matcher once the last key of
+       *  the sequence arrives.
+       */
+      void set_sequences(std::string tag, const std::vector<key_sequence> &sequences);
+
+      /** \return the multi-key sequences that trigger a function in
+       *  this scope, including those inherited from the parent
+       *  scopes.  The reference is valid until a binding in any scope
+       *  is modified.
+       */
+      const std::vector<key_sequence> &get_bound_sequences() const;
+
+      /** \brief Retrieve the functions triggered by a key.
+       *
+       *  \param k  The key to look up.
+       *
+       *  \return the IDs of the functions bound to k in this scope, in
+       *  no particular order.  The reference is valid until a binding
+       *  in any scope is modified.
+       */
+      const std::vector<action_id> &get_actions(const key &k) const;
+
+      /** \brief Test whether a key is bound to a function.
+       *
+       *  \param k      The key to test.
+       *  \param action The ID of the function to test against.
+       *
+       *  \return \b true if k is bound to action in this scope.
+       */
+      bool key_matches(const key &k, action_id action) const;
+
       /** \brief Test whether a key is bound to a function.
        *
        *  \param k   The key to test.
@@ -160,7 +274,10 @@ namespace cwidget
        *
        *  \return \b true if k is bound to tag in this scope.
        */
-      bool key_matches(const key &k, std::string tag) const;
+      bool key_matches(const key &k, const std::string &tag) const
+      {
+	return key_matches(k, get_action_id(tag));
+      }
     };
 
     /** \brief Parse a keystroke definition.
@@ -190,6 +307,156 @@ namespace cwidget
      */
     std::wstring readable_keyname(const key &k);
 
+    /** \brief Parse a key sequence definition.
+     *
+     *  \param seqstr  The keys of the sequence, as accepted by
+     *  parse_key(), separated by whitespace.
+     *
+     *  \return the corresponding sequence, or an empty sequence if the
+     *  parse fails.
+     */
+    key_sequence parse_key_sequence(const std::wstring &seqstr);
+
+    /** \brief Convert a key sequence to its string definition.
+     *
+     *  \return a string that, when passed to parse_key_sequence(),
+     *  will return #seq.
+     */
+    std::wstring keyname(const key_sequence &seq);
+
+    /** \brief Convert a key sequence to a human-readable name. */
+    std::wstring readable_keyname(const key_sequence &seq);
+
+    /** \return the sequence that the given key stands for, as
+     *  canonical keys, or an empty sequence if it is an ordinary key.
+     */
+    key_sequence get_key_sequence(const key &k);
+
+    /** \brief A keystroke produced by key_sequence_matcher. */
+    struct matched_key
+    {
+      /** The key to dispatch: a key that was read, or the key that
+       *  stands for a completed sequence.
+       */
+      key k;
+
+      /** If k stands for a sequence, the keys that were read to type
+       *  it; otherwise empty.  If nothing handles k, these should be
+       *  dispatched instead, so that no input is lost.
+       */
+      key_sequence typed;
+
+      matched_key(const key &_k)
+	:k(_k)
+      {
+      }
+
+      matched_key(const key &_k, const key_sequence &_typed)
+	:k(_k), typed(_typed)
+      {
+      }
+    };
+
+    /** \brief Splits the keys read from the terminal into keystrokes
+     *  and completed key sequences.
+     *
+     *  Only the sequences bound in the scopes passed to set_scopes()
+     *  are matched; normally these are the scopes of the widgets
+     *  that currently receive keys.  They are stored in a trie.
+     *  Keys that cannot start a sequence are passed through
+     *  immediately; other keys are held back until they either
+     *  complete a sequence, in which case a single key standing for
+     *  the whole sequence is produced, or turn out not to, in which
+     *  case they are released as ordinary keystrokes.  When one bound
+     *  sequence is a prefix of another, or a key both starts a
+     *  sequence and is bound on its own, the matcher cannot decide
+     *  until more input arrives; the caller should call flush() if
+     *  nothing arrives within a reasonable time.
+     *
+     *  The keys standing for sequences can be passed to
+     *  keybindings::key_matches() like any other key.
+     */
+    class key_sequence_matcher
+    {
+      struct trie_node
+      {
+	std::unordered_map<key, int, key_hash> children;
+
+	/** If this node ends a bound sequence, the key standing for
+	 *  that sequence.
+	 */
+	key sequence_key;
+	bool terminal;
+
+	trie_node() : terminal(false)
+	{
+	}
+      };
+
+      /** The scopes whose sequences are matched. */
+      std::vector<const keybindings *> scopes;
+
+      /** The sequences bound in scopes; node 0 is the root. */
+      std::vector<trie_node> trie;
+
+      /** The bindings generation that trie was built for, or -1 if
+       *  it is out of date.
+       */
+      int trie_generation;
+
+      /** The trie node reached by the pending keys; 0 (the root) if
+       *  nothing is pending.
+       */
+      int node;
+
+      /** The keys that have been held back. */
+      key_sequence pending;
+
+      /** The node of the longest bound sequence that is a prefix of
+       *  pending, and the length of that sequence (0 if there is
+       *  none).
+       */
+      int complete_node;
+      key_sequence::size_type complete_length;
+
+      void reset();
+
+      /** Rebuild the trie if the scopes or any binding changed, and
+       *  match the pending keys against the new trie.
+       */
+      void update_trie(std::vector<matched_key> &output);
+
+      /** Process a key, assuming that the trie is up to date. */
+      void do_feed(const key &k, std::vector<matched_key> &output);
+    public:
+      key_sequence_matcher();
+
+      /** \brief Choose the scopes whose sequences are matched.
+       *
+       *  Keys that are being held back are matched against the new
+       *  scopes when the next key is fed or flush() is called.
+       */
+      void set_scopes(const std::vector<const keybindings *> &scopes);
+
+      /** \brief Process a key read from the terminal.
+       *
+       *  \param k       The key that was read.
+       *  \param output  A vector to which the keystrokes that are
+       *                 ready to be dispatched are appended.
+       */
+      void feed(const key &k, std::vector<matched_key> &output);
+
+      /** \brief Stop waiting for the rest of a sequence.
+       *
+       *  The longest complete sequence among the pending keys (if
+       *  any) is output, and the remaining keys are processed again.
+       */
+      void flush(std::vector<matched_key> &output);
+
+      /** \return \b true if keys are being held back. */
+      bool is_pending() const { return !pending.empty(); }
+    };
+
     /** \brief The global keybindings object.
      *
      *  This object is the root of the keybindings hierarchy; normally
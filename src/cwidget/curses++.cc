@@ -21,6 +21,7 @@
 //  A few initialization routines and so on.
 
 #include "curses++.h"
+#include "fragment_contents.h"
 #include "style.h"
 
 #include <stdarg.h>
@@ -61,8 +62,10 @@ namespace cwidget
 
   void chstring::apply_style(const style &st)
   {
+    style_applier apply(st);
+
     for(iterator i=begin(); i!=end(); ++i)
-      *i=st.apply_to(*i);
+      *i=(*i & A_CHARTEXT) | apply(*i & ~A_CHARTEXT);
   }
 
   wchstring::wchstring(const wstring &s)
@@ -88,8 +91,10 @@ namespace cwidget
 
   void wchstring::apply_style(const style &st)
   {
+    style_applier apply(st);
+
     for(iterator i=begin(); i!=end(); ++i)
-      *i=st.apply_to(*i);
+      i->attrs=apply(i->attrs);
   }
 
   int wchstring::width() const
@@ -262,6 +267,41 @@ namespace cwidget
       }
   }
 
+  int cwindow::move_derived(int h, int w, int y, int x)
+  {
+    if(master->parent == NULL)
+      return ERR;
+
+    WINDOW *parent = master->parent->win;
+
+    int oldy, oldx;
+    getparyx(oldy, oldx);
+
+    if(y != oldy || x != oldx)
+      {
+	// The window has to fit in the parent at every step, so
+	// shrink it to fit both the old and the new location, move
+	// it, and only then grow it.
+	if(wresize(win, min(h, getmaxy()), min(w, getmaxx())) == ERR)
+	  return ERR;
+
+	if(::mvderwin(win, y, x) == ERR)
+	  return ERR;
+
+	// mvderwin() only moves the window within its parent; the
+	// position on the screen has to be updated separately.
+	int begy, begx;
+	_getbegyx(parent, begy, begx);
+	if(::mvwin(win, begy + y, begx + x) == ERR)
+	  return ERR;
+      }
+
+    if(h != getmaxy() || w != getmaxx())
+      return wresize(win, h, w);
+    else
+      return OK;
+  }
+
   int cwindow::printw(char *str, ...)
   {
     va_list args;
@@ -368,37 +408,44 @@ namespace cwidget
     return addnstr(str, str.size());
   }
 
-  int cwindow::addnstr(const wchstring &str, size_t n)
+  // Output a single formatted cell to the given window.
+  static int add_cell(WINDOW *win, const wchtype &c)
   {
     int rval=OK;
 
-    for(string::size_type i=0; i<n && i<str.size(); ++i)
-      {
-	// Construct a cchar_t from the single character at the head of
-	// the string.  The weird intermediate single-character string
-	// exists to work around the vagueness of the setcchar
-	// semantics.
+    // Construct a cchar_t from the single character.  The weird
+    // intermediate single-character string exists to work around
+    // the vagueness of the setcchar semantics.
+    cchar_t wch;
+    wchar_t dummy[2];
 
+    dummy[0]=c.ch;
+    dummy[1]=L'\0';
 
-	cchar_t wch;
-	wchar_t dummy[2];
+    // How can I notify the user of errors?
+    if(setcchar(&wch, dummy, c.attrs,
+		PAIR_NUMBER(c.attrs), 0) == ERR)
+      {
+	rval=ERR;
+	static const style_handle error_style("Error");
+	attr_t a=error_style.get_interned().get_attrs();
+	if(setcchar(&wch, L"?", a, PAIR_NUMBER(a), 0) == ERR)
+	  return rval;
+      }
 
-	dummy[0]=str[i].ch;
-	dummy[1]=L'\0';
+    if(wadd_wch(win, &wch) == ERR)
+      rval=ERR;
 
-	// How can I notify the user of errors?
-	if(setcchar(&wch, dummy, str[i].attrs,
-		    PAIR_NUMBER(str[i].attrs), 0) == ERR)
-	  {
-	    rval=ERR;
-	    attr_t a=get_style("Error").get_attrs();
-	    if(setcchar(&wch, L"?", a, PAIR_NUMBER(a), 0) == ERR)
-	      continue;
-	  }
+    return rval;
+  }
 
-	if(wadd_wch(win, &wch) == ERR)
-	  rval=ERR;
-      }
+  int cwindow::addnstr(const wchstring &str, size_t n)
+  {
+    int rval=OK;
+
+    for(string::size_type i=0; i<n && i<str.size(); ++i)
+      if(add_cell(win, str[i]) == ERR)
+	rval=ERR;
 
     return rval;
   }
@@ -415,4 +462,33 @@ namespace cwidget
     else
       return addnstr(str, n);
   }
+
+  int cwindow::addstr(const fragment_line &str)
+  {
+    return addnstr(str, str.size());
+  }
+
+  int cwindow::addnstr(const fragment_line &str, size_t n)
+  {
+    int rval=OK;
+
+    for(size_t i=0; i<n && i<str.size(); ++i)
+      if(add_cell(win, str[i]) == ERR)
+	rval=ERR;
+
+    return rval;
+  }
+
+  int cwindow::mvaddstr(int y, int x, const fragment_line &str)
+  {
+    return mvaddnstr(y, x, str, str.size());
+  }
+
+  int cwindow::mvaddnstr(int y, int x, const fragment_line &str, size_t n)
+  {
+    if(move(y, x) == ERR)
+      return ERR;
+    else
+      return addnstr(str, n);
+  }
 }
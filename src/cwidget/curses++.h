@@ -160,6 +160,7 @@ namespace std {
 namespace cwidget
 {
   class style;
+  class fragment_line;
 
   /** A string class which stores attributes along with characters.
    *
@@ -440,6 +441,30 @@ namespace cwidget
       return cwindow(new_win, new cwindow_master(new_win, master));
     }
 
+    /** \return \b true if this window was created by calling
+     *  derwin() on other (or on a copy of other).
+     */
+    bool is_derived_from(const cwindow &other) const
+    {
+      return master->parent == other.master;
+    }
+
+    /** Move and resize a window that was created by derwin(),
+     *  without creating a new window.  The window must not have any
+     *  subwindows if it is moved, since they would keep pointing at
+     *  its old location.
+     *
+     *  \param h the new height
+     *  \param w the new width
+     *  \param y the new y location within the parent window
+     *  \param x the new x location within the parent window
+     *
+     *  \return ERR if the new location doesn't fit in the parent
+     *  window; in that case the window is left in an undefined state
+     *  and should be discarded.
+     */
+    int move_derived(int h, int w, int y, int x);
+
     int mvwin(int y, int x) {return ::mvwin(win, y, x);}
 
     void syncup() {wsyncup(win);}
@@ -504,6 +529,11 @@ namespace cwidget
     int mvaddstr(int y, int x, const wchstring &str);
     int mvaddnstr(int y, int x, const wchstring &str, size_t n);
 
+    int addstr(const fragment_line &str);
+    int addnstr(const fragment_line &str, size_t n);
+    int mvaddstr(int y, int x, const fragment_line &str);
+    int mvaddnstr(int y, int x, const fragment_line &str, size_t n);
+
     int addstr(const chstring &str) {return waddchstr(win, str.c_str());}
     int addnstr(const chstring &str, int n) {return waddchnstr(win, str.c_str(), n);}
     int mvaddstr(int y, int x, const chstring &str) {return mvwaddchstr(win, y, x, str.c_str());}
@@ -19,10 +19,13 @@
 //   Boston, MA 02111-1307, USA.
 
 #include "fragment.h"
+#include <cwidget/generic/util/ssprintf.h>
 #include <cwidget/generic/util/transcode.h>
 
 #include "config/colors.h"
 
+#include <cwidget/generic/threads/thread_pool.h>
+
 #include <cstdarg>
 
 #include <algorithm>
@@ -290,7 +293,7 @@ namespace cwidget
     {
       fragment_contents rval;
 
-      rval.push_back(fragment_line(L""));
+      rval.push_back(fragment_line());
 
       for(vector<fragment*>::const_iterator i=contents.begin();
 	  i!=contents.end(); ++i)
@@ -319,7 +322,7 @@ namespace cwidget
 	  if(lines.size()==0)
 	    {
 	      if(rval.get_final_nl() && lines.get_final_nl())
-		rval.push_back(fragment_line(L""));
+		rval.push_back(fragment_line());
 
 	      rval.set_final_nl(rval.get_final_nl() || lines.get_final_nl());
 	    }
@@ -561,7 +564,7 @@ namespace cwidget
 
 	  if(!output_something)
 	    {
-	      rval.push_back(fragment_line(L""));
+	      rval.push_back(fragment_line());
 	      firstw=restw;
 	    }
 
@@ -702,7 +705,7 @@ namespace cwidget
 
 		  // Now spit the words into an output string, filled
 		  // left and right.
-		  fragment_line final(L"");
+		  fragment_line final;
 
 		  // This is similar to the famous algorithm for drawing
 		  // a line.  The idea is to add diff/(words-1) spaces
@@ -738,7 +741,7 @@ namespace cwidget
 
 	  if(!output_something)
 	    {
-	      rval.push_back(fragment_line(L""));
+	      rval.push_back(fragment_line());
 	      firstw=restw;
 	    }
 	}
@@ -795,7 +798,7 @@ namespace cwidget
 	{
 	  if(i->empty())
 	    {
-	      rval.push_back(fragment_line(L""));
+	      rval.push_back(fragment_line());
 	      firstw=restw;
 	    }
 	  else
@@ -928,11 +931,7 @@ namespace cwidget
       if(restw<=restindent)
 	return fragment_contents();
 
-      fragment_line firstprepend(firstindent, L' ', st.get_attrs());
-      fragment_line restprepend(restindent, L' ', st.get_attrs());
-
-      firstprepend.apply_style(st);
-      restprepend.apply_style(st);
+      const wchtype indent_cell=st.apply_to(wchtype(L' ', st.get_attrs()));
 
       size_t child_firstw=firstw>=firstindent?firstw-firstindent:0;
       size_t child_restw=restw>=restindent?restw-restindent:0;
@@ -942,11 +941,8 @@ namespace cwidget
 						     st);
 
       for(fragment_contents::const_iterator i=lines.begin(); i!=lines.end(); ++i)
-	{
-	  fragment_line l=((i==lines.begin())?firstprepend:restprepend)+*i;
-
-	  rval.push_back(l);
-	}
+	rval.push_back(i->indented(i==lines.begin() ? firstindent : restindent,
+				   indent_cell));
 
       // Indentboxes are always followed by a final newline.
       rval.set_final_nl(true);
@@ -993,10 +989,48 @@ namespace cwidget
     return indentbox(0, indent, sequence_fragment(header, contents, NULL));
   }
 
+  /** Lays out every entry of a single column of a
+   *  _fragment_columns.  Each column is laid out by exactly one job,
+   *  so the fragments it touches (and their width caches) are never
+   *  shared between threads as long as no fragment appears in more
+   *  than one column.
+   */
+  class _column_layout_job : public threads::thread_pool::job
+  {
+    const fragment_column_entry &column;
+    size_t width;
+    const style &st;
+    vector<fragment_contents> &output;
+
+  public:
+    _column_layout_job(const fragment_column_entry &_column,
+		       size_t _width,
+		       const style &_st,
+		       vector<fragment_contents> &_output)
+      :column(_column), width(_width), st(_st), output(_output)
+    {
+    }
+
+    void run()
+    {
+      output.resize(column.lines.size());
+
+      for(size_t i = 0; i < column.lines.size(); ++i)
+	if(column.lines[i] != NULL)
+	  output[i] = column.lines[i]->layout(width, width, st);
+    }
+  };
+
   class _fragment_columns : public fragment_container
   {
     vector<fragment_column_entry> columns;
 
+    /** Tables with fewer laid-out entries than this are formatted in
+     *  the calling thread; handing them to the pool costs more than
+     *  it saves.
+     */
+    static const size_t min_parallel_entries = 32;
+
     void update_widths(vector<size_t> &widths,
 		       size_t w) const
     {
@@ -1144,23 +1178,68 @@ namespace cwidget
 	return NULL;
     }
 
-    // Build the kth line as a contents structure.
+    /** Lay out every entry of every column, storing the layout of
+     *  entry k of column i in entries[i][k].  When the table is large
+     *  enough, each column is formatted by a separate job on the
+     *  default thread pool; the result is the same either way.
+     */
+    void layout_entries(const vector<size_t> &widths,
+			const style &st,
+			vector<vector<fragment_contents> > &entries) const
+    {
+      entries.resize(columns.size());
+
+      size_t num_entries = 0;
+      for(vector<fragment_column_entry>::const_iterator
+	    it = columns.begin(); it != columns.end(); ++it)
+	for(std::vector<fragment *>::const_iterator line_it =
+	      it->lines.begin(); line_it != it->lines.end(); ++line_it)
+	  if(*line_it != NULL)
+	    ++num_entries;
+
+      vector<_column_layout_job> jobs;
+      jobs.reserve(columns.size());
+      for(size_t i = 0; i < columns.size(); ++i)
+	jobs.push_back(_column_layout_job(columns[i], widths[i], st,
+					  entries[i]));
+
+      threads::thread_pool &pool = threads::thread_pool::get_default();
+
+      if(columns.size() < 2 ||
+	 num_entries < min_parallel_entries ||
+	 pool.get_num_threads() == 0)
+	{
+	  for(vector<_column_layout_job>::iterator it = jobs.begin();
+	      it != jobs.end(); ++it)
+	    it->run();
+	}
+      else
+	{
+	  vector<threads::thread_pool::job *> job_ptrs;
+	  for(vector<_column_layout_job>::iterator it = jobs.begin();
+	      it != jobs.end(); ++it)
+	    job_ptrs.push_back(&*it);
+
+	  pool.run_all(job_ptrs);
+	}
+    }
+
+    // Build the kth line as a contents structure from the
+    // precomputed layouts of the column entries.
     //
     // Note: the interface is optimized for clarity; for efficiency we
     // would output directly to the final location instead of building a
     // temporary copy.
     fragment_contents make_line(size_t linenum,
 				const vector<size_t> &widths,
+				const vector<vector<fragment_contents> > &entries,
 				const style &st) const
     {
       vector<fragment_contents> child_layouts(columns.size());
 
       for(size_t i = 0; i < columns.size(); ++i)
-	{
-	  fragment *f = get_column_line(i, linenum);
-	  if(f != NULL)
-	    child_layouts[i]    = f->layout(widths[i], widths[i], st);
-	}
+	if(get_column_line(i, linenum) != NULL)
+	  child_layouts[i] = entries[i][linenum];
 
       // Figure out how to align the lines: find the height of this
       // table row and adjust positions accordingly.
@@ -1192,16 +1271,16 @@ namespace cwidget
       fragment_contents rval;
       for(size_t y = 0; y < height; ++y)
 	{
-	  fragment_line tmp(L"");
+	  fragment_line tmp;
 
 	  for(size_t i = 0; i < columns.size(); ++i)
 	    if(get_column_line(i, linenum) != NULL &&
 	       y >= starting_lines[i] &&
 	       y < starting_lines[i] + child_layouts[i].size())
 	      {
-		fragment_line &s = child_layouts[i][y - starting_lines[i]];
+		fragment_line s = child_layouts[i][y - starting_lines[i]];
 		if((unsigned)s.width() > widths[i])
-		  s.erase(widths[i], s.size());
+		  s = fragment_line(s, 0, min(widths[i], s.size()));
 		tmp += s;
 
 		if(widths[i] > (unsigned)s.width())
@@ -1232,13 +1311,16 @@ namespace cwidget
 	    it = columns.begin(); it != columns.end(); ++it)
 	num_lines = std::max(num_lines, it->lines.size());
 
+      vector<vector<fragment_contents> > entries;
+      layout_entries(widths, st, entries);
+
       fragment_contents rval;
       for(size_t i = 0; i < num_lines; ++i)
 	{
-	  fragment_contents curr = make_line(i, widths, st);
+	  fragment_contents curr = make_line(i, widths, entries, st);
 
 	  if(curr.size() == 0 && curr.get_final_nl())
-	    rval.push_back(fragment_line(L""));
+	    rval.push_back(fragment_line());
 	  else
 	    {
 	      for(fragment_contents::const_iterator curr_it = curr.begin();
@@ -1321,22 +1403,6 @@ namespace cwidget
     return new _fragment_columns(columns);
   }
 
-  struct argument
-  {
-    argument():format(0) {}
-
-    char format;
-    /** If \b true, the 'l' modifier was attached to this argument. */
-    bool islong:1;
-    union
-    {
-      fragment *F;
-      const char *s;
-      const wchar_t *ls;
-      int attr;
-    };
-  };
-
   // hack
   string char_to_str(char code)
   {
@@ -1355,98 +1421,129 @@ namespace cwidget
     return s;
   }
 
-  fragment *fragf(const char *format, ...)
+  fragf_arg::arg_type fragf_format::argument_spec::get_arg_type() const
+  {
+    switch(format)
+      {
+      case 'F':
+	return fragf_arg::fragment_arg;
+      case 's':
+	return islong ? fragf_arg::wstring_arg : fragf_arg::string_arg;
+      case 'S':
+	return fragf_arg::string_arg;
+      default:
+	return fragf_arg::no_arg;
+      }
+  }
+
+  fragf_format::fragf_format(const char *format)
   {
-    int argcount=0;
-    int posargcount=0;
+    parse(format);
+
+    if(!error.empty())
+      {
+	arguments.clear();
+	program.clear();
+      }
+  }
+
+  void fragf_format::add_argument(size_t argnum, char format, bool islong,
+				  const char *conflict_msg)
+  {
+    if(argnum >= arguments.size())
+      arguments.resize(argnum+1);
+
+    argument_spec &spec=arguments[argnum];
+
+    // if we saw it before it had better be the same type.
+    if(spec.format!=0 &&
+       (spec.format!=format || spec.islong!=islong))
+      error=conflict_msg;
+
+    spec.format=format;
+    spec.islong=islong;
+
+    instruction insn(instruction::insert_argument);
+    insn.argnum=argnum;
+    program.push_back(insn);
+  }
+
+  void fragf_format::parse(const char *format)
+  {
+    // Current argument for non-positional arguments.
+    size_t argcount=0;
+
+    // Literal text is collected here so that each run of text
+    // becomes a single instruction.
+    string curstr;
 
     const char *start=format;
-    // find all the arguments.
     const char *nextpercent=strchr(start, '%');
 
-    // loop 1: count the arguments.
-    while(nextpercent!= nullptr)
+    while(nextpercent!=nullptr && error.empty())
       {
-	if(*(nextpercent+1)=='l')
-	  ++nextpercent;
+	curstr+=string(start, nextpercent-start);
 
-	switch(*(nextpercent+1))
+	bool islong=false;
+	if(*(nextpercent+1)=='l')
 	  {
-	  case '0':
-	  case '1':
-	  case '2':
-	  case '3':
-	  case '4':
-	  case '5':
-	  case '6':
-	  case '7':
-	  case '8':
-	  case '9':
-	    {
-	      char *endptr;
-
-	      int pos=strtol(nextpercent+1, &endptr, 10);
+	    islong=true;
+	    ++nextpercent;
+	  }
 
-	      if(*endptr!='$' || (*(endptr+1)!='F' && *(endptr+1)!='s'))
-		{
-		  string s="Internal error: bad character in positional argument: '"+char_to_str(*endptr)+"'";
+	const char code=*(nextpercent+1);
 
-		  return text_fragment(s, get_style("Error"));
-		}
+	// This is almost always what we want; in the cases when it's not,
+	// I override it explicitly.
+	start=nextpercent+2;
 
-	      posargcount=max(posargcount, pos);
+	if(code=='%')
+	  {
+	    curstr+="%";
+	    nextpercent=strchr(start, '%');
+	    continue;
+	  }
 
-	      start=endptr+2;
-	    }
-	    break;
+	if(!curstr.empty())
+	  {
+	    instruction insn(instruction::text);
+	    insn.s=curstr;
+	    program.push_back(insn);
+	    curstr="";
+	  }
 
+	switch(code)
+	  {
 	  case 'B':
 	  case 'b':
 	  case 'R':
 	  case 'r':
 	  case 'D':
 	  case 'd':
+	    {
+	      instruction insn(instruction::flip_attrs);
+	      if(code=='B' || code=='b')
+		insn.attrs=A_BOLD;
+	      else if(code=='R' || code=='r')
+		insn.attrs=A_REVERSE;
+	      else
+		insn.attrs=A_DIM;
+	      program.push_back(insn);
+	    }
+	    break;
 	  case 'n':
+	    program.push_back(instruction(instruction::newline));
+	    break;
 	  case 'N':
-	  case '%':
-	    start=nextpercent+2;
+	    program.push_back(instruction(instruction::reset_style));
 	    break;
 	  case 's':
 	  case 'F':
-	  case 'A':
-	  case 'C':
 	  case 'S':
+	    add_argument(argcount, code, islong,
+			 "Bad argument string to fragf: inconsistent parameter types!");
 	    ++argcount;
-	    start=nextpercent+2;
 	    break;
-	  default:
-	    return text_fragment("Internal error: bad format string code '"+char_to_str(*(nextpercent+1))+"'",
-				 get_style("Error"));
-	  }
-
-	nextpercent=strchr(start, '%');
-      }
-
-    int nargs=max(argcount, posargcount);
-
-    argument arguments[nargs];
-
-    argcount=0;
-
-    // loop 2: read the list of arguments and parse their type.
-    start=format;
-    nextpercent=strchr(start, '%');
-    while(nextpercent!= nullptr)
-      {
-	bool islong=false;
-	if(*(nextpercent+1)=='l')
-	  {
-	    islong=true;
-	    ++nextpercent;
-	  }
-      
-	switch(*(nextpercent+1))
-	  {
 	  case '0':
 	  case '1':
 	  case '2':
@@ -1460,254 +1557,162 @@ namespace cwidget
 	    {
 	      char *endptr;
 
-	      int pos=strtol(nextpercent+1, &endptr, 10)-1;
-
-	      // if we saw it before it had better be the same type.
-	      if(arguments[pos].format!=0 &&
-		 (arguments[pos].format!=*(endptr+1) ||
-		  arguments[pos].islong!=islong))
-		return text_fragment("Bad argument string to fragf: inconsistent positional parameter types!",
-				     get_style("Error"));
+	      int pos=strtol(nextpercent+1, &endptr, 10);
 
-	      arguments[pos].format=*(endptr+1);
+	      if(*endptr!='$' || (*(endptr+1)!='F' && *(endptr+1)!='s'))
+		error="Internal error: bad character in positional argument: '"+char_to_str(*endptr)+"'";
+	      else if(pos<1)
+		error="Internal error: bad positional argument index "+char_to_str(*(nextpercent+1));
+	      else
+		add_argument(pos-1, *(endptr+1), islong,
+			     "Bad argument string to fragf: inconsistent positional parameter types!");
 
 	      start=endptr+2;
 	    }
 	    break;
-
-	  case 'B':
-	  case 'b':
-	  case 'R':
-	  case 'r':
-	  case 'D':
-	  case 'd':
-	  case 'n':
-	  case 'N':
-	  case '%':
-	    start=nextpercent+2;
-	    break;
-	  case 's':
-	  case 'F':
-	  case 'S':
-	    if(arguments[argcount].format!=0 && arguments[argcount].format!=*(nextpercent+1))
-	      return text_fragment("Bad argument string to fragf: inconsistent parameter types!",
-				   get_style("Error"));
-
-	    arguments[argcount].format=*(nextpercent+1);
-
-	    ++argcount;
-	    start=nextpercent+2;
-	    break;
 	  default:
-	    return text_fragment("Internal error: bad format string code '"+char_to_str(*(nextpercent+1))+"'",
-				 get_style("Error"));
+	    error="Internal error: bad format string code '"+char_to_str(code)+"'";
+	    break;
 	  }
 
-	nextpercent=strchr(start, '%');
+	if(error.empty())
+	  nextpercent=strchr(start, '%');
       }
 
-    style st;
+    if(!error.empty())
+      return;
 
-    va_list arglst;
-    va_start(arglst, format);
+    // Get any trailing bit o' string:
+    curstr+=start;
 
-    for(int i=0; i<nargs; ++i)
+    if(!curstr.empty())
       {
-	switch(arguments[i].format)
+	instruction insn(instruction::text);
+	insn.s=curstr;
+	program.push_back(insn);
+      }
+  }
+
+  fragment *fragf_format::vinstantiate(va_list arglst) const
+  {
+    vector<fragf_arg> args(arguments.size());
+
+    for(size_t i=0; i<arguments.size(); ++i)
+      {
+	switch(arguments[i].get_arg_type())
 	  {
-	  case 0:
+	  case fragf_arg::no_arg:
 	    break; // I suppose unused arguments are ok
-	  case 'F':
-	    arguments[i].F=va_arg(arglst, fragment *);
+	  case fragf_arg::fragment_arg:
+	    args[i]=fragf_arg(va_arg(arglst, fragment *));
 	    break;
-	  case 's':
-	    arguments[i].s=va_arg(arglst, const char *);
+	  case fragf_arg::string_arg:
+	    args[i]=fragf_arg(va_arg(arglst, const char *));
 	    break;
-	  case 'S':
-	    arguments[i].s=va_arg(arglst, const char *);
+	  case fragf_arg::wstring_arg:
+	    args[i]=fragf_arg(va_arg(arglst, const wchar_t *));
 	    break;
-	  default:
-	    return text_fragment("Internal error: bad argument format '"+char_to_str(arguments[i].format)+"'",
-				 get_style("Error"));
 	  }
       }
 
-    va_end(arglst);
+    return instantiate(args.empty() ? NULL : &args.front(), args.size());
+  }
 
-    // Now parse this and generate a result.
-    vector<fragment *> rval;
+  fragment *fragf_format::instantiate(const fragf_arg *args,
+				      size_t nargs) const
+  {
+    if(!error.empty())
+      return text_fragment(error, get_style("Error"));
 
-    start=format;
-    nextpercent=strchr(start, '%');
+    if(nargs<arguments.size())
+      return text_fragment("Bad arguments to fragf: too few arguments!",
+			   get_style("Error"));
 
-    // Current argument for non-positional arguments.
-    argcount=0;
+    for(size_t i=0; i<arguments.size(); ++i)
+      if(arguments[i].format!=0 &&
+	 arguments[i].get_arg_type()!=args[i].get_type())
+	return text_fragment(util::ssprintf("Bad arguments to fragf: argument %d has the wrong type!",
+					    (int)i+1),
+			     get_style("Error"));
+
+    vector<fragment *> rval;
+
+    style st;
 
     // Optimization: don't create lots of unnecessary text fragments
     // when one will do.
     string curstr("");
 
-    // Loop 3: execute the program
-
-    while(nextpercent!= nullptr)
+    for(vector<instruction>::const_iterator it=program.begin();
+	it!=program.end(); ++it)
       {
-	bool islong=false;
-
-	// First, make a fragment for everything until the percent:
-	curstr+=string(start, nextpercent-start);
-
-	if(*(nextpercent+1)=='l')
+	if(it->k==instruction::text)
 	  {
-	    islong=true;
-	    ++nextpercent;
+	    curstr+=it->s;
+	    continue;
 	  }
 
-	// This is almost always what we want; in the cases when it's not,
-	// I override it explicitly.
-	start=nextpercent+2;
-
-	// Now, find what's at the percent.
-	switch(*(nextpercent+1))
+	const fragf_arg *arg=NULL;
+	if(it->k==instruction::insert_argument)
 	  {
-	  case '%':
-	    curstr+="%";
-	    break;
-	  case 'B':
-	  case 'b':
-	  case 'R':
-	  case 'r':
-	  case 'D':
-	  case 'd':
-	    if(!curstr.empty())
-	      {
-		rval.push_back(text_fragment(curstr, st));
-		curstr="";
-	      }
-	    switch(*(nextpercent+1))
-	      {
-	      case 'B':
-	      case 'b':
-		st.attrs_flip(A_BOLD);
-		break;
-	      case 'R':
-	      case 'r':
-		st.attrs_flip(A_REVERSE);
-		break;
-	      case 'D':
-	      case 'd':
-		st.attrs_flip(A_DIM);
-		break;
-	      }
-	    break;
-	  case 'n':
-	    if(!curstr.empty())
+	    arg=&args[it->argnum];
+
+	    // Strings just accumulate.
+	    if(arguments[it->argnum].format=='s')
 	      {
-		rval.push_back(text_fragment(curstr, st));
-		curstr="";
+		if(arg->get_type()==fragf_arg::wstring_arg)
+		  curstr+=util::transcode(arg->get_wstring());
+		else
+		  curstr+=arg->get_string();
+		continue;
 	      }
+	  }
 
-	    rval.push_back(newline_fragment());
+	if(!curstr.empty())
+	  {
+	    rval.push_back(text_fragment(curstr, st));
+	    curstr="";
+	  }
+
+	switch(it->k)
+	  {
+	  case instruction::flip_attrs:
+	    st.attrs_flip(it->attrs);
 	    break;
-	  case 'N':
-	    if(!curstr.empty())
-	      {
-		rval.push_back(text_fragment(curstr, st));
-		curstr="";
-	      }
+	  case instruction::reset_style:
 	    st=style();
 	    break;
-	  case 'F':
-	    // should have been verified above.
-	    eassert(arguments[argcount].format=='F');
-
-	    if(!curstr.empty())
-	      {
-		rval.push_back(text_fragment(curstr, st));
-		curstr="";
-	      }
-	    rval.push_back(arguments[argcount].F);
-	    ++argcount;
+	  case instruction::newline:
+	    rval.push_back(newline_fragment());
 	    break;
-	  case 's':
-	    // should have been verified above.
-	    eassert(arguments[argcount].format=='s');
-
-	    if(islong)
-	      curstr += util::transcode(arguments[argcount].ls);
+	  case instruction::insert_argument:
+	    if(arguments[it->argnum].format=='F')
+	      rval.push_back(arg->get_fragment());
 	    else
-	      curstr+=arguments[argcount].s;
-	    ++argcount;
+	      st+=get_style(arg->get_string());
 	    break;
-	  case 'S':
-	    eassert(arguments[argcount].format=='S');
-
-	    if(!curstr.empty())
-	      {
-		rval.push_back(text_fragment(curstr, st));
-		curstr="";
-	      }
-
-	    st+=get_style(arguments[argcount].s);
-	    ++argcount;
+	  case instruction::text:
 	    break;
-	  case '0':
-	  case '1':
-	  case '2':
-	  case '3':
-	  case '4':
-	  case '5':
-	  case '6':
-	  case '7':
-	  case '8':
-	  case '9':
-	    {
-	      char *endptr;
-
-	      int pos=strtol(nextpercent+1, &endptr, 10)-1;
-
-	      eassert(arguments[pos].format==*(endptr+1));
-
-	      switch(*(endptr+1))
-		{
-		case 'F':
-		  if(!curstr.empty())
-		    {
-		      rval.push_back(text_fragment(curstr, st));
-		      curstr="";
-		    }
-
-		  rval.push_back(arguments[pos].F);
-		  break;
-		case 's':
-		  curstr+=arguments[pos].s;
-		  break;
-		case 'S':
-		  if(!curstr.empty())
-		    {
-		      rval.push_back(text_fragment(curstr, st));
-		      curstr="";
-		    }
-
-		  st+=get_style(arguments[pos].s);
-		  break;
-		}
-
-	      start=endptr+2;
-	      break;
-	    }
 	  }
-
-	nextpercent=strchr(start, '%');
       }
 
-    // Get any trailing bit o' string:
-    if(*start!=0)
-      curstr+=start;
-
     if(!curstr.empty())
       rval.push_back(text_fragment(curstr, st));
 
     return sequence_fragment(rval);
   }
-}
 
+  fragment *fragf(const char *format, ...)
+  {
+    const fragf_format compiled(format);
+
+    va_list arglst;
+    va_start(arglst, format);
+
+    fragment *rval=compiled.vinstantiate(arglst);
+
+    va_end(arglst);
+
+    return rval;
+  }
+}
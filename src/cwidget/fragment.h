@@ -27,6 +27,8 @@
 
 #include <cwidget/style.h>
 
+#include <cstdarg>
+
 #include <string>
 #include <vector>
 
@@ -358,6 +360,10 @@ namespace cwidget
    *  box that alters the shape of its contents.  Doing so will cause
    *  the program to abort.
    *
+   *  Large tables are laid out one column per job on
+   *  threads::thread_pool::get_default(), so a fragment must not
+   *  appear in more than one column.
+   *
    *  \param columns a list of column entry information ordered from
    *  left to right.
    */
@@ -387,10 +393,183 @@ namespace cwidget
    *  Note: if you use a parameter index multiple times, you are virtually
    *  GUARANTEED to segfault!
    *
+   *  The format string is parsed again on every call; code that
+   *  formats the same string repeatedly should use a fragf_format.
+   *
    *  \param format the format string
    *  \return the formatted fragment, or NULL if there is an error in the format.
    */
   fragment *fragf(const char *format, ...);
+
+  /** \brief An argument to a fragf_format.
+   *
+   *  Only the types that fragf understands can be converted to a
+   *  fragf_arg, so passing anything else to a compiled format is
+   *  caught by the compiler rather than at run time.
+   */
+  class fragf_arg
+  {
+  public:
+    enum arg_type
+      {
+	/** No argument was supplied. */
+	no_arg,
+	/** A fragment, for %F. */
+	fragment_arg,
+	/** A multibyte string, for %s and %S. */
+	string_arg,
+	/** A wide string, for %ls. */
+	wstring_arg
+      };
+
+  private:
+    arg_type type;
+
+    union
+    {
+      fragment *F;
+      const char *s;
+      const wchar_t *ls;
+    };
+
+  public:
+    fragf_arg()
+      :type(no_arg), F(NULL)
+    {
+    }
+
+    fragf_arg(fragment *_F)
+      :type(fragment_arg), F(_F)
+    {
+    }
+
+    fragf_arg(const char *_s)
+      :type(string_arg), s(_s)
+    {
+    }
+
+    fragf_arg(const wchar_t *_ls)
+      :type(wstring_arg), ls(_ls)
+    {
+    }
+
+    arg_type get_type() const { return type; }
+    fragment *get_fragment() const { return F; }
+    const char *get_string() const { return s; }
+    const wchar_t *get_wstring() const { return ls; }
+  };
+
+  /** \brief A fragf format string that has been parsed ahead of time.
+   *
+   *  Constructing a fragf_format parses the format once; each
+   *  instantiation then only walks the parsed instructions.  A
+   *  format is never modified after it is constructed, so a single
+   *  instance can be shared freely, e.g. as a static variable:
+   *
+   *   static const fragf_format fmt("%S%BWARNING%b: %s failed");
+   *   fragment *f = fmt("Error", some_routine);
+   *
+   *  The arguments passed to operator() are checked against the
+   *  types that fragf understands at compile time and against the
+   *  format when the fragment is built.  Errors in the format or the
+   *  arguments are reported the same way fragf() reports them, by
+   *  returning a fragment describing the error in the "Error" style.
+   */
+  class fragf_format
+  {
+    /** The type of a single argument, as declared by the format. */
+    struct argument_spec
+    {
+      /** 'F', 's' or 'S', or 0 if the argument is never used. */
+      char format;
+      /** If \b true, the 'l' modifier was attached to this argument. */
+      bool islong;
+
+      argument_spec()
+	:format(0), islong(false)
+      {
+      }
+
+      /** \return the type of argument that satisfies this spec. */
+      fragf_arg::arg_type get_arg_type() const;
+    };
+
+    /** A single step of building the output fragment. */
+    struct instruction
+    {
+      enum kind
+	{
+	  /** Append the literal text s. */
+	  text,
+	  /** Substitute argument number argnum. */
+	  insert_argument,
+	  /** Toggle the attributes attrs. */
+	  flip_attrs,
+	  /** Reset the style to the null style. */
+	  reset_style,
+	  /** Insert a newline fragment. */
+	  newline
+	};
+
+      kind k;
+      std::string s;
+      int argnum;
+      attr_t attrs;
+
+      instruction(kind _k)
+	:k(_k), argnum(0), attrs(0)
+      {
+      }
+    };
+
+    std::vector<argument_spec> arguments;
+    std::vector<instruction> program;
+
+    /** If not empty, the format could not be parsed and this is the
+     *  error message to display instead of its contents.
+     */
+    std::string error;
+
+    /** Record that argument argnum has the given format; sets error
+     *  if this conflicts with an earlier use of the same argument.
+     */
+    void add_argument(size_t argnum, char format, bool islong,
+		      const char *conflict_msg);
+
+    void parse(const char *format);
+
+  public:
+    /** Parse the given format string; see fragf() for its syntax. */
+    explicit fragf_format(const char *format);
+
+    /** \return the number of arguments the format consumes. */
+    size_t get_num_args() const { return arguments.size(); }
+
+    /** Build a fragment from this format and an array of arguments.
+     *
+     *  \param args the arguments, in the order they would be passed
+     *  to fragf().
+     *  \param nargs the number of entries in args.
+     */
+    fragment *instantiate(const fragf_arg *args, size_t nargs) const;
+
+    /** Build a fragment from this format and a list of arguments
+     *  read in the same way fragf() reads them.
+     */
+    fragment *vinstantiate(va_list args) const;
+
+    fragment *operator()() const
+    {
+      return instantiate(NULL, 0);
+    }
+
+    template<typename... Args>
+    fragment *operator()(const Args &... args) const
+    {
+      const fragf_arg arg_array[] = { fragf_arg(args)... };
+      return instantiate(arg_array, sizeof...(Args));
+    }
+  };
 }
 
 #endif
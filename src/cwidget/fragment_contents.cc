@@ -0,0 +1,162 @@
+// fragment_contents.cc
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include "fragment_contents.h"
+
+#include "style.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace cwidget
+{
+  const fragment_line::size_type fragment_line::npos;
+
+  fragment_line::fragment_line(const wstring &s)
+    :cells(NULL), offset(0), len(s.size()), indent(0), indent_cell(L' ', 0)
+  {
+    set_cells(new fragment_cells(wchstring(s)));
+  }
+
+  fragment_line::fragment_line(const wstring &s, const style &st)
+    :cells(NULL), offset(0), len(s.size()), indent(0), indent_cell(L' ', 0)
+  {
+    set_cells(new fragment_cells(wchstring(s, st)));
+  }
+
+  fragment_line::fragment_line(const wchstring &s)
+    :cells(NULL), offset(0), len(s.size()), indent(0), indent_cell(L' ', 0)
+  {
+    set_cells(new fragment_cells(s));
+  }
+
+  fragment_line::fragment_line(const fragment_line &s, size_t loc, size_t n)
+    :cells(NULL), offset(0), len(0), indent(0), indent_cell(s.indent_cell)
+  {
+    eassert(loc <= s.size());
+
+    n=min(n, s.size()-loc);
+
+    if(loc < s.indent)
+      indent=min(s.indent-loc, n);
+
+    len=n-indent;
+
+    if(len > 0)
+      {
+	offset=s.offset+(loc > s.indent ? loc-s.indent : 0);
+	set_cells(s.cells);
+      }
+  }
+
+  void fragment_line::detach()
+  {
+    fragment_cells *new_cells=new fragment_cells;
+
+    if(cells != NULL)
+      new_cells->get_cells().assign(cells->get_cells(), offset, len);
+
+    set_cells(new_cells);
+    offset=0;
+  }
+
+  int fragment_line::width() const
+  {
+    int rval=indent*wcwidth(indent_cell.ch);
+
+    if(cells != NULL)
+      {
+	const wchstring &s=cells->get_cells();
+	for(size_t i=offset; i<offset+len; ++i)
+	  rval+=wcwidth(s[i].ch);
+      }
+
+    return rval;
+  }
+
+  fragment_line fragment_line::indented(size_t n, const wchtype &c) const
+  {
+    fragment_line rval(*this);
+
+    if(n == 0)
+      return rval;
+
+    if(rval.indent > 0 && rval.indent_cell != c)
+      {
+	// The existing indentation can't be merged with the new one,
+	// so turn it into real text.
+	fragment_line tmp(n, c);
+	tmp+=rval;
+	return tmp;
+      }
+
+    rval.indent+=n;
+    rval.indent_cell=c;
+
+    return rval;
+  }
+
+  fragment_line &fragment_line::operator+=(const fragment_line &other)
+  {
+    if(other.empty())
+      return *this;
+    else if(empty())
+      return (*this)=other;
+    else if(&other == this)
+      return (*this)+=fragment_line(other);
+
+    if(cells == NULL || cells->is_shared() ||
+       offset+len != cells->get_cells().size())
+      detach();
+
+    wchstring &s=cells->get_cells();
+    s.append(other.indent, other.indent_cell);
+    if(other.cells != NULL)
+      s.append(other.cells->get_cells(), other.offset, other.len);
+
+    len+=other.size();
+
+    return *this;
+  }
+
+  void fragment_line::apply_style(const style &st)
+  {
+    indent_cell=st.apply_to(indent_cell);
+
+    if(len == 0)
+      return;
+
+    if(cells->is_shared())
+      detach();
+
+    style_applier apply(st);
+    wchstring &s=cells->get_cells();
+    for(size_t i=offset; i<offset+len; ++i)
+      s[i].attrs=apply(s[i].attrs);
+  }
+
+  wchstring fragment_line::str() const
+  {
+    wchstring rval(indent, indent_cell);
+
+    if(cells != NULL)
+      rval.append(cells->get_cells(), offset, len);
+
+    return rval;
+  }
+}
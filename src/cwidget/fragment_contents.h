@@ -13,11 +13,181 @@
 
 namespace cwidget
 {
-  /** The type used to represent a line of a fragment; it might be
-   *  worthwhile to change this to a rope<chtype> if this class is
-   *  used to format larger pieces of text.
+  class style;
+
+  /** A reference-counted buffer of formatted cells.  Fragment lines
+   *  are views into these buffers, so that container fragments can
+   *  slice and indent their children's lines without copying the
+   *  characters around.
    */
-  typedef wchstring fragment_line;
+  class fragment_cells
+  {
+    wchstring cells;
+    mutable int refs;
+
+    // Use decref() to get rid of these.
+    ~fragment_cells() {}
+  public:
+    fragment_cells():cells(std::basic_string<wchtype>()), refs(0) {}
+    explicit fragment_cells(const wchstring &_cells):cells(_cells), refs(0) {}
+
+    void incref() const {++refs;}
+    void decref() const {--refs; if(refs==0) delete this;}
+
+    /** \return \b true if more than one line is viewing this buffer. */
+    bool is_shared() const {return refs>1;}
+
+    const wchstring &get_cells() const {return cells;}
+    wchstring &get_cells() {return cells;}
+  };
+
+  /** The type used to represent a line of a fragment.
+   *
+   *  A line is a run of indentation cells followed by a slice of a
+   *  shared fragment_cells buffer.  Copying, slicing and indenting a
+   *  line are cheap and never touch the characters; only operations
+   *  that really produce new text (appending to a line whose buffer
+   *  is shared, or restyling it) copy the cells, and then only the
+   *  ones the line actually covers.
+   */
+  class fragment_line
+  {
+    /** The buffer this line views, or \b NULL if the line contains
+     *  nothing but indentation.
+     */
+    fragment_cells *cells;
+
+    /** The index in cells of the first character of this line. */
+    size_t offset;
+
+    /** The number of characters of cells covered by this line. */
+    size_t len;
+
+    /** The number of copies of indent_cell that precede the text. */
+    size_t indent;
+
+    /** The cell with which this line is indented. */
+    wchtype indent_cell;
+
+    void set_cells(fragment_cells *new_cells)
+    {
+      if(new_cells != NULL)
+	new_cells->incref();
+      if(cells != NULL)
+	cells->decref();
+      cells=new_cells;
+    }
+
+    /** Replace the buffer with a private copy of the characters
+     *  covered by this line.  The indentation is left alone.
+     */
+    void detach();
+  public:
+    typedef size_t size_type;
+    static const size_type npos = static_cast<size_type>(-1);
+
+    /** Create an empty line. */
+    fragment_line()
+      :cells(NULL), offset(0), len(0), indent(0), indent_cell(L' ', 0)
+    {
+    }
+
+    /** Create a line from the given string with empty attributes. */
+    fragment_line(const std::wstring &s);
+
+    /** Create a line from the given string in the given style. */
+    fragment_line(const std::wstring &s, const style &st);
+
+    /** Create a line containing a copy of the given cells. */
+    fragment_line(const wchstring &s);
+
+    /** Create a line consisting of n copies of the given cell.  No
+     *  buffer is allocated for such a line.
+     */
+    fragment_line(size_t n, const wchtype &c)
+      :cells(NULL), offset(0), len(0), indent(n), indent_cell(c)
+    {
+    }
+
+    /** Create a line consisting of n copies of the given character. */
+    fragment_line(size_t n, wchar_t c, attr_t a)
+      :cells(NULL), offset(0), len(0), indent(n), indent_cell(c, a)
+    {
+    }
+
+    /** Create a line viewing the n characters of s starting at loc.
+     *  The new line shares its characters with s.
+     */
+    fragment_line(const fragment_line &s, size_t loc, size_t n=npos);
+
+    fragment_line(const fragment_line &other)
+      :cells(other.cells), offset(other.offset), len(other.len),
+       indent(other.indent), indent_cell(other.indent_cell)
+    {
+      if(cells != NULL)
+	cells->incref();
+    }
+
+    ~fragment_line()
+    {
+      if(cells != NULL)
+	cells->decref();
+    }
+
+    fragment_line &operator=(const fragment_line &other)
+    {
+      set_cells(other.cells);
+      offset=other.offset;
+      len=other.len;
+      indent=other.indent;
+      indent_cell=other.indent_cell;
+
+      return *this;
+    }
+
+    /** \return the number of characters in this line. */
+    size_t size() const {return indent+len;}
+
+    bool empty() const {return indent==0 && len==0;}
+
+    /** \return the number of columns occupied by this line. */
+    int width() const;
+
+    /** \return the ith character of this line. */
+    wchtype operator[](size_t i) const
+    {
+      if(i<indent)
+	return indent_cell;
+      else
+	return cells->get_cells()[offset+i-indent];
+    }
+
+    /** \return this line indented by n copies of the given cell.  The
+     *  characters of this line are shared with the result unless
+     *  this line is already indented by a different cell.
+     */
+    fragment_line indented(size_t n, const wchtype &c) const;
+
+    /** Append the given line to this one.  If this line is the only
+     *  view of the end of its buffer, the other line's characters are
+     *  appended in place; otherwise this line's characters are
+     *  copied first.
+     */
+    fragment_line &operator+=(const fragment_line &other);
+
+    fragment_line operator+(const fragment_line &other) const
+    {
+      fragment_line rval(*this);
+      rval+=other;
+      return rval;
+    }
+
+    /** Change the attributes of this line by using the given style. */
+    void apply_style(const style &st);
+
+    /** \return a copy of the characters of this line. */
+    wchstring str() const;
+  };
 
   /** This class represents the formatted contents of a fragment.
    *
@@ -0,0 +1,180 @@
+// thread_pool.cc
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include "thread_pool.h"
+
+#include <exception>
+
+#include <unistd.h>
+
+namespace cwidget
+{
+  namespace threads
+  {
+    std::string JobFailedException::errmsg() const
+    {
+      return "Background job failed: " + msg;
+    }
+
+    thread_pool::job::~job()
+    {
+    }
+
+    class thread_pool::worker_thunk
+    {
+      thread_pool &pool;
+    public:
+      worker_thunk(thread_pool &_pool)
+	:pool(_pool)
+      {
+      }
+
+      void operator()() const
+      {
+	pool.worker_loop();
+      }
+    };
+
+    thread_pool::thread_pool(int num_threads)
+      :stopping(false)
+    {
+      for(int i = 0; i < num_threads; ++i)
+	workers.push_back(new thread(worker_thunk(*this)));
+    }
+
+    thread_pool::~thread_pool()
+    {
+      {
+	mutex::lock l(m);
+	stopping = true;
+	c.wake_all();
+      }
+
+      for(std::vector<thread *>::const_iterator it = workers.begin();
+	  it != workers.end(); ++it)
+	{
+	  (*it)->join();
+	  delete *it;
+	}
+    }
+
+    void thread_pool::run_one(mutex::lock &l)
+    {
+      queued_job next = q.front();
+      q.pop_front();
+
+      std::string error;
+      bool failed = false;
+
+      l.release();
+      try
+	{
+	  next.j->run();
+	}
+      catch(const util::Exception &e)
+	{
+	  failed = true;
+	  error = e.errmsg();
+	}
+      catch(const std::exception &e)
+	{
+	  failed = true;
+	  error = e.what();
+	}
+      l.acquire();
+
+      if(failed && !next.b->failed)
+	{
+	  next.b->failed = true;
+	  next.b->error = error;
+	}
+
+      --next.b->remaining;
+      if(next.b->remaining == 0)
+	c.wake_all();
+    }
+
+    void thread_pool::worker_loop()
+    {
+      mutex::lock l(m);
+
+      while(true)
+	{
+	  while(q.empty() && !stopping)
+	    c.wait(l);
+
+	  if(q.empty())
+	    return;
+
+	  run_one(l);
+	}
+    }
+
+    void thread_pool::run_all(const std::vector<job *> &jobs)
+    {
+      if(jobs.empty())
+	return;
+
+      batch b(jobs.size());
+
+      mutex::lock l(m);
+
+      for(std::vector<job *>::const_iterator it = jobs.begin();
+	  it != jobs.end(); ++it)
+	q.push_back(queued_job(*it, &b));
+
+      c.wake_all();
+
+      // Help out instead of just waiting; this is what makes nested
+      // batches and worker-less pools work.
+      while(b.remaining > 0)
+	{
+	  if(!q.empty())
+	    run_one(l);
+	  else
+	    c.wait(l);
+	}
+
+      if(b.failed)
+	throw JobFailedException(b.error);
+    }
+
+    thread_pool &thread_pool::get_default()
+    {
+      static mutex default_pool_mutex;
+      static thread_pool *default_pool = NULL;
+
+      mutex::lock l(default_pool_mutex);
+
+      if(default_pool == NULL)
+	{
+	  // The thread that submits a batch works on it too, so one
+	  // processor is already accounted for.
+	  const long max_threads = 3;
+	  long num_threads = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	  if(num_threads < 0)
+	    num_threads = 0;
+	  else if(num_threads > max_threads)
+	    num_threads = max_threads;
+
+	  default_pool = new thread_pool(num_threads);
+	}
+
+      return *default_pool;
+    }
+  }
+}
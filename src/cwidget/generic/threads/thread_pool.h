@@ -0,0 +1,147 @@
+// thread_pool.h                                          -*-c++-*-
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+//
+// A small pool of worker threads for running batches of independent
+// jobs, such as laying out the columns of a table.
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "threads.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace cwidget
+{
+  namespace threads
+  {
+    /** \brief Thrown by thread_pool::run_all() when one of the jobs
+     *  in the batch threw an exception.
+     */
+    class JobFailedException : public ThreadException
+    {
+      std::string msg;
+    public:
+      JobFailedException(const std::string &_msg)
+	:msg(_msg)
+      {
+      }
+
+      std::string errmsg() const;
+    };
+
+    /** \brief A fixed set of worker threads that run batches of
+     *  independent jobs.
+     *
+     *  A thread waiting in run_all() runs queued jobs itself instead
+     *  of sleeping, so a job may submit a nested batch to the same
+     *  pool without deadlocking it, and a pool with no worker
+     *  threads simply runs every batch in the caller.
+     *
+     *  Like the other threading primitives, pools are not copyable.
+     */
+    class thread_pool
+    {
+    public:
+      /** \brief A unit of work to be run by the pool. */
+      class job
+      {
+      public:
+	/** Do the work.  This may be invoked from any thread. */
+	virtual void run() = 0;
+
+	virtual ~job();
+      };
+
+    private:
+      /** Tracks the jobs of a single call to run_all(). */
+      struct batch
+      {
+	int remaining;
+	bool failed;
+	std::string error;
+
+	batch(int _remaining)
+	  :remaining(_remaining), failed(false)
+	{
+	}
+      };
+
+      struct queued_job
+      {
+	job *j;
+	batch *b;
+
+	queued_job(job *_j, batch *_b)
+	  :j(_j), b(_b)
+	{
+	}
+      };
+
+      class worker_thunk;
+
+      std::deque<queued_job> q;
+      std::vector<thread *> workers;
+      bool stopping;
+
+      /** Signalled when a job is queued, when a batch finishes, and
+       *  when the pool is shutting down.
+       */
+      condition c;
+      mutex m;
+
+      thread_pool(const thread_pool &other);
+      thread_pool &operator=(const thread_pool &other);
+
+      /** The main loop of each worker thread. */
+      void worker_loop();
+
+      /** Pop the first queued job and run it.  The lock is released
+       *  while the job runs.
+       */
+      void run_one(mutex::lock &l);
+    public:
+      /** Create a pool with the given number of worker threads. */
+      explicit thread_pool(int num_threads);
+
+      /** Wait for the queued jobs to finish and stop the workers. */
+      ~thread_pool();
+
+      /** \return the number of worker threads in this pool. */
+      int get_num_threads() const { return workers.size(); }
+
+      /** Run a batch of jobs and wait until all of them have
+       *  finished.  The jobs are not deleted.
+       *
+       *  \throw JobFailedException if any job threw an exception; the
+       *  remaining jobs of the batch are run to completion first.
+       */
+      void run_all(const std::vector<job *> &jobs);
+
+      /** \return the pool shared by the library, with one thread per
+       *  additional processor (up to a small limit).  It is created
+       *  the first time this is called and lives until the program
+       *  exits.
+       */
+      static thread_pool &get_default();
+    };
+  }
+}
+
+#endif
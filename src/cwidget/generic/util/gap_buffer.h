@@ -0,0 +1,178 @@
+// gap_buffer.h                                    -*-c++-*-
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+//
+// A sequence that is cheap to edit near the most recent edit.
+
+#ifndef GAP_BUFFER_H
+#define GAP_BUFFER_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cwidget/generic/util/eassert.h>
+
+namespace cwidget
+{
+  namespace util
+  {
+    /** \brief A sequence stored with a movable hole in the middle.
+     *
+     *  The elements are kept in one array with an unused "gap" at the
+     *  location of the last insertion or deletion.  Editing at the gap
+     *  costs time proportional to the size of the edit, and moving
+     *  the gap costs time proportional to the distance it moves; since
+     *  interactive edits are clustered around a cursor, typing into a
+     *  long text doesn't copy the text on every keystroke the way
+     *  inserting into a std::basic_string does.
+     */
+    template<typename T>
+    class gap_buffer
+    {
+    public:
+      typedef typename std::vector<T>::size_type size_type;
+
+    private:
+      std::vector<T> buf;
+      /** The elements in [gap_start, gap_end) are unused. */
+      size_type gap_start, gap_end;
+
+      size_type gap_size() const { return gap_end - gap_start; }
+
+      /** Move the gap so that it begins at pos. */
+      void move_gap(size_type pos)
+      {
+	if(pos < gap_start)
+	  std::copy_backward(buf.begin() + pos, buf.begin() + gap_start,
+			     buf.begin() + gap_end);
+	else if(pos > gap_start)
+	  std::copy(buf.begin() + gap_end, buf.begin() + gap_end + (pos - gap_start),
+		    buf.begin() + gap_start);
+
+	gap_end = pos + gap_size();
+	gap_start = pos;
+      }
+
+      /** Make sure that the gap can hold at least n elements. */
+      void reserve_gap(size_type n)
+      {
+	if(gap_size() >= n)
+	  return;
+
+	const size_type old_size = buf.size();
+	const size_type new_size = std::max(old_size * 2, old_size - gap_size() + n + 16);
+	const size_type tail = old_size - gap_end;
+
+	buf.resize(new_size);
+	std::copy_backward(buf.begin() + gap_end, buf.begin() + old_size,
+			   buf.end());
+	gap_end = new_size - tail;
+      }
+
+    public:
+      gap_buffer()
+	: gap_start(0), gap_end(0)
+      {
+      }
+
+      gap_buffer(const std::basic_string<T> &s)
+	: buf(s.begin(), s.end()), gap_start(s.size()), gap_end(s.size())
+      {
+      }
+
+      size_type size() const { return buf.size() - gap_size(); }
+      bool empty() const { return size() == 0; }
+
+      const T &operator[](size_type i) const
+      {
+	return i < gap_start ? buf[i] : buf[i + gap_size()];
+      }
+
+      /** Insert n elements from s before position pos. */
+      void insert(size_type pos, const T *s, size_type n)
+      {
+	eassert(pos <= size());
+
+	reserve_gap(n);
+	move_gap(pos);
+	std::copy(s, s + n, buf.begin() + gap_start);
+	gap_start += n;
+      }
+
+      void insert(size_type pos, const std::basic_string<T> &s)
+      {
+	insert(pos, s.data(), s.size());
+      }
+
+      void insert(size_type pos, const T &t)
+      {
+	insert(pos, &t, 1);
+      }
+
+      /** Remove up to n elements starting at position pos. */
+      void erase(size_type pos, size_type n = std::basic_string<T>::npos)
+      {
+	eassert(pos <= size());
+
+	n = std::min(n, size() - pos);
+	move_gap(pos);
+	gap_end += n;
+      }
+
+      void clear()
+      {
+	buf.clear();
+	gap_start = gap_end = 0;
+      }
+
+      gap_buffer &operator=(const std::basic_string<T> &s)
+      {
+	buf.assign(s.begin(), s.end());
+	gap_start = gap_end = s.size();
+	return *this;
+      }
+
+      /** \return up to n elements starting at pos, as a string. */
+      std::basic_string<T> substr(size_type pos, size_type n = std::basic_string<T>::npos) const
+      {
+	eassert(pos <= size());
+
+	n = std::min(n, size() - pos);
+
+	std::basic_string<T> rval;
+	rval.reserve(n);
+
+	const size_type end = pos + n;
+	if(pos < gap_start)
+	  rval.append(buf.begin() + pos, buf.begin() + std::min(end, gap_start));
+	if(end > gap_start)
+	  rval.append(buf.begin() + std::max(pos, gap_start) + gap_size(),
+		      buf.begin() + end + gap_size());
+
+	return rval;
+      }
+
+      /** \return the whole contents of the buffer as a string. */
+      std::basic_string<T> str() const
+      {
+	return substr(0);
+      }
+    };
+  }
+}
+
+#endif // GAP_BUFFER_H
@@ -19,27 +19,171 @@
 
 #include "style.h"
 
+#include <deque>
 #include <map>
+#include <vector>
 
 using namespace std;
 
 namespace cwidget
 {
-  map<string, style> styles;
+  namespace
+  {
+    /** An entry in the table of interned styles. */
+    struct interned_entry
+    {
+      style st;
+
+      /** The result of st.get_attrs(). */
+      attr_t attrs;
+
+      /** The color generation for which attrs was computed. */
+      int attrs_generation;
+
+      interned_entry(const style &_st)
+	:st(_st), attrs(0), attrs_generation(-1)
+      {
+      }
+    };
+
+    /** The interned styles, indexed by their IDs.  This is a deque so
+     *  that references returned by get_style() stay valid when more
+     *  styles are interned.
+     */
+    deque<interned_entry> &get_interned_table()
+    {
+      static deque<interned_entry> table(1, interned_entry(style()));
+      return table;
+    }
+
+    map<style, int> &get_interned_ids()
+    {
+      static map<style, int> ids;
+      if(ids.empty())
+	ids[style()] = 0;
+      return ids;
+    }
+
+    /** Maps pairs of style IDs to the ID of their composition. */
+    map<pair<int, int>, int> &get_compositions()
+    {
+      static map<pair<int, int>, int> compositions;
+      return compositions;
+    }
+  }
+
+  interned_style::interned_style(const style &st)
+  {
+    map<style, int> &ids(get_interned_ids());
+    map<style, int>::const_iterator found = ids.find(st);
+
+    if(found != ids.end())
+      id = found->second;
+    else
+      {
+	deque<interned_entry> &table(get_interned_table());
+	id = table.size();
+	table.push_back(interned_entry(st));
+	ids[st] = id;
+      }
+  }
+
+  const style &interned_style::get_style() const
+  {
+    return get_interned_table()[id].st;
+  }
+
+  attr_t interned_style::get_attrs() const
+  {
+    interned_entry &entry(get_interned_table()[id]);
+    const int generation = config::get_color_generation();
+
+    if(entry.attrs_generation != generation)
+      {
+	entry.attrs = entry.st.get_attrs();
+	entry.attrs_generation = generation;
+      }
+
+    return entry.attrs;
+  }
+
+  interned_style interned_style::operator+(const interned_style &other) const
+  {
+    if(other.id == 0)
+      return *this;
+    else if(id == 0)
+      return other;
+
+    map<pair<int, int>, int> &compositions(get_compositions());
+    const pair<int, int> key(id, other.id);
+    map<pair<int, int>, int>::const_iterator found = compositions.find(key);
+
+    if(found != compositions.end())
+      return interned_style(found->second);
+
+    const interned_style rval(get_style() + other.get_style());
+    compositions[key] = rval.id;
+    return rval;
+  }
+
+  namespace
+  {
+    /** The definitions of the named styles, indexed by handle. */
+    vector<interned_style> &get_named_styles()
+    {
+      static vector<interned_style> named_styles;
+      return named_styles;
+    }
+
+    /** Maps the name of each style to its handle. */
+    map<string, int> &get_style_indices()
+    {
+      static map<string, int> style_indices;
+      return style_indices;
+    }
+
+    /** \return the index of the given style in the registry, adding
+     *  it if it isn't there.
+     */
+    int find_style_index(const string &name)
+    {
+      map<string, int> &indices(get_style_indices());
+      map<string, int>::const_iterator found = indices.find(name);
+
+      if(found != indices.end())
+	return found->second;
+
+      vector<interned_style> &named_styles(get_named_styles());
+      const int rval = named_styles.size();
+      named_styles.push_back(interned_style());
+      indices[name] = rval;
+      return rval;
+    }
+  }
+
+  style_handle::style_handle(const std::string &name)
+    :index(find_style_index(name))
+  {
+  }
+
+  interned_style style_handle::get_interned() const
+  {
+    return get_named_styles()[index];
+  }
 
   const style &get_style(const std::string &name)
   {
-    static style null_style;
-    map<string, style>::const_iterator found = styles.find(name);
+    map<string, int> &indices(get_style_indices());
+    map<string, int>::const_iterator found = indices.find(name);
 
-    if(found == styles.end())
-      return null_style;
+    if(found == indices.end())
+      return interned_style().get_style();
     else
-      return found->second;
+      return get_named_styles()[found->second].get_style();
   }
 
   void set_style(const std::string &name, const style &style)
   {
-    styles[name] = style;
+    get_named_styles()[find_style_index(name)] = interned_style(style);
   }
 }
@@ -51,11 +51,11 @@ namespace cwidget
   class style
   {
     /** The foreground color to be used. (if negative, no change) */
-    short fg;
+    int fg;
     /** The background color to be used. (if -2, no change; if -1, the
      *  'default' color)
      */
-    short bg;
+    int bg;
 
     /** Attributes to set. */
     attr_t set_attrs;
@@ -78,12 +78,12 @@ namespace cwidget
     /** Set the foreground color.  There is no change if the
      *  new foreground color is "empty".
      */
-    void set_fg(short _fg) {if(_fg >= 0) fg=_fg;}
+    void set_fg(int _fg) {if(_fg >= 0) fg=_fg;}
 
     /** Set the background color.  There is no change if the
      *  new background color is "empty".
      */
-    void set_bg(short _bg) {if(_bg >= -1) bg = _bg;}
+    void set_bg(int _bg) {if(_bg >= -1) bg = _bg;}
 
     /** Set the given attribute(s). */
     void attrs_on(attr_t attrs)
@@ -150,10 +150,27 @@ namespace cwidget
 	flip_attrs != other.flip_attrs;
     }
 
+    /** An arbitrary total order on styles, so that they can be used
+     *  as keys.
+     */
+    bool operator<(const style &other) const
+    {
+      if(fg != other.fg)
+	return fg < other.fg;
+      else if(bg != other.bg)
+	return bg < other.bg;
+      else if(set_attrs != other.set_attrs)
+	return set_attrs < other.set_attrs;
+      else if(clear_attrs != other.clear_attrs)
+	return clear_attrs < other.clear_attrs;
+      else
+	return flip_attrs < other.flip_attrs;
+    }
+
     /** \return the foreground color. */
-    short get_fg() const {return fg<0?0:fg;}
+    int get_fg() const {return fg<0?0:fg;}
     /** \return the background color. */
-    short get_bg() const {return bg<0?0:bg;}
+    int get_bg() const {return bg<0?0:bg;}
     /** \return the current attributes. */
     attr_t get_attrs() const
     {
@@ -178,15 +195,115 @@ namespace cwidget
 	((((ch & ~ (A_CHARTEXT | A_COLOR)) | set_attrs) & ~clear_attrs) ^ flip_attrs);
     }
 
+    /** \return the given attributes updated with ours. */
+    attr_t apply_to_attrs(attr_t attrs) const
+    {
+      return config::mix_color(attrs, fg, bg) |
+	((((attrs & ~ A_COLOR) | set_attrs) & ~clear_attrs) ^ flip_attrs);
+    }
+
     /** \return the given character with its attributes updated with ours. */
     wchtype apply_to(wchtype ch) const
     {
-      // Relies somewhat on the bitwise representation of attributes;
-      // the multicharacter-capable stuff needed for utf8 will make this
-      // go away (for better or for worse..)
-      return wchtype(ch.ch,
-		     config::mix_color(ch.attrs, fg, bg) |
-		     ((((ch.attrs & ~ A_COLOR) | set_attrs) & ~clear_attrs) ^ flip_attrs));
+      return wchtype(ch.ch, apply_to_attrs(ch.attrs));
+    }
+  };
+
+  /** \brief Applies a style to a run of characters.
+   *
+   *  Neighbouring characters almost always have the same attributes,
+   *  so this remembers the result for the last attributes it saw and
+   *  only recomputes it (and mixes colors) when they change.
+   */
+  class style_applier
+  {
+    const style &st;
+    attr_t last_in, last_out;
+    bool valid;
+
+  public:
+    style_applier(const style &_st)
+      :st(_st), last_in(0), last_out(0), valid(false)
+    {
+    }
+
+    attr_t operator()(attr_t attrs)
+    {
+      if(!valid || attrs != last_in)
+	{
+	  last_in  = attrs;
+	  last_out = st.apply_to_attrs(attrs);
+	  valid    = true;
+	}
+
+      return last_out;
+    }
+  };
+
+  /** \brief A handle to a style in the global table of interned
+   *  styles.
+   *
+   *  Each distinct style is stored in the table once, so a handle is
+   *  just an index: copying and comparing handles is as cheap as
+   *  copying and comparing integers.  The attributes of an interned
+   *  style are computed once (and again only if the color setup
+   *  changes), and the result of composing two interned styles is
+   *  remembered, so code that combines the same styles on every
+   *  repaint only pays for a table lookup.
+   *
+   *  Interned styles are never freed.  Like the rest of the display
+   *  code, they may only be used from the thread that runs the main
+   *  loop.
+   */
+  class interned_style
+  {
+    /** The index of this style in the table; 0 is the null style. */
+    int id;
+
+    explicit interned_style(int _id)
+      :id(_id)
+    {
+    }
+
+  public:
+    /** Create a handle to the null style. */
+    interned_style()
+      :id(0)
+    {
+    }
+
+    /** Create a handle to the given style, adding it to the table if
+     *  necessary.
+     */
+    explicit interned_style(const style &st);
+
+    /** \return the index of this style in the table. */
+    int get_id() const { return id; }
+
+    /** \return the style referred to by this handle. */
+    const style &get_style() const;
+
+    /** \return the attributes of this style; equivalent to
+     *  get_style().get_attrs().
+     */
+    attr_t get_attrs() const;
+
+    /** \return a handle to the composition of this style and other. */
+    interned_style operator+(const interned_style &other) const;
+
+    interned_style &operator+=(const interned_style &other)
+    {
+      return (*this) = (*this) + other;
+    }
+
+    bool operator==(const interned_style &other) const
+    {
+      return id == other.id;
+    }
+
+    bool operator!=(const interned_style &other) const
+    {
+      return id != other.id;
     }
   };
 
@@ -197,7 +314,7 @@ namespace cwidget
   /** \return a style that just sets the foreground color to the
    *          given value.
    */
-  inline style style_fg(short fg)
+  inline style style_fg(int fg)
   {
     style rval;
     rval.set_fg(fg);
@@ -207,7 +324,7 @@ namespace cwidget
   /** \return a style that just sets the background color to the
    *          given value.
    */
-  inline style style_bg(short bg)
+  inline style style_bg(int bg)
   {
     style rval;
     rval.set_bg(bg);
@@ -239,12 +356,56 @@ namespace cwidget
     return rval;
   }
 
+  /** \brief A handle to a style in the global registry of named
+   *  styles.
+   *
+   *  Creating a handle looks up the name once; after that, fetching
+   *  the style is an array lookup, so paint routines can keep a
+   *  static handle instead of calling get_style() with a string on
+   *  every repaint.  Handles never become invalid, and they always
+   *  refer to the current definition of the style: set_style()
+   *  updates the entry that the handle points to.  A handle to a
+   *  name that has not been defined yet refers to the null style
+   *  until set_style() is called with that name.
+   *
+   *  Like interned styles, handles may only be used from the thread
+   *  that runs the main loop.
+   */
+  class style_handle
+  {
+    /** The index of this style in the registry. */
+    int index;
+
+  public:
+    /** Create a handle to the style with the given name. */
+    explicit style_handle(const std::string &name);
+
+    /** \return the index of this style in the registry. */
+    int get_index() const { return index; }
+
+    /** \return the current definition of this style. */
+    interned_style get_interned() const;
+
+    /** \return the current definition of this style. */
+    const style &get() const
+    {
+      return get_interned().get_style();
+    }
+  };
+
   /** Look up a style in the global registry.
    *
-   *  \throws NoSuchStyle if the style does not exist.
+   *  \return the style with the given name, or the null style if no
+   *  style has that name.
    */
   const style &get_style(const std::string &name);
 
+  /** Look up a style in the global registry through a handle. */
+  inline const style &get_style(const style_handle &handle)
+  {
+    return handle.get();
+  }
+
   /** Place a style in the global registry. */
   void set_style(const std::string &name, const style &style);
 }
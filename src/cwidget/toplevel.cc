@@ -25,6 +25,7 @@
 #include "curses++.h"
 #include "style.h"
 
+#include <cwidget/widgets/container.h>
 #include <cwidget/widgets/widget.h>
 
 #include <cwidget/generic/util/transcode.h>
@@ -37,6 +38,7 @@
 #include <cwidget/widgets/table.h>
 #include <cwidget/widgets/text_layout.h>
 #include <cwidget/widgets/tree.h>
+#include <cwidget/widgets/virtual_list.h>
 
 #include <config/keybindings.h>
 
@@ -49,12 +51,17 @@
 
 #include <limits.h>
 #include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <cwidget/generic/util/eassert.h>
 #include <sys/time.h>
 
 #include <map>
+#include <vector>
+
+#include <sigc++/functors/ptr_fun.h>
 
 #include <fcntl.h>
 #include <sys/types.h>
@@ -118,11 +125,15 @@ namespace cwidget
     struct update_state
     {
       bool layout;
+      /** If \b true, the layout is recalculated from scratch instead
+       *  of reusing cached size requests and unchanged windows.
+       */
+      bool remeasure;
       bool update;
       bool cursorupdate;
 
       update_state()
-	:layout(false), update(false), cursorupdate(false)
+	:layout(false), remeasure(false), update(false), cursorupdate(false)
       {
       }
     };
@@ -130,6 +141,26 @@ namespace cwidget
     threads::recursive_mutex pending_updates_mutex;
     update_state pending_updates;
 
+    // tryupdate() puts updates off while more input is waiting to be
+    // read, since the next keystroke will probably change the screen
+    // again; but an update is never put off for longer than this
+    // many milliseconds.
+    static int max_update_latency = 100;
+    // true if an update was put off; update_deferred_since is the
+    // time when that first happened.
+    static bool update_deferred = false;
+    static struct timeval update_deferred_since;
+    // The timeout that forces a deferred update through, or -1.
+    static int deferred_update_timeout_id = -1;
+
+    void set_max_update_latency(int msecs)
+    {
+      max_update_latency = msecs;
+    }
+
+    // Queue an update that was deferred until the input drained.
+    static void post_deferred_update();
+
 
     event::~event()
     {
@@ -143,6 +174,310 @@ namespace cwidget
     static widget_ref toplevel = NULL;
     // The widget which is displayed as the root of everything
 
+    // Collects the keys of multi-key bindings.
+    static key_sequence_matcher key_sequences;
+    // How long to wait for the next key of a sequence.
+    static int key_sequence_timeout = 1000;
+    // The timeout that flushes key_sequences, or -1 if none is queued.
+    static int key_sequence_timeout_id = -1;
+
+    void set_key_sequence_timeout(int msecs)
+    {
+      key_sequence_timeout = msecs;
+    }
+
+    // The number of further copies of the key being dispatched that
+    // no widget has claimed yet.
+    static int pending_key_repeats = 0;
+
+    int take_key_repeats()
+    {
+      const int rval = pending_key_repeats;
+      pending_key_repeats = 0;
+      return rval;
+    }
+
+    // The key codes that curses returns for the start and end of a
+    // bracketed paste, or 0 if they couldn't be defined.
+    static int paste_begin_code = 0, paste_end_code = 0;
+    // true while the text of a bracketed paste is being read.
+    static bool in_paste = false;
+    // The text of the paste that is being read.
+    static std::wstring paste_text;
+    // The number of keys received since the paste began, and the
+    // number when the paste timeout last fired.
+    static unsigned long paste_received = 0, paste_received_checked = 0;
+    // The timeout that ends a paste whose end marker never arrives, or
+    // -1 if none is queued.
+    static int paste_timeout_id = -1;
+    // How long a paste may go without input before it is given up on.
+    static const int paste_timeout = 1000;
+    // Long pastes are delivered in pieces of at most this many
+    // characters.
+    static const std::wstring::size_type max_paste_chunk = 1 << 20;
+
+    // \return the given terminfo string capability, or fallback if
+    // the terminal doesn't define it.
+    static const char *get_terminfo_string(const char *cap, const char *fallback)
+    {
+      const char *rval = tigetstr(cap);
+
+      if(rval == NULL || rval == (char *) -1)
+	return fallback;
+      else
+	return rval;
+    }
+
+    // Make curses report the given escape sequence as a single key.
+    //
+    // \return the code of the key, or 0 if no code is available.
+    static int define_sequence_key(const char *seq)
+    {
+      int code = key_defined(seq);
+      if(code > 0)
+	return code;
+
+      // Find a code that curses isn't using for anything else.
+      for(code = KEY_MAX + 1; code < KEY_MAX + 1024; ++code)
+	{
+	  char *bound = keybound(code, 0);
+	  if(bound == NULL)
+	    return define_key(seq, code) == OK ? code : 0;
+	  free(bound);
+	}
+
+      return 0;
+    }
+
+    // Ask the terminal to mark the beginning and end of pasted text.
+    static void set_bracketed_paste(bool enabled)
+    {
+      if(paste_begin_code == 0 || paste_end_code == 0)
+	return;
+
+      putp(enabled
+	   ? get_terminfo_string("BE", "\033[?2004h")
+	   : get_terminfo_string("BD", "\033[?2004l"));
+      fflush(stdout);
+    }
+
+    // Return a keystroke to the front of curses' input queue, so that
+    // it is the next key read.
+    static void unread_key(const key &k)
+    {
+      if(k.function_key)
+	ungetch(k.ch);
+      else
+	unget_wch(k.ch);
+    }
+
+    // Dispatch a keystroke that was typed repeats+1 times in a row.
+    // The copies that the receiving widget doesn't claim with
+    // take_key_repeats() are dispatched one at a time.
+    //
+    // \return true if the key was handled.
+    static bool dispatch_keystroke(const key &k, int repeats = 0)
+    {
+      static const action_id refresh_action = get_action_id("Refresh");
+
+      if(global_bindings.key_matches(k, refresh_action))
+	{
+	  redraw();
+	  return true;
+	}
+
+      const int suspends = get_suspend_count();
+      bool rval = false;
+
+      for(int remaining = repeats; toplevel.valid(); --remaining)
+	{
+	  pending_key_repeats = remaining;
+	  if(toplevel->dispatch_key(k))
+	    rval = true;
+	  remaining = pending_key_repeats;
+	  pending_key_repeats = 0;
+
+	  if(remaining == 0)
+	    break;
+	  else if(get_suspend_count() != suspends)
+	    {
+	      // The copies were already taken out of the input; give
+	      // them back so that they are read when the program
+	      // resumes.
+	      for( ; remaining > 0; --remaining)
+		unread_key(k);
+	      break;
+	    }
+	}
+
+      return rval;
+    }
+
+    // Dispatch a key produced by the sequence matcher.  If it stands
+    // for a sequence that the focussed widgets don't handle, the keys
+    // that were typed are dispatched instead, so that nothing is lost.
+    static void dispatch_matched_key(const matched_key &m)
+    {
+      if(dispatch_keystroke(m.k) || m.typed.empty())
+	return;
+
+      const int suspends = get_suspend_count();
+
+      for(key_sequence::const_iterator it = m.typed.begin();
+	  it != m.typed.end() && get_suspend_count() == suspends; ++it)
+	dispatch_keystroke(*it);
+    }
+
+    // Match key sequences against the scopes of the widgets that
+    // receive keys: the toplevel widget, the active widget of each
+    // container below it, and the global bindings.
+    static void update_key_sequence_scopes()
+    {
+      std::vector<const config::keybindings *> scopes;
+      scopes.push_back(&global_bindings);
+
+      widget_ref w = toplevel;
+      while(w.valid())
+	{
+	  w->get_binding_scopes(scopes);
+
+	  container *c = dynamic_cast<container *>(w.unsafe_get_ref());
+	  if(c == NULL)
+	    break;
+
+	  w = c->get_active_widget();
+	}
+
+      key_sequences.set_scopes(scopes);
+    }
+
+    // Deliver pasted text to the toplevel widget, falling back to
+    // typing it in if the focussed widget doesn't handle pastes.
+    // Pasted text is never matched against key sequences.
+    static void dispatch_paste(const std::wstring &text)
+    {
+      if(text.empty() || !toplevel.valid() || toplevel->dispatch_paste(text))
+	return;
+
+      const int suspends = get_suspend_count();
+
+      for(std::wstring::const_iterator it = text.begin();
+	  it != text.end() && get_suspend_count() == suspends; ++it)
+	dispatch_keystroke(key(*it, false));
+    }
+
+    // The most copies of a key that are read ahead at once.  Copies
+    // that are not handled might have to be pushed back, and curses
+    // only has room for a limited number of those.
+    static const int max_key_repeats = 64;
+
+    static void paste_timed_out();
+
+    static void queue_paste_timeout()
+    {
+      paste_received_checked = paste_received;
+      paste_timeout_id =
+	addtimeout(new slot_event(sigc::ptr_fun(&paste_timed_out)),
+		   paste_timeout);
+    }
+
+    static void begin_paste()
+    {
+      in_paste = true;
+      paste_text.clear();
+      paste_received = 0;
+      queue_paste_timeout();
+    }
+
+    // Deliver the text of the paste that is being read, and return to
+    // normal input.
+    static void end_paste()
+    {
+      if(paste_timeout_id != -1)
+	{
+	  deltimeout(paste_timeout_id);
+	  paste_timeout_id = -1;
+	}
+
+      std::wstring text;
+      text.swap(paste_text);
+      in_paste = false;
+
+      dispatch_paste(text);
+    }
+
+    // If the terminal dropped the end of a paste, or a stray start
+    // marker arrived, every key would be taken as pasted text; give up
+    // on the paste once input stops arriving.
+    static void paste_timed_out()
+    {
+      paste_timeout_id = -1;
+
+      if(!in_paste)
+	return;
+
+      if(paste_received != paste_received_checked)
+	queue_paste_timeout();
+      else
+	end_paste();
+    }
+
+    // Read the copies of the given keystroke that are waiting in the
+    // input buffer, stopping at (and pushing back) the first
+    // different key.
+    //
+    // \return the number of copies that were read.
+    static int read_key_repeats(wint_t wch, int status)
+    {
+      int rval = 0;
+      wint_t next;
+      int next_status;
+
+      while(rval < max_key_repeats && (next_status = get_wch(&next)) != ERR)
+	{
+	  if(next == wch && next_status == status)
+	    ++rval;
+	  else
+	    {
+	      unread_key(key(next, next_status == KEY_CODE_YES));
+	      break;
+	    }
+	}
+
+      return rval;
+    }
+
+    static void key_sequence_timed_out();
+
+    static void queue_key_sequence_timeout()
+    {
+      if(key_sequence_timeout_id != -1)
+	{
+	  deltimeout(key_sequence_timeout_id);
+	  key_sequence_timeout_id = -1;
+	}
+
+      if(key_sequences.is_pending())
+	key_sequence_timeout_id =
+	  addtimeout(new slot_event(sigc::ptr_fun(&key_sequence_timed_out)),
+		     key_sequence_timeout);
+    }
+
+    static void key_sequence_timed_out()
+    {
+      key_sequence_timeout_id = -1;
+
+      std::vector<matched_key> keys;
+      update_key_sequence_scopes();
+      key_sequences.flush(keys);
+
+      for(std::vector<matched_key>::const_iterator it = keys.begin();
+	  it != keys.end(); ++it)
+	dispatch_matched_key(*it);
+
+      queue_key_sequence_timeout();
+    }
+
     // Cleanly shutdown (eg, restore screen settings if possible)
     //
     // Called on SIGTERM, SIGINT, SIGSEGV, SIGABRT, and SIGQUIT
@@ -150,6 +485,8 @@ namespace cwidget
     // FIXME: revert to the /previous/ handler, not just SIG_DFL?
     static void sigkilled(int sig)
     {
+      // Otherwise pastes into the shell arrive wrapped in markers.
+      set_bracketed_paste(false);
       endwin();
 
       switch(sig)
@@ -205,6 +542,8 @@ namespace cwidget
     }
     ///////////////////////////////////////////////////////////////////////////////
 
+    static void redraw_all(bool clear);
+
     widget_ref settoplevel(const widget_ref &w)
     {
       if(toplevel.valid())
@@ -219,7 +558,8 @@ namespace cwidget
 	  toplevel->set_owner_window(rootwin, 0, 0, rootwin.getmaxx(), rootwin.getmaxy());
 	  toplevel->show_all();
 	  toplevel->focussed();
-	  redraw();
+	  // The terminal is fine; only the new widget has to be drawn.
+	  redraw_all(false);
 	}
 
       return oldw;
@@ -371,6 +711,10 @@ namespace cwidget
 		      beep();
 		    }
 
+		  // All the typeahead has been handled; draw what
+		  // it did.
+		  post_deferred_update();
+
 		  threads::mutex::lock l(m);
 		  b = true;
 		  c.wake_all();
@@ -392,12 +736,81 @@ namespace cwidget
 			  toplevel->dispatch_mouse(ev.id, ev.x, ev.y, ev.z, ev.bstate);
 			}
 		    }
+		  else if(paste_begin_code != 0 && k == key(paste_begin_code, true))
+		    {
+		      if(!in_paste)
+			begin_paste();
+		    }
+		  else if(in_paste)
+		    {
+		      // Collect the whole paste, even if it arrives over
+		      // several input events, and deliver it at once.
+		      ++paste_received;
+
+		      if(k == key(paste_end_code, true))
+			end_paste();
+		      else if(!k.function_key)
+			{
+			  paste_text.push_back(wch);
+
+			  if(paste_text.size() >= max_paste_chunk)
+			    {
+			      std::wstring text;
+			      text.swap(paste_text);
+			      dispatch_paste(text);
+			    }
+			}
+		    }
 		  else
 		    {
-		      if(global_bindings.key_matches(k, "Refresh"))
-			redraw();
+		      // When a key is held down, or the program falls
+		      // behind the user, the same key is often waiting
+		      // several times over; collect the copies so that
+		      // widgets can handle them in one operation.
+		      const int repeats = read_key_repeats(wch, status);
+
+		      std::vector<matched_key> keys;
+		      update_key_sequence_scopes();
+		      key_sequences.feed(k, keys);
+
+		      if(repeats > 0 && keys.size() == 1 && keys.front().k == k &&
+			 !key_sequences.is_pending())
+			dispatch_keystroke(k, repeats);
 		      else
-			toplevel->dispatch_key(k);
+			{
+			  for(int i = 0; i < repeats; ++i)
+			    key_sequences.feed(k, keys);
+
+			  for(std::vector<matched_key>::const_iterator it = keys.begin();
+			      it != keys.end(); ++it)
+			    {
+			      if(get_suspend_count() != my_suspend_count)
+				{
+				  // Keep the keys that weren't dispatched
+				  // for when the program resumes.
+				  for(std::vector<matched_key>::const_iterator u = keys.end();
+				      u != it; )
+				    {
+				      --u;
+				      if(u->typed.empty())
+					unread_key(u->k);
+				      else
+					for(key_sequence::const_reverse_iterator t = u->typed.rbegin();
+					    t != u->typed.rend(); ++t)
+					  unread_key(*t);
+				    }
+
+				  return;
+				}
+
+			      dispatch_matched_key(*it);
+			    }
+			}
+
+		      if(get_suspend_count() != my_suspend_count)
+			return;
+
+		      queue_key_sequence_timeout();
 		    }
 		}
 	    }
@@ -921,6 +1334,10 @@ namespace cwidget
       rootwin.nodelay(true);
       rootwin.keypad(true);
 
+      paste_begin_code = define_sequence_key(get_terminfo_string("PS", "\033[200~"));
+      paste_end_code = define_sequence_key(get_terminfo_string("PE", "\033[201~"));
+      set_bracketed_paste(true);
+
       global_bindings.set("Quit", quitkey);
       global_bindings.set("Cycle", key(L'\t', false));
       global_bindings.set("Refresh", KEY_CTRL(L'l'));
@@ -970,6 +1387,7 @@ namespace cwidget
       table::init_bindings();
       text_layout::init_bindings();
       tree::init_bindings();
+      virtual_list::init_bindings();
 
       set_style("Error",
 		style_fg(COLOR_WHITE)+style_bg(COLOR_RED)+style_attrs_on(A_BOLD));
@@ -1047,6 +1465,82 @@ namespace cwidget
       }
     };
 
+    // Fires when a deferred update has waited as long as it may.
+    class deferred_update_event : public event
+    {
+    public:
+      void dispatch()
+      {
+	deferred_update_timeout_id = -1;
+	tryupdate();
+      }
+    };
+
+    static void post_deferred_update()
+    {
+      if(update_deferred)
+	post_event(new try_update_event);
+    }
+
+    // \return true if there is unread input, either on the terminal
+    // or already inside curses: keys that were pushed back, or the
+    // rest of a read that returned several keys at once.
+    static bool input_pending()
+    {
+      fd_set readfds;
+      FD_ZERO(&readfds);
+      FD_SET(0, &readfds);
+
+      struct timeval zero;
+      zero.tv_sec = 0;
+      zero.tv_usec = 0;
+
+      if(select(1, &readfds, NULL, NULL, &zero) > 0)
+	return true;
+
+      // select() can't see curses' own buffer, and curses has no way
+      // to ask about it, so try to read a key and put it back.  The
+      // input is in nodelay mode, so this doesn't block.
+      wint_t wch;
+      const int status = get_wch(&wch);
+      if(status == ERR)
+	return false;
+
+      unread_key(key(wch, status == KEY_CODE_YES));
+      return true;
+    }
+
+    // Decide whether tryupdate() should put off the given update
+    // because more input is waiting.
+    static bool defer_update(const update_state &needs)
+    {
+      if(!(needs.layout || needs.update || needs.cursorupdate) ||
+	 max_update_latency <= 0 || !input_pending())
+	return false;
+
+      struct timeval now;
+      gettimeofday(&now, NULL);
+
+      if(!update_deferred)
+	{
+	  update_deferred = true;
+	  update_deferred_since = now;
+	}
+
+      const long waited =
+	(now.tv_sec - update_deferred_since.tv_sec) * 1000 +
+	(now.tv_usec - update_deferred_since.tv_usec) / 1000;
+
+      if(waited >= max_update_latency)
+	return false;
+
+      if(deferred_update_timeout_id == -1)
+	deferred_update_timeout_id =
+	  addtimeout(new deferred_update_event, max_update_latency - waited);
+
+      return true;
+    }
+
     void updatecursor()
     {
       threads::mutex::lock l(pending_updates_mutex);
@@ -1069,6 +1563,89 @@ namespace cwidget
 	toplevel->win.leaveok(true);
     }
 
+    static bool collect_update_statistics = false;
+    static update_statistics statistics;
+
+    void set_collect_update_statistics(bool collect)
+    {
+      threads::mutex::lock l(get_mutex());
+
+      collect_update_statistics = collect;
+    }
+
+    update_statistics get_update_statistics()
+    {
+      threads::mutex::lock l(get_mutex());
+
+      return statistics;
+    }
+
+    void reset_update_statistics()
+    {
+      threads::mutex::lock l(get_mutex());
+
+      statistics = update_statistics();
+    }
+
+    static bool same_cell(const cchar_t &a, const cchar_t &b)
+    {
+      wchar_t wch_a[CCHARW_MAX + 1], wch_b[CCHARW_MAX + 1];
+      attr_t attrs_a, attrs_b;
+      short pair_a, pair_b;
+
+      getcchar(&a, wch_a, &attrs_a, &pair_a, NULL);
+      getcchar(&b, wch_b, &attrs_b, &pair_b, NULL);
+
+      return attrs_a == attrs_b && pair_a == pair_b && wcscmp(wch_a, wch_b) == 0;
+    }
+
+    /** Count the lines and cells that the next doupdate() will have
+     *  to look at and send.
+     */
+    static void count_update()
+    {
+      ++statistics.updates;
+
+      const int rows = _getmaxy(newscr), cols = _getmaxx(newscr);
+      const bool cleared = is_cleared(newscr) || is_cleared(curscr);
+
+      // Reading the cells moves the cursor, which doupdate() uses.
+      int cury, curx;
+      _getyx(newscr, cury, curx);
+
+      std::vector<cchar_t> new_line(cols + 1), cur_line(cols + 1);
+      for(int y = 0; y < rows; ++y)
+	{
+	  if(!cleared && !is_linetouched(newscr, y))
+	    continue;
+
+	  ++statistics.lines;
+
+	  if(cleared)
+	    {
+	      statistics.changed_cells += cols;
+	      continue;
+	    }
+
+	  mvwin_wchnstr(newscr, y, 0, &new_line[0], cols);
+	  mvwin_wchnstr(curscr, y, 0, &cur_line[0], cols);
+	  for(int x = 0; x < cols; ++x)
+	    if(!same_cell(new_line[x], cur_line[x]))
+	      ++statistics.changed_cells;
+	}
+
+      wmove(newscr, cury, curx);
+    }
+
+    /** Send the pending changes to the terminal. */
+    static void update_terminal()
+    {
+      if(collect_update_statistics)
+	count_update();
+
+      doupdate();
+    }
+
     void update()
     {
       threads::mutex::lock l(pending_updates_mutex);
@@ -1079,13 +1656,20 @@ namespace cwidget
       post_event(new try_update_event);
     }
 
+    /** \return the style in which the whole screen is drawn. */
+    static const style &get_default_style()
+    {
+      static const style_handle default_style("Default");
+      return get_style(default_style);
+    }
+
     void updatenow()
     {
       threads::mutex::lock l(get_mutex());
 
       if(toplevel.valid())
 	{
-	  toplevel->display(get_style("Default"));
+	  toplevel->display(get_default_style());
 	  toplevel->sync();
 	}
     }
@@ -1094,6 +1678,18 @@ namespace cwidget
     {
       threads::mutex::lock l(pending_updates_mutex);
 
+      pending_updates.layout = true;
+      pending_updates.remeasure = true;
+      pending_updates.update = true;
+      pending_updates.cursorupdate = true;
+
+      post_event(new try_update_event);
+    }
+
+    void queue_relayout()
+    {
+      threads::mutex::lock l(pending_updates_mutex);
+
       pending_updates.layout = true;
       pending_updates.update = true;
       pending_updates.cursorupdate = true;
@@ -1105,6 +1701,8 @@ namespace cwidget
     {
       threads::mutex::lock l(get_mutex());
 
+      widgets::widget::discard_size_requests();
+      widgets::widget::discard_layouts();
       toplevel->do_layout();
     }
 
@@ -1116,8 +1714,25 @@ namespace cwidget
 
       update_state needs = pending_updates;
 
+      if(defer_update(needs))
+	return;
+
+      update_deferred = false;
+      if(deferred_update_timeout_id != -1)
+	{
+	  deltimeout(deferred_update_timeout_id);
+	  deferred_update_timeout_id = -1;
+	}
+
       if(needs.layout)
-	layoutnow();
+	{
+	  if(needs.remeasure)
+	    {
+	      widgets::widget::discard_size_requests();
+	      widgets::widget::discard_layouts();
+	    }
+	  toplevel->do_layout();
+	}
 
       if(needs.update)
 	updatenow();
@@ -1125,7 +1740,7 @@ namespace cwidget
       if(needs.update || needs.cursorupdate)
 	updatecursornow();
 
-      doupdate();
+      update_terminal();
 
       // \todo This appears to just paper over sloppiness -- screen update
       // routines shouldn't be queuing more updates!
@@ -1206,6 +1821,7 @@ namespace cwidget
       rootwin.bkgdset(' ');
       rootwin.clear();
       rootwin.refresh();
+      set_bracketed_paste(false);
       endwin();
       curses_avail=false;
     }
@@ -1259,19 +1875,27 @@ namespace cwidget
       if(toplevel.valid())
 	{
 	  toplevel->set_owner_window(rootwin, 0, 0, rootwin.getmaxx(), rootwin.getmaxy());
-	  toplevel->display(get_style("Default"));
+	  toplevel->display(get_default_style());
 	  toplevel->sync();
-	  doupdate();
+	  update_terminal();
 	}
       else
 	refresh();
 
+      set_bracketed_paste(true);
+
       input_thread::start();
       signal_thread::start();
       timeout_thread::start();
     }
 
-    void redraw()
+    /** Lay out and display every widget.
+     *
+     *  \param clear if \b true, clear the terminal and send the whole
+     *  screen again, in case its contents were garbled; otherwise only
+     *  the cells that changed are sent.
+     */
+    static void redraw_all(bool clear)
     {
       threads::mutex::lock l(get_mutex());
 
@@ -1280,14 +1904,16 @@ namespace cwidget
       if(toplevel.valid())
 	{
 	  toplevel->focussed();
-	  toplevel->get_win().touch();
-	  toplevel->get_win().clearok(true);
+	  // Clearing curscr makes the next update repaint everything.
+	  if(clear)
+	    clearok(curscr, true);
+	  widgets::widget::discard_size_requests();
+	  widgets::widget::discard_layouts();
 	  toplevel->do_layout();
-	  toplevel->display(get_style("Default"));
+	  toplevel->display(get_default_style());
 	  updatecursornow();
 	  toplevel->sync();
-	  doupdate();
-	  toplevel->get_win().clearok(false);
+	  update_terminal();
 	}
 
       // For reasons that aren't entirely clear, running a tryupdate()
@@ -1297,6 +1923,11 @@ namespace cwidget
       pending_updates = update_state();
     }
 
+    void redraw()
+    {
+      redraw_all(true);
+    }
+
     int addtimeout(event *ev, int msecs)
     {
       if(msecs < 0)
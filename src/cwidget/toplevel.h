@@ -116,10 +116,19 @@ namespace cwidget
     util::ref_ptr<widgets::widget> settoplevel(const util::ref_ptr<widgets::widget> &widget);
 
     /** Posts a request to recalculate every widget's layout and update
-     *  the screen.  May be called from any thread.
+     *  the screen.  Every widget's size is measured again.  May be
+     *  called from any thread.
      */
     void queuelayout();
 
+    /** Posts a request to update the layout and the screen.  Only
+     *  the widgets that called widgets::widget::queue_layout() or
+     *  widgets::widget::size_changed(), their ancestors, and widgets
+     *  whose allocation changes as a result are laid out again.
+     *  Must be called from the main thread.
+     */
+    void queue_relayout();
+
     /** \brief Immediately recalculates the layout of all widgets. */
     void layoutnow();
 
@@ -174,9 +183,63 @@ namespace cwidget
     /** Posts a request to redraw the screen; may be called from any thread. */
     void update();
 
-    /** Executes any pending draws or redraws. */
+    /** Executes any pending draws or redraws.
+     *
+     *  If more input is already waiting to be read, the update is put
+     *  off until it has been handled, so that a burst of keystrokes
+     *  is drawn once; see set_max_update_latency().
+     */
     void tryupdate();
 
+    /** Set the longest time, in milliseconds, that tryupdate() will
+     *  put off an update because input is waiting.  0 disables the
+     *  check.  The default is 100.
+     */
+    void set_max_update_latency(int msecs);
+
+    /** \brief Counts of the work done to bring the terminal up to
+     *  date.
+     */
+    struct update_statistics
+    {
+      /** The number of times the terminal was updated. */
+      unsigned long updates;
+
+      /** The number of screen lines that were compared with the
+       *  terminal's contents.
+       */
+      unsigned long lines;
+
+      /** The number of character cells that differed from the
+       *  terminal's contents, and so had to be sent to it.
+       *
+       *  This is only an approximation of the output: curses writes
+       *  to the terminal itself, so the bytes it sends can't be
+       *  counted.  Cursor motion, attribute changes and multibyte
+       *  characters make the real number larger, while curses may
+       *  use scrolling or insert/delete operations to send less.
+       */
+      unsigned long changed_cells;
+
+      update_statistics()
+	:updates(0), lines(0), changed_cells(0)
+      {
+      }
+    };
+
+    /** Start or stop collecting update statistics.  Counting the
+     *  changed cells costs about as much as the update itself, so
+     *  this is off by default.
+     */
+    void set_collect_update_statistics(bool collect);
+
+    /** \return the statistics collected since the last call to
+     *  reset_update_statistics().
+     */
+    update_statistics get_update_statistics();
+
+    void reset_update_statistics();
+
     /** Posts a request to update the cursor location; may be called from
      *  any thread.
      */
@@ -217,6 +280,29 @@ namespace cwidget
     /** Delete the event with the given identifier. */
     void deltimeout(int id);
 
+    /** Set how long to wait for the next key of a key sequence (see
+     *  config::keybindings::set_sequences) before giving up and
+     *  handling the keys typed so far on their own.  The default is
+     *  one second.
+     */
+    void set_key_sequence_timeout(int msecs);
+
+    /** \brief Claim the queued copies of the key that is being
+     *  dispatched.
+     *
+     *  When a key is held down, copies of it pile up in the input
+     *  buffer faster than they can be handled.  The main loop collects
+     *  such runs and dispatches the key once; a widget whose response
+     *  to the key is cheaper in bulk (for instance, moving down N lines
+     *  at once) can call this from its key handler to find out how
+     *  many more copies there were.  Copies that are not claimed this
+     *  way are dispatched one at a time as usual.
+     *
+     *  \return the number of additional copies of the current key
+     *  (0 if there are none, or outside of key dispatch).
+     */
+    int take_key_repeats();
+
     void handleresize();
     // Does anything needed to handle a window resize event.
     // FIXME: I --think-- that this is now redundant
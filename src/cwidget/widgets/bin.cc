@@ -58,7 +58,7 @@ namespace cwidget
 	    w->focussed();
 	}
 
-      toplevel::queuelayout();
+      size_changed();
     }
 
     void bin::destroy()
@@ -151,5 +151,19 @@ namespace cwidget
       if(subwidget.valid() && subwidget->get_visible())
 	subwidget->display(st);
     }
+
+    rect bin::get_opaque_region()
+    {
+      widget_ref tmpref(this);
+
+      if(!get_win() || get_opaque() ||
+	 !subwidget.valid() || !subwidget->get_visible())
+	return widget::get_opaque_region();
+
+      rect rval = subwidget->get_opaque_region();
+      rval.x += subwidget->get_startx();
+      rval.y += subwidget->get_starty();
+      return rval;
+    }
   }
 }
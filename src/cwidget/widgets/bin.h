@@ -53,6 +53,11 @@ namespace cwidget
       widget_ref get_focus();
 
       void paint(const style &st);
+
+      /** A bin that isn't opaque still covers whatever its child
+       *  covers.
+       */
+      rect get_opaque_region();
     };
   }
 }
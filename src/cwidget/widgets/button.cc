@@ -129,10 +129,13 @@ namespace cwidget
 
     bool button::handle_key(const config::key &k)
     {
+      static const config::action_id push_button_action = config::get_action_id("PushButton");
+      static const config::action_id confirm_action = config::get_action_id("Confirm");
+
       widget_ref tmpref(this);
 
-      if(config::global_bindings.key_matches(k, "PushButton") ||
-	 config::global_bindings.key_matches(k, "Confirm"))
+      if(config::global_bindings.key_matches(k, push_button_action) ||
+	 config::global_bindings.key_matches(k, confirm_action))
 	{
 	  pressed();
 	  return true;
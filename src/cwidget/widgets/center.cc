@@ -23,7 +23,7 @@ namespace cwidget
       widget_ref subwidget = get_subwidget();
 
       if(subwidget.valid() && subwidget->get_visible())
-	return subwidget->width_request();
+	return subwidget->get_width_request();
       else
 	return 0;
     }
@@ -35,7 +35,7 @@ namespace cwidget
       widget_ref subwidget = get_subwidget();
 
       if(subwidget.valid() && subwidget->get_visible())
-	return subwidget->height_request(width);
+	return subwidget->get_height_request(width);
       else
 	return 0;
     }
@@ -50,11 +50,11 @@ namespace cwidget
 	{
 	  if(child->get_visible())
 	    {
-	      int child_w=child->width_request();
+	      int child_w=child->get_width_request();
 	      if(child_w>getmaxx())
 		child_w=getmaxx();
 
-	      int child_h=child->height_request(child_w);
+	      int child_h=child->get_height_request(child_w);
 	      if(child_h>getmaxy())
 		child_h=getmaxy();
 	      child->alloc_size((getmaxx()-child_w)/2, (getmaxy()-child_h)/2, child_w, child_h);
@@ -0,0 +1,301 @@
+// completion.cc
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include "completion.h"
+
+#include <cwidget/toplevel.h>
+#include <cwidget/generic/threads/event_queue.h>
+#include <cwidget/generic/util/eassert.h>
+#include <cwidget/generic/util/exception.h>
+
+#include <exception>
+
+using namespace std;
+
+namespace cwidget
+{
+  namespace widgets
+  {
+    /** Hands the pending candidates of a request to the main thread.
+     *  The event owns a reference to the request, which the creator
+     *  must have added.
+     */
+    class completion_request::delivery_event : public toplevel::event
+    {
+      completion_request *req;
+
+    public:
+      delivery_event(completion_request *_req)
+	:req(_req)
+      {
+      }
+
+      ~delivery_event()
+      {
+	req->decref();
+      }
+
+      void dispatch()
+      {
+	req->deliver();
+      }
+    };
+
+    namespace
+    {
+      struct completion_job
+      {
+	completion_provider *provider;
+	wstring text;
+	completion_request *req;
+
+	completion_job()
+	  :provider(NULL), req(NULL)
+	{
+	}
+
+	completion_job(completion_provider *_provider,
+		       const wstring &_text,
+		       completion_request *_req)
+	  :provider(_provider), text(_text), req(_req)
+	{
+	}
+      };
+
+      /** The requests waiting for the completion thread.  This is
+       *  never deleted, since the thread might still be waiting on it
+       *  when the program exits.
+       */
+      threads::event_queue<completion_job> &get_completion_queue()
+      {
+	static threads::event_queue<completion_job> *q =
+	  new threads::event_queue<completion_job>;
+	return *q;
+      }
+
+      /** Runs the submitted requests, one at a time. */
+      class completion_thread
+      {
+      public:
+	void operator()() const
+	{
+	  threads::event_queue<completion_job> &q(get_completion_queue());
+
+	  while(1)
+	    {
+	      const completion_job job = q.get();
+
+	      if(!job.req->is_cancelled())
+		{
+		  try
+		    {
+		      job.provider->complete(job.text, *job.req);
+		    }
+		  catch(util::Exception &)
+		    {
+		      // The candidates found so far are still good.
+		    }
+		  catch(std::exception &)
+		    {
+		    }
+		}
+
+	      job.req->finish();
+	      job.req->decref();
+	    }
+	}
+      };
+
+      threads::mutex completion_thread_mutex;
+      threads::thread *completion_thread_instance = NULL;
+
+      /** Start the completion thread if it isn't running yet.  It is
+       *  never stopped; it just waits for more requests.
+       */
+      void start_completion_thread()
+      {
+	threads::mutex::lock l(completion_thread_mutex);
+
+	if(completion_thread_instance == NULL)
+	  completion_thread_instance = new threads::thread(completion_thread());
+      }
+    }
+
+    completion_provider::~completion_provider()
+    {
+    }
+
+    completion_request::completion_request(const result_slot &_receiver)
+      :refcount(1), cancelled(false), finished(false), event_posted(false),
+       receiver(_receiver)
+    {
+    }
+
+    completion_request *completion_request::create(const result_slot &receiver)
+    {
+      return new completion_request(receiver);
+    }
+
+    void completion_request::incref()
+    {
+      threads::mutex::lock l(m);
+
+      ++refcount;
+    }
+
+    void completion_request::decref()
+    {
+      bool last;
+
+      {
+	threads::mutex::lock l(m);
+
+	eassert(refcount > 0);
+	--refcount;
+	last = (refcount == 0);
+      }
+
+      if(last)
+	delete this;
+    }
+
+    bool completion_request::is_cancelled() const
+    {
+      threads::mutex::lock l(m);
+
+      return cancelled;
+    }
+
+    bool completion_request::is_finished() const
+    {
+      threads::mutex::lock l(m);
+
+      return finished;
+    }
+
+    void completion_request::post_delivery()
+    {
+      if(!event_posted)
+	{
+	  event_posted = true;
+	  // The lock is already held, so don't use incref().
+	  ++refcount;
+	  toplevel::post_event(new delivery_event(this));
+	}
+    }
+
+    void completion_request::add_candidate(const wstring &candidate)
+    {
+      threads::mutex::lock l(m);
+
+      if(cancelled || finished)
+	return;
+
+      pending.push_back(candidate);
+      post_delivery();
+    }
+
+    void completion_request::add_candidates(const vector<wstring> &candidates)
+    {
+      if(candidates.empty())
+	return;
+
+      threads::mutex::lock l(m);
+
+      if(cancelled || finished)
+	return;
+
+      pending.insert(pending.end(), candidates.begin(), candidates.end());
+      post_delivery();
+    }
+
+    void completion_request::finish()
+    {
+      threads::mutex::lock l(m);
+
+      if(cancelled || finished)
+	return;
+
+      finished = true;
+      post_delivery();
+    }
+
+    void completion_request::cancel()
+    {
+      threads::mutex::lock l(m);
+
+      cancelled = true;
+      pending.clear();
+      receiver = result_slot();
+    }
+
+    void completion_request::deliver()
+    {
+      vector<wstring> results;
+      bool last;
+
+      {
+	threads::mutex::lock l(m);
+
+	event_posted = false;
+	if(cancelled)
+	  return;
+
+	results.swap(pending);
+	last = finished;
+      }
+
+      // Once the last batch is delivered, further events (there
+      // shouldn't be any) have nothing to do.
+      result_slot r(receiver);
+      if(last)
+	receiver = result_slot();
+
+      if(!r.empty())
+	r(results, last);
+    }
+
+    void completion_request::submit(completion_provider *provider,
+				    const wstring &text)
+    {
+      eassert(provider != NULL);
+
+      start_completion_thread();
+
+      incref();
+      get_completion_queue().put(completion_job(provider, text, this));
+    }
+
+    wstring common_prefix(const vector<wstring> &candidates)
+    {
+      if(candidates.empty())
+	return wstring();
+
+      wstring::size_type len = candidates[0].size();
+      for(vector<wstring>::const_iterator it = candidates.begin() + 1;
+	  it != candidates.end() && len > 0; ++it)
+	{
+	  wstring::size_type i = 0;
+	  while(i < len && i < it->size() && (*it)[i] == candidates[0][i])
+	    ++i;
+	  len = i;
+	}
+
+      return wstring(candidates[0], 0, len);
+    }
+  }
+}
@@ -0,0 +1,174 @@
+// completion.h                                           -*-c++-*-
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+//
+// Background completion of the text in an editline.
+
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <cwidget/generic/threads/threads.h>
+
+#include <sigc++/functors/slot.h>
+
+#include <string>
+#include <vector>
+
+namespace cwidget
+{
+  namespace widgets
+  {
+    class completion_provider;
+
+    /** \brief A single request for completions.
+     *
+     *  A provider reports the candidates it finds by calling
+     *  add_candidate() or add_candidates() as it goes, from its own
+     *  thread.  The candidates are collected and handed to the main
+     *  thread in batches, using a posted event, so the receiver sees
+     *  the first results while the provider is still working.
+     *
+     *  A request is cancelled when its results are no longer wanted
+     *  (for instance, because the text it was completing has
+     *  changed).  Providers should check is_cancelled() regularly and
+     *  return early if it is set; candidates added after a request is
+     *  cancelled are dropped.
+     *
+     *  Requests are reference-counted, and the count is protected by
+     *  a lock, so a request may be released from any thread.
+     */
+    class completion_request
+    {
+    public:
+      /** The slot that receives batches of candidates in the main
+       *  thread.  Its second argument is \b true for the last batch.
+       */
+      typedef sigc::slot2<void, const std::vector<std::wstring> &, bool> result_slot;
+
+    private:
+      mutable threads::mutex m;
+      int refcount;
+
+      bool cancelled;
+      bool finished;
+
+      /** \b true if an event that will deliver the pending candidates
+       *  is in the main queue.
+       */
+      bool event_posted;
+
+      std::vector<std::wstring> pending;
+
+      /** Only touched from the main thread. */
+      result_slot receiver;
+
+      class delivery_event;
+
+      completion_request(const completion_request &other);
+      completion_request &operator=(const completion_request &other);
+
+      explicit completion_request(const result_slot &_receiver);
+
+      /** Post an event to deliver the pending candidates, unless one
+       *  is already queued.  The lock must be held.
+       */
+      void post_delivery();
+
+      /** Hand the pending candidates to the receiver.  Invoked in the
+       *  main thread.
+       */
+      void deliver();
+
+    public:
+      /** Create a request whose results are passed to the given slot.
+       *  The new request has a reference count of 1.  Must be invoked
+       *  from the main thread.
+       */
+      static completion_request *create(const result_slot &receiver);
+
+      void incref();
+      void decref();
+
+      /** \return \b true if the results of this request are no
+       *  longer wanted.
+       */
+      bool is_cancelled() const;
+
+      /** \return \b true if the provider is done with this request. */
+      bool is_finished() const;
+
+      /** Report a single candidate. */
+      void add_candidate(const std::wstring &candidate);
+
+      /** Report several candidates at once. */
+      void add_candidates(const std::vector<std::wstring> &candidates);
+
+      /** Note that the provider is done.  The receiver is invoked
+       *  with \b true as its second argument exactly once, unless
+       *  the request is cancelled first.
+       */
+      void finish();
+
+      /** Discard the results of this request.  Must be invoked from
+       *  the main thread; the receiver is not invoked after this
+       *  returns.
+       */
+      void cancel();
+
+      /** Queue a call to provider->complete() in the background
+       *  completion thread, followed by finish().  Requests are
+       *  handled one at a time, in the order that they were
+       *  submitted; cancelled requests that haven't started yet are
+       *  skipped.
+       */
+      void submit(completion_provider *provider, const std::wstring &text);
+    };
+
+    /** \brief Computes the ways in which some text could be
+     *  completed.
+     *
+     *  complete() runs in a background thread, so that a large set
+     *  of candidates doesn't block the user interface.  It must not
+     *  touch any widgets, and anything it shares with the rest of the
+     *  program must be protected by a lock.
+     *
+     *  The same provider may be used by several editlines, and is
+     *  never deleted by them; it must remain valid while any request
+     *  that uses it might be running.
+     */
+    class completion_provider
+    {
+    public:
+      /** Find the completions of the given text.
+       *
+       *  \param text the text to complete (the part of an editline's
+       *  text before the cursor).
+       *
+       *  \param req where to report candidates.  Each candidate
+       *  replaces text when it is chosen.
+       */
+      virtual void complete(const std::wstring &text,
+			    completion_request &req) = 0;
+
+      virtual ~completion_provider();
+    };
+
+    /** \return the longest string that is a prefix of every candidate. */
+    std::wstring common_prefix(const std::vector<std::wstring> &candidates);
+  }
+}
+
+#endif // COMPLETION_H
@@ -0,0 +1,298 @@
+// edit_history.cc
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include "edit_history.h"
+
+#include <cwidget/generic/util/transcode.h>
+
+#include <errno.h>
+#include <stdio.h>
+
+using namespace std;
+
+namespace cwidget
+{
+  namespace widgets
+  {
+    namespace
+    {
+      /** The encoding of history files, regardless of the locale. */
+      const char * const history_encoding = "UTF-8";
+
+      /** Rewrite the history file once it has this many times more
+       *  lines than there are entries (plus some slack so that small
+       *  histories aren't rewritten constantly).
+       */
+      const edit_history::size_type compact_ratio = 2;
+      const edit_history::size_type compact_slack = 64;
+
+      string escape_line(const wstring &s)
+      {
+	string encoded;
+	util::transcode(s, encoded, history_encoding);
+
+	string rval;
+	rval.reserve(encoded.size() + 1);
+	for(string::const_iterator it = encoded.begin(); it != encoded.end(); ++it)
+	  {
+	    if(*it == '\\')
+	      rval += "\\\\";
+	    else if(*it == '\n')
+	      rval += "\\n";
+	    else
+	      rval += *it;
+	  }
+
+	rval += '\n';
+	return rval;
+      }
+
+      wstring unescape_line(const string &line)
+      {
+	string decoded;
+	decoded.reserve(line.size());
+	for(string::size_type i = 0; i < line.size(); ++i)
+	  {
+	    if(line[i] == '\\' && i + 1 < line.size())
+	      {
+		++i;
+		decoded += (line[i] == 'n' ? '\n' : line[i]);
+	      }
+	    else
+	      decoded += line[i];
+	  }
+
+	wstring rval;
+	util::transcode(decoded, rval, history_encoding);
+	return rval;
+      }
+
+      /** Write the given lines to filename, replacing its contents.
+       *  The lines are written to a temporary file that is then
+       *  renamed, so a crash never leaves a truncated history.
+       */
+      bool write_lines(const string &filename, const deque<wstring> &entries)
+      {
+	const string tmpname = filename + ".new";
+	FILE *f = fopen(tmpname.c_str(), "w");
+	if(f == NULL)
+	  return false;
+
+	for(deque<wstring>::const_iterator it = entries.begin();
+	    it != entries.end(); ++it)
+	  fputs(escape_line(*it).c_str(), f);
+
+	if(ferror(f))
+	  {
+	    const int err = errno;
+	    fclose(f);
+	    remove(tmpname.c_str());
+	    errno = err;
+	    return false;
+	  }
+
+	if(fclose(f) != 0)
+	  {
+	    const int err = errno;
+	    remove(tmpname.c_str());
+	    errno = err;
+	    return false;
+	  }
+
+	if(rename(tmpname.c_str(), filename.c_str()) != 0)
+	  {
+	    const int err = errno;
+	    remove(tmpname.c_str());
+	    errno = err;
+	    return false;
+	  }
+
+	return true;
+      }
+    }
+
+    edit_history::edit_history(size_type _capacity, bool _dedup)
+      : capacity(_capacity), dedup(_dedup), file_lines(0)
+    {
+    }
+
+    const edit_history::size_type edit_history::npos;
+
+    bool edit_history::do_add(const wstring &s)
+    {
+      int &count = counts[s];
+
+      if(dedup && count > 0)
+	{
+	  // The most common duplicate is the last entry entered again.
+	  if(entries.back() == s)
+	    return false;
+
+	  for(deque<wstring>::iterator it = entries.begin();
+	      it != entries.end(); ++it)
+	    if(*it == s)
+	      {
+		entries.erase(it);
+		--count;
+		break;
+	      }
+	}
+
+      entries.push_back(s);
+      ++count;
+      trim();
+      return true;
+    }
+
+    void edit_history::trim()
+    {
+      if(capacity == 0)
+	return;
+
+      while(entries.size() > capacity)
+	{
+	  unordered_map<wstring, int>::iterator found = counts.find(entries.front());
+	  if(--found->second == 0)
+	    counts.erase(found);
+	  entries.pop_front();
+	}
+    }
+
+    void edit_history::append_to_file(const wstring &s)
+    {
+      if(filename.empty())
+	return;
+
+      if(file_lines >= compact_ratio * entries.size() + compact_slack)
+	{
+	  if(write_lines(filename, entries))
+	    file_lines = entries.size();
+	  return;
+	}
+
+      FILE *f = fopen(filename.c_str(), "a");
+      if(f == NULL)
+	return;
+
+      fputs(escape_line(s).c_str(), f);
+      fclose(f);
+      ++file_lines;
+    }
+
+    void edit_history::add(const wstring &s)
+    {
+      if(s.empty())
+	return;
+
+      if(do_add(s))
+	append_to_file(s);
+    }
+
+    void edit_history::clear()
+    {
+      entries.clear();
+      counts.clear();
+
+      if(!filename.empty() && write_lines(filename, entries))
+	file_lines = 0;
+    }
+
+    void edit_history::set_capacity(size_type new_capacity)
+    {
+      capacity = new_capacity;
+      trim();
+    }
+
+    edit_history::size_type edit_history::search_backward(const wstring &needle,
+							    size_type from) const
+    {
+      if(entries.empty())
+	return npos;
+
+      if(from >= entries.size())
+	from = entries.size() - 1;
+
+      for(size_type i = from + 1; i > 0; --i)
+	if(entries[i - 1].find(needle) != wstring::npos)
+	  return i - 1;
+
+      return npos;
+    }
+
+    bool edit_history::load(const string &_filename)
+    {
+      size_type lines = 0;
+
+      FILE *f = fopen(_filename.c_str(), "r");
+      if(f == NULL)
+	{
+	  if(errno != ENOENT)
+	    return false;
+	}
+      else
+	{
+	  string line;
+	  char buf[1024];
+
+	  while(fgets(buf, sizeof(buf), f) != NULL)
+	    {
+	      line += buf;
+	      if(line[line.size() - 1] != '\n')
+		continue;
+
+	      line.erase(line.size() - 1);
+	      if(!line.empty())
+		do_add(unescape_line(line));
+	      line.clear();
+	      ++lines;
+	    }
+
+	  // A final line without a newline, e.g. from a crash halfway
+	  // through an append.  Force the file to be rewritten before
+	  // anything is appended to it.
+	  if(!line.empty())
+	    {
+	      do_add(unescape_line(line));
+	      lines = npos;
+	    }
+
+	  const bool failed = ferror(f);
+	  const int err = errno;
+	  fclose(f);
+	  if(failed)
+	    {
+	      errno = err;
+	      return false;
+	    }
+	}
+
+      filename = _filename;
+      file_lines = lines;
+      return true;
+    }
+
+    bool edit_history::save(const string &_filename)
+    {
+      if(!write_lines(_filename, entries))
+	return false;
+
+      filename = _filename;
+      file_lines = entries.size();
+      return true;
+    }
+  }
+}
@@ -0,0 +1,176 @@
+// edit_history.h                                         -*-c++-*-
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+//
+// The list of previously entered strings that an editline can recall.
+
+#ifndef EDIT_HISTORY_H
+#define EDIT_HISTORY_H
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace cwidget
+{
+  namespace widgets
+  {
+    /** \brief The history of an editline, oldest entry first.
+     *
+     *  A history can be limited to a maximum number of entries, in
+     *  which case the oldest entries are dropped as new ones arrive.
+     *  Unless deduplication is turned off, adding a string that is
+     *  already in the history moves it to the end instead of storing
+     *  it twice.
+     *
+     *  A history can also be attached to a file with load() or
+     *  save().  Every entry added after that is appended to the file
+     *  as a single line of UTF-8 (backslashes and newlines are
+     *  escaped), so that adding an entry never rewrites the file.
+     *  When the file holds many more lines than the history has
+     *  entries, it is rewritten with just the current entries.
+     */
+    class edit_history
+    {
+    public:
+      typedef std::deque<std::wstring>::size_type size_type;
+      typedef std::deque<std::wstring>::const_iterator const_iterator;
+
+      static const size_type npos = static_cast<size_type>(-1);
+
+    private:
+      std::deque<std::wstring> entries;
+
+      /** How many times each string occurs in entries. */
+      std::unordered_map<std::wstring, int> counts;
+
+      /** The maximum number of entries, or 0 if there is no limit. */
+      size_type capacity;
+
+      bool dedup;
+
+      /** The file that this history is attached to, or an empty
+       *  string if it isn't attached to one.
+       */
+      std::string filename;
+
+      /** The number of lines in the attached file. */
+      size_type file_lines;
+
+      /** Add an entry without touching the attached file.
+       *
+       *  \return \b false if the history didn't change, because s was
+       *  already the last entry.
+       */
+      bool do_add(const std::wstring &s);
+
+      /** Drop old entries until there are no more than capacity. */
+      void trim();
+
+      /** Append s to the attached file, rewriting the file if it has
+       *  grown too large.
+       */
+      void append_to_file(const std::wstring &s);
+
+    public:
+      /** Create an empty history.
+       *
+       *  \param capacity the maximum number of entries, or 0 for no limit.
+       *  \param dedup if \b true, adding a string that is already in
+       *  the history moves it to the end.
+       */
+      explicit edit_history(size_type capacity = 0, bool dedup = true);
+
+      size_type size() const { return entries.size(); }
+      bool empty() const { return entries.empty(); }
+
+      const std::wstring &operator[](size_type i) const { return entries[i]; }
+      const std::wstring &back() const { return entries.back(); }
+
+      const_iterator begin() const { return entries.begin(); }
+      const_iterator end() const { return entries.end(); }
+
+      /** Add a string to the end of the history.  Empty strings are
+       *  ignored.
+       */
+      void add(const std::wstring &s);
+
+      /** A synonym for add(), so that code written for the old
+       *  vector-based history keeps working.
+       */
+      void push_back(const std::wstring &s) { add(s); }
+
+      /** Remove every entry, truncating the attached file if there is
+       *  one.
+       */
+      void clear();
+
+      size_type get_capacity() const { return capacity; }
+
+      /** Change the maximum number of entries; if there are too many
+       *  entries, the oldest ones are dropped.
+       */
+      void set_capacity(size_type new_capacity);
+
+      bool get_dedup() const { return dedup; }
+
+      /** Change whether new entries are deduplicated.  Duplicates
+       *  already in the history are left alone.
+       */
+      void set_dedup(bool new_dedup) { dedup = new_dedup; }
+
+      /** Search backwards for an entry containing the given string.
+       *
+       *  \param needle the string to search for.
+       *  \param from the index of the first entry to examine; if it
+       *  is past the end of the history, the search starts at the
+       *  last entry.
+       *
+       *  \return the index of the newest entry at or before from that
+       *  contains needle, or npos if there is none.
+       */
+      size_type search_backward(const std::wstring &needle,
+				size_type from = npos) const;
+
+      /** Add the entries stored in a file to this history, and attach
+       *  the history to that file.  A file that doesn't exist is
+       *  treated as empty.
+       *
+       *  \return \b true on success; on failure, returns \b false and
+       *  sets errno, and the history is not attached.
+       */
+      bool load(const std::string &filename);
+
+      /** Write the entries of this history to a file, replacing its
+       *  contents, and attach the history to that file.
+       *
+       *  \return \b true on success; on failure, returns \b false and
+       *  sets errno, and the history is not attached.
+       */
+      bool save(const std::string &filename);
+
+      /** Stop writing new entries to the attached file. */
+      void detach() { filename.clear(); }
+
+      /** \return the file that this history is attached to, or an
+       *  empty string.
+       */
+      const std::string &get_filename() const { return filename; }
+    };
+  }
+}
+
+#endif // EDIT_HISTORY_H
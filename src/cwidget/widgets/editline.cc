@@ -18,14 +18,19 @@
 //   Boston, MA 02111-1307, USA.
 
 #include "editline.h"
+#include "menu.h"
 
 #include <cwidget/config/colors.h>
 #include <cwidget/config/keybindings.h>
 #include <cwidget/toplevel.h>
+#include <cwidget/generic/util/i18n.h>
 #include <cwidget/generic/util/transcode.h>
 
 #include <sigc++/functors/mem_fun.h>
 
+#include <algorithm>
+#include <cwctype>
+
 using namespace std;
 
 namespace cwidget
@@ -36,13 +41,17 @@ namespace cwidget
 
     editline::editline(const string &_prompt, const string &_text,
 		       history_list *_history)
-      : widget(), curloc(_text.size()),
+      : widget(), text_width(0), line_index_width(0), curloc(_text.size()),
 	startloc(0), desired_size(-1), history(_history),
-	history_loc(0), using_history(false), allow_wrap(false), clear_on_first_edit(false)
+	history_loc(0), using_history(false), allow_wrap(false), clear_on_first_edit(false),
+	searching(false), search_loc(0), search_failed(false),
+	completion(NULL), pending_completion(NULL), completion_end(0)
     {
       // Just spew a partial/null string if errors happen for now.
       util::transcode(_prompt.c_str(), prompt);
-      util::transcode(_text.c_str(), text);
+      wstring wtext;
+      util::transcode(_text.c_str(), wtext);
+      replace_text(wtext);
 
       set_bg_style(get_style("EditLine"));
 
@@ -53,10 +62,14 @@ namespace cwidget
 
     editline::editline(const wstring &_prompt, const wstring &_text,
 		       history_list *_history)
-      : widget(), prompt(_prompt), text(_text), curloc(_text.size()),
-        startloc(0), desired_size(-1), history(_history),
-        history_loc(0), using_history(false), allow_wrap(false), clear_on_first_edit(false)
+      : widget(), prompt(_prompt), text_width(0), line_index_width(0),
+	curloc(_text.size()), startloc(0), desired_size(-1), history(_history),
+	history_loc(0), using_history(false), allow_wrap(false), clear_on_first_edit(false),
+	searching(false), search_loc(0), search_failed(false),
+	completion(NULL), pending_completion(NULL), completion_end(0)
     {
+      replace_text(_text);
+
       set_bg_style(get_style("EditLine"));
 
       // This ensures that the cursor is set to the right location when the
@@ -66,13 +79,17 @@ namespace cwidget
 
     editline::editline(int maxlength, const string &_prompt,
 		       const string &_text, history_list *_history)
-      : widget(), curloc(0),
-        startloc(0), desired_size(maxlength), history(_history), history_loc(0),
-        using_history(false), allow_wrap(false), clear_on_first_edit(false)
+      : widget(), text_width(0), line_index_width(0), curloc(0),
+	startloc(0), desired_size(maxlength), history(_history), history_loc(0),
+	using_history(false), allow_wrap(false), clear_on_first_edit(false),
+	searching(false), search_loc(0), search_failed(false),
+	completion(NULL), pending_completion(NULL), completion_end(0)
     {
       // As above, ignore errors.
       util::transcode(_prompt, prompt);
-      util::transcode(_text, text);
+      wstring wtext;
+      util::transcode(_text, wtext);
+      replace_text(wtext);
 
       set_bg_style(get_style("EditLine"));
       do_layout.connect(sigc::mem_fun(*this, &editline::normalize_cursor));
@@ -80,24 +97,157 @@ namespace cwidget
 
     editline::editline(int maxlength, const wstring &_prompt,
 		       const wstring &_text, history_list *_history)
-      : widget(), prompt(_prompt), text(_text), curloc(0),
-        startloc(0), desired_size(maxlength), history(_history), history_loc(0),
-        using_history(false), allow_wrap(false), clear_on_first_edit(false)
+      : widget(), prompt(_prompt), text_width(0), line_index_width(0), curloc(0),
+	startloc(0), desired_size(maxlength), history(_history), history_loc(0),
+	using_history(false), allow_wrap(false), clear_on_first_edit(false),
+	searching(false), search_loc(0), search_failed(false),
+	completion(NULL), pending_completion(NULL), completion_end(0)
     {
+      replace_text(_text);
+
       set_bg_style(get_style("EditLine"));
       do_layout.connect(sigc::mem_fun(*this, &editline::normalize_cursor));
     }
 
-    wchar_t editline::get_char(size_t loc)
+    editline::~editline()
     {
-      widget_ref tmpref(this);
+      cancel_completion();
+    }
 
+    wchar_t editline::get_char(size_t loc)
+    {
       if(loc>=prompt.size())
 	return text[loc-prompt.size()];
       else
 	return prompt[loc];
     }
 
+    namespace
+    {
+      int string_width(const wstring &s)
+      {
+	int rval = 0;
+	for(wstring::const_iterator it = s.begin(); it != s.end(); ++it)
+	  rval += wcwidth(*it);
+	return rval;
+      }
+    }
+
+    void editline::insert_text(wstring::size_type loc, const wstring &s)
+    {
+      cancel_completion();
+      text.insert(loc, s);
+      text_width += string_width(s);
+      update_line_index(prompt.size() + loc, 0, s.size());
+    }
+
+    void editline::erase_text(wstring::size_type loc, wstring::size_type n)
+    {
+      cancel_completion();
+      n = std::min(n, text.size() - loc);
+      text_width -= string_width(text.substr(loc, n));
+      text.erase(loc, n);
+      update_line_index(prompt.size() + loc, n, 0);
+    }
+
+    void editline::replace_text(const wstring &s)
+    {
+      cancel_completion();
+      text = s;
+      text_width = string_width(s);
+      line_starts.clear();
+    }
+
+    void editline::emit_text_changed()
+    {
+      // Don't copy a long text just to throw it away.
+      if(!text_changed.empty())
+	text_changed(text.str());
+    }
+
+    void editline::ensure_line_index(int width)
+    {
+      if(line_starts.empty() || line_index_width != width)
+	{
+	  line_starts.assign(1, 0);
+	  line_index_width = width;
+	  layout_lines(std::vector<wstring::size_type>(), 0, 0, 0);
+	}
+    }
+
+    void editline::layout_lines(const std::vector<wstring::size_type> &old_starts,
+				wstring::size_type resync_from,
+				wstring::size_type removed,
+				wstring::size_type inserted)
+    {
+      std::vector<wstring::size_type>::const_iterator old_it = old_starts.begin();
+      const size_t num_chars = get_num_chars();
+      int used = 0;
+
+      for(size_t i = line_starts.back(); i < num_chars; ++i)
+	{
+	  const int ch_width = wcwidth(get_char(i));
+	  size_t next_start;
+
+	  if(used + ch_width > line_index_width)
+	    {
+	      next_start = i;
+	      used = ch_width;
+	    }
+	  else
+	    {
+	      used += ch_width;
+	      if(used < line_index_width)
+		continue;
+
+	      next_start = i + 1;
+	      used = 0;
+	    }
+
+	  // The layout of a line depends only on the characters from
+	  // its start onwards, so once a line starts at the same
+	  // character as before the edit, the remaining lines are the
+	  // same too.
+	  if(next_start >= resync_from)
+	    {
+	      const size_t old_start = next_start + removed - inserted;
+	      while(old_it != old_starts.end() && *old_it < old_start)
+		++old_it;
+
+	      if(old_it != old_starts.end() && *old_it == old_start)
+		{
+		  for( ; old_it != old_starts.end(); ++old_it)
+		    line_starts.push_back(*old_it + inserted - removed);
+		  return;
+		}
+	    }
+
+	  line_starts.push_back(next_start);
+	}
+    }
+
+    void editline::update_line_index(wstring::size_type pos,
+				     wstring::size_type removed,
+				     wstring::size_type inserted)
+    {
+      if(line_starts.empty())
+	return;
+
+      // Redo the line containing the edit and the one before it (a
+      // character deleted at the start of a line might now fit at the
+      // end of the previous one).
+      size_t line = std::upper_bound(line_starts.begin(), line_starts.end(), pos)
+	- line_starts.begin() - 1;
+      if(line > 0)
+	--line;
+
+      const std::vector<wstring::size_type> old_starts(line_starts.begin() + line + 1,
+						      line_starts.end());
+      line_starts.resize(line + 1);
+
+      layout_lines(old_starts, pos + inserted, removed, inserted);
+    }
+
     void editline::normalize_cursor()
     {
       widget_ref tmpref(this);
@@ -110,7 +260,7 @@ namespace cwidget
 	  int w=get_width();
 
 	  int promptwidth=wcswidth(prompt.c_str(), prompt.size());
-	  int textwidth=wcswidth(text.c_str(), text.size());
+	  int textwidth=text_width;
 
 	  int cursorx=0;
 	  if(curloc+prompt.size()>startloc)
@@ -235,21 +385,62 @@ namespace cwidget
       return true;
     }
 
+    bool editline::handle_paste(const wstring &pasted)
+    {
+      widget_ref tmpref(this);
+
+      for(wstring::const_iterator it = pasted.begin(); it != pasted.end(); ++it)
+	if(iswcntrl(*it))
+	  return false;
+
+      if(clear_on_first_edit)
+	{
+	  replace_text(L"");
+	  curloc = 0;
+	  startloc = 0;
+	}
+      clear_on_first_edit = false;
+
+      insert_text(curloc, pasted);
+      curloc += pasted.size();
+      normalize_cursor();
+      emit_text_changed();
+      size_changed();
+      return true;
+    }
+
     bool editline::handle_key(const config::key &k)
     {
+      static const config::action_id del_back_action = config::get_action_id("DelBack");
+      static const config::action_id del_forward_action = config::get_action_id("DelForward");
+      static const config::action_id confirm_action = config::get_action_id("Confirm");
+      static const config::action_id left_action = config::get_action_id("Left");
+      static const config::action_id right_action = config::get_action_id("Right");
+      static const config::action_id begin_action = config::get_action_id("Begin");
+      static const config::action_id end_action = config::get_action_id("End");
+      static const config::action_id del_eol_action = config::get_action_id("DelEOL");
+      static const config::action_id del_bol_action = config::get_action_id("DelBOL");
+      static const config::action_id history_prev_action = config::get_action_id("HistoryPrev");
+      static const config::action_id history_next_action = config::get_action_id("HistoryNext");
+      static const config::action_id history_search_action = config::get_action_id("HistorySearch");
+      static const config::action_id complete_action = config::get_action_id("Complete");
+
       widget_ref tmpref(this);
 
+      if(searching)
+	return handle_search_key(k);
+
       bool clear_on_this_edit = clear_on_first_edit;
       clear_on_first_edit = false;
 
-      if(bindings->key_matches(k, "DelBack"))
+      if(bindings->key_matches(k, del_back_action))
 	{
 	  if(curloc>0)
 	    {
-	      text.erase(--curloc, 1);
+	      erase_text(--curloc, 1);
 	      normalize_cursor();
-	      text_changed(wstring(text));
-	      toplevel::queuelayout();
+	      emit_text_changed();
+	      size_changed();
 	    }
 	  else
 	    {
@@ -258,14 +449,14 @@ namespace cwidget
 	    }
 	  return true;
 	}
-      else if(bindings->key_matches(k, "DelForward"))
+      else if(bindings->key_matches(k, del_forward_action))
 	{
 	  if(curloc<text.size())
 	    {
-	      text.erase(curloc, 1);
+	      erase_text(curloc, 1);
 	      normalize_cursor();
-	      text_changed(wstring(text));
-	      toplevel::queuelayout();
+	      emit_text_changed();
+	      size_changed();
 	    }
 	  else
 	    {
@@ -274,14 +465,14 @@ namespace cwidget
 	    }
 	  return true;
 	}
-      else if(bindings->key_matches(k, "Confirm"))
+      else if(bindings->key_matches(k, confirm_action))
 	{
 	  // I create a new string here because otherwise modifications to
 	  // "text" are seen by the widgets! (grr, sigc++)
-	  entered(wstring(text));
+	  entered(text.str());
 	  return true;
 	}
-      else if(bindings->key_matches(k, "Left"))
+      else if(bindings->key_matches(k, left_action))
 	{
 	  if(curloc>0)
 	    {
@@ -296,7 +487,7 @@ namespace cwidget
 	    }
 	  return true;
 	}
-      else if(bindings->key_matches(k, "Right"))
+      else if(bindings->key_matches(k, right_action))
 	{
 	  if(curloc<text.size())
 	    {
@@ -311,7 +502,7 @@ namespace cwidget
 	    }
 	  return true;
 	}
-      else if(bindings->key_matches(k, "Begin"))
+      else if(bindings->key_matches(k, begin_action))
 	{
 	  curloc=0;
 	  startloc=0;
@@ -319,40 +510,49 @@ namespace cwidget
 	  toplevel::update();
 	  return true;
 	}
-      else if(bindings->key_matches(k, "End"))
+      else if(bindings->key_matches(k, end_action))
 	{
 	  curloc=text.size();
 	  normalize_cursor();
 	  toplevel::update();
 	  return true;
 	}
-      else if(bindings->key_matches(k, "DelEOL"))
+      else if(bindings->key_matches(k, del_eol_action))
 	{
-	  text.erase(curloc);
+	  erase_text(curloc, text.size() - curloc);
 	  normalize_cursor();
-	  text_changed(wstring(text));
-	  toplevel::queuelayout();
+	  emit_text_changed();
+	  size_changed();
 	  return true;
 	}
-      else if(bindings->key_matches(k, "DelBOL"))
+      else if(bindings->key_matches(k, del_bol_action))
 	{
-	  text.erase(0, curloc);
+	  erase_text(0, curloc);
 	  curloc=0;
 	  normalize_cursor();
-	  text_changed(wstring(text));
-	  toplevel::queuelayout();
+	  emit_text_changed();
+	  size_changed();
+	  return true;
+	}
+      else if(history && bindings->key_matches(k, history_search_action))
+	{
+	  start_search();
 	  return true;
 	}
-      else if(history && bindings->key_matches(k, "HistoryPrev"))
+      else if(history && bindings->key_matches(k, history_prev_action))
 	{
 	  if(history->size()==0)
 	    return true;
 
+	  // The history might have shrunk since we last looked at it.
+	  if(history_loc>history->size())
+	    history_loc=history->size();
+
 	  if(!using_history)
 	    {
 	      using_history=true;
 	      history_loc=history->size()-1;
-	      pre_history_text=text;
+	      pre_history_text=text.str();
 	    }
 	  else if(history_loc>0)
 	    --history_loc;
@@ -360,31 +560,34 @@ namespace cwidget
 	    // Break out
 	    return true;
 
-	  text=(*history)[history_loc];
+	  replace_text((*history)[history_loc]);
 	  curloc=text.size();
 	  startloc=0;
 	  normalize_cursor();
-	  text_changed(wstring(text));
-	  toplevel::queuelayout();
+	  emit_text_changed();
+	  size_changed();
 
 	  return true;
 	}
-      else if(history && bindings->key_matches(k, "HistoryNext"))
+      else if(history && bindings->key_matches(k, history_next_action))
 	{
 	  if(history->size()==0 || !using_history)
 	    return true;
 
+	  if(history_loc>history->size())
+	    history_loc=history->size();
+
 	  if(history_loc>=history->size()-1)
 	    {
 	      using_history=false;
 	      history_loc=0;
-	      text=pre_history_text;
+	      replace_text(pre_history_text);
 	      pre_history_text=L"";
 	      curloc=text.size();
 	      startloc=0;
 	      normalize_cursor();
-	      text_changed(wstring(text));
-	      toplevel::queuelayout();
+	      emit_text_changed();
+	      size_changed();
 
 	      // FIXME: store the pre-history edit and restore that.
 	      return true;
@@ -393,18 +596,23 @@ namespace cwidget
 	  if(history_loc>=0)
 	    {
 	      ++history_loc;
-	      text=(*history)[history_loc];
+	      replace_text((*history)[history_loc]);
 	      curloc=text.size();
 	      startloc=0;
 	      normalize_cursor();
-	      text_changed(wstring(text));
-	      toplevel::queuelayout();
+	      emit_text_changed();
+	      size_changed();
 
 	      return true;
 	    }
 	  else
 	    return true;
 	}
+      else if(completion && bindings->key_matches(k, complete_action))
+	{
+	  start_completion();
+	  return true;
+	}
       else if(k.function_key)
 	return widget::handle_key(k);
       else if(k.ch=='\t') // HACK
@@ -413,78 +621,292 @@ namespace cwidget
 	{
 	  if(clear_on_this_edit)
 	    {
-	      text.clear();
+	      replace_text(L"");
 	      curloc = 0;
 	      startloc = 0;
 	    }
 
-	  text.insert(curloc++, 1, k.ch);
+	  insert_text(curloc++, wstring(1, k.ch));
 	  normalize_cursor();
-	  text_changed(wstring(text));
-	  toplevel::queuelayout();
+	  emit_text_changed();
+	  size_changed();
 	  return true;
 	}
     }
 
-    int editline::get_line_of_character(size_t n, int width)
+    void editline::set_prompt(const wstring &new_prompt)
     {
-      if(!allow_wrap)
-	return 0;
+      const size_t old_size = prompt.size();
+
+      prompt = new_prompt;
+      line_starts.clear();
+
+      // Keep startloc pointing at the same part of the text.
+      if(startloc >= old_size)
+	startloc = startloc - old_size + prompt.size();
+      else
+	startloc = 0;
+    }
+
+    void editline::start_search()
+    {
+      if(!using_history)
+	{
+	  using_history = true;
+	  history_loc = history->size();
+	  pre_history_text = text.str();
+	}
+
+      searching = true;
+      search_query.clear();
+      search_loc = history_loc;
+      search_failed = false;
+      saved_prompt = prompt;
+      search_history(history_loc);
+    }
+
+    void editline::search_history(history_list::size_type from)
+    {
+      history_list::size_type found = history_list::npos;
+      if(from != history_list::npos)
+	found = history->search_backward(search_query, from);
+
+      search_failed = (found == history_list::npos);
+
+      wstring new_prompt = search_failed
+	? util::transcode(_("(failed reverse-i-search)`"))
+	: util::transcode(_("(reverse-i-search)`"));
+      new_prompt += search_query;
+      new_prompt += L"': ";
+      set_prompt(new_prompt);
 
-      int rval = 0;
-      int curr_line_width = 0;
-      for(size_t i = 0; i < n && i < get_num_chars(); ++i)
+      if(!search_failed && !search_query.empty())
 	{
-	  wchar_t ch = get_char(i);
-	  int ch_width = wcwidth(ch);
-	  if(curr_line_width + ch_width > width)
+	  search_loc = found;
+	  replace_text((*history)[found]);
+	  curloc = text.str().find(search_query);
+	  emit_text_changed();
+	}
+
+      normalize_cursor();
+      size_changed();
+    }
+
+    void editline::finish_search(bool accept)
+    {
+      searching = false;
+      set_prompt(saved_prompt);
+      saved_prompt.clear();
+
+      if(accept && !search_query.empty() && search_loc < history->size())
+	history_loc = search_loc;
+      else if(!accept)
+	{
+	  using_history = false;
+	  history_loc = 0;
+	  replace_text(pre_history_text);
+	  pre_history_text = L"";
+	  curloc = text.size();
+	  emit_text_changed();
+	}
+
+      normalize_cursor();
+      size_changed();
+    }
+
+    bool editline::handle_search_key(const config::key &k)
+    {
+      static const config::action_id history_search_action = config::get_action_id("HistorySearch");
+      static const config::action_id del_back_action = config::get_action_id("DelBack");
+      static const config::action_id cancel_action = config::get_action_id("Cancel");
+
+      if(bindings->key_matches(k, history_search_action))
+	{
+	  // Look for an older match.
+	  if(search_failed || search_query.empty())
+	    beep();
+	  else if(search_loc == 0)
 	    {
-	      ++rval;
-	      curr_line_width = ch_width;
+	      beep();
+	      search_history(history_list::npos);
 	    }
+	  else
+	    search_history(search_loc - 1);
+	  return true;
+	}
+      else if(bindings->key_matches(k, del_back_action))
+	{
+	  if(search_query.empty())
+	    beep();
 	  else
 	    {
-	      curr_line_width += ch_width;
-	      if(curr_line_width == width)
-		{
-		  ++rval;
-		  curr_line_width = 0;
-		}
+	      // Shortening the query can only turn up newer matches, so
+	      // start over from the newest entry.
+	      search_query.erase(search_query.size() - 1);
+	      search_history(history->size());
 	    }
+	  return true;
+	}
+      else if(bindings->key_matches(k, cancel_action))
+	{
+	  finish_search(false);
+	  return true;
+	}
+      else if(!k.function_key && !iswcntrl(k.ch))
+	{
+	  // The current match is the newest one that might contain
+	  // the longer query, so the search continues from there.
+	  search_query += k.ch;
+	  search_history(search_failed ? history_list::npos : search_loc);
+	  return true;
 	}
+      else
+	{
+	  // Any other key ends the search and is then handled as usual.
+	  finish_search(true);
+	  return handle_key(k);
+	}
+    }
 
-      return rval;
+    void editline::set_completion_provider(completion_provider *provider)
+    {
+      cancel_completion();
+      completion = provider;
     }
 
-    int editline::get_character_of_line(size_t n, int width)
+    void editline::start_completion()
     {
-      if(!allow_wrap)
-	return startloc;
+      cancel_completion();
+
+      completion_end = curloc;
+      pending_completion =
+	completion_request::create(sigc::mem_fun(*this, &editline::completion_results));
+      pending_completion->submit(completion, text.substr(0, curloc));
+    }
 
-      size_t curr_line = 0;
-      int curr_line_width = 0;
-      size_t i;
-      for(i = 0; curr_line < n && i < get_num_chars(); ++i)
+    void editline::cancel_completion()
+    {
+      if(pending_completion != NULL)
 	{
-	  wchar_t ch = get_char(i);
-	  int ch_width = wcwidth(ch);
-	  if(curr_line_width + ch_width > width)
-	    {
-	      ++curr_line;
-	      curr_line_width = ch_width;
-	    }
+	  pending_completion->cancel();
+	  pending_completion->decref();
+	  pending_completion = NULL;
+	}
+
+      completion_candidates.clear();
+      hide_completions();
+    }
+
+    void editline::completion_results(const std::vector<wstring> &candidates,
+				      bool finished)
+    {
+      widget_ref tmpref(this);
+
+      const std::vector<wstring>::size_type first_new = completion_candidates.size();
+      completion_candidates.insert(completion_candidates.end(),
+				   candidates.begin(), candidates.end());
+
+      if(!show_completions.empty() && completion_candidates.size() > 1)
+	{
+	  if(completion_menu.valid())
+	    for(std::vector<wstring>::size_type i = first_new;
+		i < completion_candidates.size(); ++i)
+	      add_completion_item(completion_candidates[i]);
 	  else
 	    {
-	      curr_line_width += ch_width;
-	      if(curr_line_width == width)
-		{
-		  ++curr_line;
-		  curr_line_width = 0;
-		}
+	      completion_menu = menu::create();
+	      completion_menu->menus_goaway.connect(sigc::mem_fun(*this, &editline::hide_completions));
+	      completion_menu->connect_key("Cancel", &config::global_bindings,
+					   sigc::mem_fun(*this, &editline::hide_completions));
+
+	      for(std::vector<wstring>::const_iterator it = completion_candidates.begin();
+		  it != completion_candidates.end(); ++it)
+		add_completion_item(*it);
+
+	      show_completions(completion_menu);
 	    }
 	}
 
-      return (signed)i;
+      if(!finished)
+	return;
+
+      // No more results will arrive.  (The receiver of
+      // show_completions might have changed the text, cancelling
+      // this completion.)
+      if(pending_completion == NULL)
+	return;
+
+      pending_completion->decref();
+      pending_completion = NULL;
+
+      if(completion_menu.valid())
+	return;
+
+      const wstring prefix = common_prefix(completion_candidates);
+      if(completion_candidates.size() == 1 ||
+	 prefix.size() > completion_end)
+	apply_completion(prefix);
+      else
+	{
+	  completion_candidates.clear();
+	  beep();
+	}
+    }
+
+    void editline::add_completion_item(const wstring &candidate)
+    {
+      menu_item *item = new menu_item(candidate, "", L"");
+      item->selected.connect(sigc::bind(sigc::mem_fun(*this, &editline::apply_completion),
+					candidate));
+      completion_menu->append_item(item);
+    }
+
+    void editline::apply_completion(wstring candidate)
+    {
+      widget_ref tmpref(this);
+
+      const wstring::size_type end = std::min(completion_end, text.size());
+
+      erase_text(0, end);
+      insert_text(0, candidate);
+      curloc = candidate.size() + (curloc > end ? curloc - end : 0);
+      normalize_cursor();
+      emit_text_changed();
+      size_changed();
+    }
+
+    void editline::hide_completions()
+    {
+      if(completion_menu.valid())
+	{
+	  util::ref_ptr<menu> m = completion_menu;
+	  completion_menu = NULL;
+	  m->destroy();
+	}
+    }
+
+    int editline::get_line_of_character(size_t n, int width)
+    {
+      if(!allow_wrap)
+	return 0;
+
+      ensure_line_index(width);
+
+      return std::upper_bound(line_starts.begin(), line_starts.end(), n)
+	- line_starts.begin() - 1;
+    }
+
+    int editline::get_character_of_line(size_t n, int width)
+    {
+      if(!allow_wrap)
+	return startloc;
+
+      ensure_line_index(width);
+
+      if(n < line_starts.size())
+	return line_starts[n];
+      else
+	return get_num_chars();
     }
 
     void editline::paint(const style &st)
@@ -499,7 +921,6 @@ namespace cwidget
       const int height = allow_wrap ? getmaxy() : 1;
       size_t linestart = startloc;
 
-      wstring todisp = prompt + text;
       while(y < height && linestart < prompt.size() + text.size())
 	{
 	  int used = 0;
@@ -515,7 +936,11 @@ namespace cwidget
 	  if(used > width && chars > 1)
 	    --chars;
 
-	  mvaddstr(y, 0, wstring(todisp, linestart, chars));
+	  wstring line;
+	  line.reserve(chars);
+	  for(size_t i = 0; i < chars; ++i)
+	    line.push_back(get_char(linestart + i));
+	  mvaddstr(y, 0, line);
 
 	  ++y;
 	  linestart += chars;
@@ -574,8 +999,7 @@ namespace cwidget
     {
       eassert(lst);
 
-      if(lst->empty() || lst->back()!=s)
-	lst->push_back(s);
+      lst->add(s);
     }
 
     void editline::add_to_history(std::wstring s)
@@ -590,6 +1014,13 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
+      if(searching)
+	{
+	  searching = false;
+	  set_prompt(saved_prompt);
+	  saved_prompt.clear();
+	}
+
       pre_history_text=L"";
       using_history=false;
       history_loc=0;
@@ -599,11 +1030,11 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
-      text=_text;
+      replace_text(_text);
       if(curloc>text.size())
 	curloc=text.size();
-      text_changed(wstring(text));
-      toplevel::update();
+      emit_text_changed();
+      size_changed();
     }
 
     void editline::set_text(string _text)
@@ -623,6 +1054,10 @@ namespace cwidget
       bindings->set("Right", config::key(KEY_RIGHT, true));
       // Override these for the case where left and right have multiple bindings
       // in the global keymap
+
+      using config::key;
+      bindings->set("HistorySearch", KEY_CTRL(L'r'));
+      bindings->set("Complete", config::key(L'\t', false));
     }
 
     int editline::width_request()
@@ -630,7 +1065,7 @@ namespace cwidget
       widget_ref tmpref(this);
 
       if(desired_size == -1)
-	return wcswidth(prompt.c_str(), prompt.size())+wcswidth(text.c_str(), text.size());
+	return wcswidth(prompt.c_str(), prompt.size())+text_width;
       else
 	return desired_size;
     }
@@ -23,6 +23,10 @@
 #define EDITLINE_H
 
 #include "widget.h"
+#include "completion.h"
+#include "edit_history.h"
+
+#include <cwidget/generic/util/gap_buffer.h>
 
 #include <vector>
 
@@ -35,14 +39,27 @@ namespace cwidget
 
   namespace widgets
   {
+    class menu;
+
     class editline : public widget
     {
     public:
-      typedef std::vector<std::wstring> history_list;
+      typedef edit_history history_list;
     private:
 
       std::wstring prompt;
-      std::wstring text;
+      util::gap_buffer<wchar_t> text;
+
+      /** The total width of the characters in text. */
+      int text_width;
+
+      /** When wrapping is enabled, the index (in the prompt followed
+       *  by the text) of the first character of each line, for lines
+       *  line_index_width columns wide.  Edits update the index
+       *  incrementally; it is empty if it must be rebuilt.
+       */
+      std::vector<std::wstring::size_type> line_starts;
+      int line_index_width;
 
       std::wstring pre_history_text;
       // Used as a "virtual" history entry.
@@ -78,8 +95,112 @@ namespace cwidget
        */
       bool clear_on_first_edit;
 
+      /** \brief \b true during an incremental search through the
+       *  history.
+       *
+       *  While searching, keystrokes edit search_query instead of the
+       *  text, the text shows the entry that matched, and the prompt
+       *  shows the query; saved_prompt holds the real prompt.
+       */
+      bool searching;
+      std::wstring search_query;
+      std::wstring saved_prompt;
+      /** The history entry that matched search_query. */
+      history_list::size_type search_loc;
+      /** \b true if no entry matched search_query. */
+      bool search_failed;
+
+      /** Where completions come from, or NULL if completion is
+       *  disabled.
+       */
+      completion_provider *completion;
+      /** The request that is still producing candidates, if any. */
+      completion_request *pending_completion;
+      /** Candidates replace the text before this location. */
+      std::wstring::size_type completion_end;
+      /** The candidates received so far. */
+      std::vector<std::wstring> completion_candidates;
+      /** The menu showing completion_candidates, if there is one. */
+      util::ref_ptr<menu> completion_menu;
+
       void normalize_cursor();
 
+      /** Change the displayed prompt. */
+      void set_prompt(const std::wstring &new_prompt);
+
+      /** Start an incremental search through the history. */
+      void start_search();
+
+      /** Look for search_query in the history, starting with the
+       *  entry at from and moving backwards, and display the result.
+       */
+      void search_history(history_list::size_type from);
+
+      /** Stop searching.  If accept is \b true, the text of the entry
+       *  that was found is kept; otherwise the text from before the
+       *  search is restored.
+       */
+      void finish_search(bool accept);
+
+      /** Handle a keystroke during an incremental search. */
+      bool handle_search_key(const config::key &k);
+
+      /** Ask the completion provider to complete the text before the
+       *  cursor.
+       */
+      void start_completion();
+
+      /** Stop the current completion, if any, and hide its menu. */
+      void cancel_completion();
+
+      /** Receive a batch of candidates from pending_completion. */
+      void completion_results(const std::vector<std::wstring> &candidates,
+			      bool finished);
+
+      /** Add a candidate to completion_menu. */
+      void add_completion_item(const std::wstring &candidate);
+
+      /** Replace the text before completion_end with candidate. */
+      void apply_completion(std::wstring candidate);
+
+      /** Destroy completion_menu. */
+      void hide_completions();
+
+      /** Modify the text, keeping text_width and the line index up to
+       *  date.  These don't emit text_changed.
+       */
+      void insert_text(std::wstring::size_type loc, const std::wstring &s);
+      void erase_text(std::wstring::size_type loc, std::wstring::size_type n);
+      void replace_text(const std::wstring &s);
+
+      /** Emit text_changed, if anyone is listening. */
+      void emit_text_changed();
+
+      /** Make sure that the line index describes lines of the given
+       *  width.
+       */
+      void ensure_line_index(int width);
+
+      /** Extend the line index from its last entry to the end of the
+       *  text.  If an edit replaced removed characters with inserted
+       *  ones, old_starts holds the line starts (in the coordinates
+       *  before the edit) that followed the entries kept in the index;
+       *  once the new layout reaches a line start past resync_from that
+       *  is also in old_starts, the rest of old_starts is reused.
+       */
+      void layout_lines(const std::vector<std::wstring::size_type> &old_starts,
+			std::wstring::size_type resync_from,
+			std::wstring::size_type removed,
+			std::wstring::size_type inserted);
+
+      /** Update the line index after removed characters at pos (in the
+       *  prompt followed by the text) were replaced with inserted
+       *  characters.
+       */
+      void update_line_index(std::wstring::size_type pos,
+			     std::wstring::size_type removed,
+			     std::wstring::size_type inserted);
+
       /** \return the zero-based index of the line containing the nth character
        *  of the visual representation.
        */
@@ -103,6 +224,12 @@ namespace cwidget
     protected:
       bool handle_key(const config::key &k);
 
+      /** Inserts the pasted text at the cursor in one edit.  Text
+       *  containing control characters (such as newlines) is left to
+       *  the key bindings.
+       */
+      bool handle_paste(const std::wstring &pasted);
+
       editline(const std::wstring &_prompt,
 	       const std::wstring &_text=L"",
 	       history_list *history=NULL);
@@ -120,6 +247,8 @@ namespace cwidget
 	       const std::string &_text, history_list *history);
 
     public:
+      ~editline();
+
       static util::ref_ptr<editline>
       create(const std::wstring &prompt, const std::wstring &text = L"",
 	     history_list *history = NULL)
@@ -171,7 +300,11 @@ namespace cwidget
 	clear_on_first_edit = value;
       }
 
-      void set_allow_wrap(bool allow) { allow_wrap = allow; }
+      void set_allow_wrap(bool allow)
+      {
+	allow_wrap = allow;
+	size_changed();
+      }
       bool get_allow_wrap() const { return allow_wrap; }
 
       bool focus_me();
@@ -183,7 +316,30 @@ namespace cwidget
       sigc::signal1<void, std::wstring> text_changed;
       // Called when the text is altered.
 
-      std::wstring get_text() {return text;}
+      /** \brief Emitted with a menu of candidates when a completion
+       *  finds more than one.
+       *
+       *  The menu is filled in as more candidates arrive.  The
+       *  receiver should display it, for instance by adding it to a
+       *  stacked widget, and give it the focus; the editline destroys
+       *  it when a candidate is chosen, when it is cancelled, or when
+       *  the text changes.  If nothing is connected to this signal,
+       *  completion just inserts the text that all the candidates
+       *  have in common.
+       */
+      sigc::signal1<void, util::ref_ptr<menu> > show_completions;
+
+      /** Set the source of completions for the text of this editline,
+       *  or disable completion if provider is NULL.  The provider is
+       *  not owned by the editline; see completion_provider.
+       *
+       *  Completion is started by the "Complete" binding (Tab by
+       *  default), and runs in the background; it is cancelled if the
+       *  text changes before it is finished.
+       */
+      void set_completion_provider(completion_provider *provider);
+
+      std::wstring get_text() {return text.str();}
       void set_text(std::wstring _text);
 
       /** Decodes the given multibyte string, and sets the current text
@@ -200,10 +356,15 @@ namespace cwidget
       static void add_to_history(std::wstring s,
 				 history_list *history);
       // Appends the string to the end of the history list (convenience routine)
+      //
+      // The history decides whether to store duplicates and how many
+      // entries to keep; see edit_history.
 
       void add_to_history(std::wstring s);
       void reset_history();
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
       static void init_bindings();
     };
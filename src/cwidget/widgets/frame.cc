@@ -25,7 +25,7 @@ namespace cwidget
       widget_ref subwidget = get_subwidget();
 
       if(subwidget.valid() && subwidget->get_visible())
-	return subwidget->width_request()+2;
+	return subwidget->get_width_request()+2;
       else
 	return 2;
     }
@@ -41,7 +41,7 @@ namespace cwidget
 	  widget_ref subwidget = get_subwidget();
 
 	  if(subwidget.valid() && subwidget->get_visible())
-	    return subwidget->height_request(width-2)+2;
+	    return subwidget->get_height_request(width-2)+2;
 	  else
 	    return 2;
 	}
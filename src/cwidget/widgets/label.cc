@@ -111,7 +111,7 @@ namespace cwidget
       delete txt;
       txt=new fragment_cache(f);
       // Our size might have changed, so re-layout the screen.
-      toplevel::queuelayout();
+      size_changed();
     }
 
     void label::paint(const style &st)
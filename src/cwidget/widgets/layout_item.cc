@@ -110,7 +110,7 @@ namespace cwidget
 	  attr_t attr=st.get_attrs();
 	  for(fragment_contents::const_iterator i=tmplines.begin();
 	      i!=tmplines.end(); ++i)
-	    lines.push_back(fragment_line(basex, wchtype(L' ', attr))+*i);
+	    lines.push_back(i->indented(basex, wchtype(L' ', attr)));
 
 	  for(child_list::iterator i=children.begin(); i!=children.end(); ++i)
 	    delete *i;
@@ -159,7 +159,7 @@ namespace cwidget
 
       if(get_visible())
 	{
-	  toplevel::queuelayout();
+	  size_changed();
 	  toplevel::update();
 	}
     }
@@ -189,7 +189,7 @@ namespace cwidget
 	--startloc;
 
       if(get_visible())
-	toplevel::queuelayout();
+	size_changed();
     }
 
     int menu::width_request()
@@ -428,21 +428,27 @@ namespace cwidget
 
     bool menu::handle_key(const config::key &k)
     {
+      static const config::action_id up_action = config::get_action_id("Up");
+      static const config::action_id down_action = config::get_action_id("Down");
+      static const config::action_id begin_action = config::get_action_id("Begin");
+      static const config::action_id end_action = config::get_action_id("End");
+      static const config::action_id confirm_action = config::get_action_id("Confirm");
+
       widget_ref tmpref(this);
 
       // This will ensure that the cursor is in bounds if possible, and that
       // if it is in bounds, a "real" item is selected.
       sanitize_cursor(true);
 
-      if(bindings->key_matches(k, "Up"))
+      if(bindings->key_matches(k, up_action))
 	move_selection_up();
-      else if(bindings->key_matches(k, "Down"))
+      else if(bindings->key_matches(k, down_action))
 	move_selection_down();
-      else if(bindings->key_matches(k, "Begin"))
+      else if(bindings->key_matches(k, begin_action))
 	move_selection_top();
-      else if(bindings->key_matches(k, "End"))
+      else if(bindings->key_matches(k, end_action))
 	move_selection_bottom();
-      else if(bindings->key_matches(k, "Confirm"))
+      else if(bindings->key_matches(k, confirm_action))
 	{
 	  itemlist::size_type selected=cursorloc;
 
@@ -507,10 +513,15 @@ namespace cwidget
       widget_ref tmpref(this);
 
       int width, height;
-      const style border_style=st+get_style("MenuBorder");
-      const style highlighted_style=st+get_style("HighlightedMenuEntry");
-      const style entry_style=st+get_style("MenuEntry");
-      const style disabled_style=st+get_style("DisabledMenuEntry");
+      static const style_handle menu_border("MenuBorder");
+      static const style_handle highlighted_menu_entry("HighlightedMenuEntry");
+      static const style_handle menu_entry("MenuEntry");
+      static const style_handle disabled_menu_entry("DisabledMenuEntry");
+
+      const style border_style=st+get_style(menu_border);
+      const style highlighted_style=st+get_style(highlighted_menu_entry);
+      const style entry_style=st+get_style(menu_entry);
+      const style disabled_style=st+get_style(disabled_menu_entry);
 
       getmaxyx(height, width);
 
@@ -241,6 +241,8 @@ namespace cwidget
       // FIXME: there should be a less hacky way..
       sigc::signal0<void> menus_goaway;
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
       static void init_bindings();
     };
@@ -246,7 +246,7 @@ namespace cwidget
 	  subwidget->focussed();
 	}
 
-      toplevel::queuelayout();
+      size_changed();
     }
 
     void menubar::show_all()
@@ -334,12 +334,12 @@ namespace cwidget
 	    }
 
 	  // Now expand our width request.
-	  w=max(w, menux+(*i)->width_request());
+	  w=max(w, menux+(*i)->get_width_request());
 	}
 
       // Expand the width to account for the subwidget.
       if(subwidget.valid())
-	w=max(w, subwidget->width_request());
+	w=max(w, subwidget->get_width_request());
 
       return w;
     }
@@ -355,11 +355,11 @@ namespace cwidget
       for(activemenulist::iterator i=active_menus.begin();
 	  i!=active_menus.end();
 	  ++i)
-	h=max(h, 1+(*i)->height_request(w));
+	h=max(h, 1+(*i)->get_height_request(w));
 
       if(subwidget.valid())
 	{
-	  int subwidget_h=subwidget->height_request(w);
+	  int subwidget_h=subwidget->get_height_request(w);
 
 	  if(always_visible)
 	    subwidget_h+=1;
@@ -394,7 +394,7 @@ namespace cwidget
 
 	  int menux = get_menustart(menuloc);
 
-	  int req_w=(*i)->width_request();
+	  int req_w=(*i)->get_width_request();
 
 	  if(menux < 0)
 	    menux = 0;
@@ -409,7 +409,7 @@ namespace cwidget
 		}
 	    }
 
-	  int req_h = (*i)->height_request(req_w);
+	  int req_h = (*i)->get_height_request(req_w);
 
 	  if(getmaxy() < 1 + req_h)
 	    req_h = getmaxy()-1;
@@ -447,7 +447,7 @@ namespace cwidget
 
 	  w->focussed();
 
-	  toplevel::queuelayout();
+	  size_changed();
 	  toplevel::update();
 	}
     }
@@ -471,7 +471,7 @@ namespace cwidget
 		  if(new_focus.valid())
 		    new_focus->focussed();
 
-		  toplevel::queuelayout();
+		  size_changed();
 		  toplevel::update();
 		  return;
 		}
@@ -532,9 +532,16 @@ namespace cwidget
 
     bool menubar::handle_key(const config::key &k)
     {
+      static const config::action_id toggle_menu_active_action = config::get_action_id("ToggleMenuActive");
+      static const config::action_id cancel_action = config::get_action_id("Cancel");
+      static const config::action_id right_action = config::get_action_id("Right");
+      static const config::action_id left_action = config::get_action_id("Left");
+      static const config::action_id down_action = config::get_action_id("Down");
+      static const config::action_id confirm_action = config::get_action_id("Confirm");
+
       widget_ref tmpref(this);
 
-      if(bindings->key_matches(k, "ToggleMenuActive"))
+      if(bindings->key_matches(k, toggle_menu_active_action))
 	{
 	  if(active)
 	    disappear();
@@ -543,7 +550,7 @@ namespace cwidget
 	}
       else if(active)
 	{
-	  if(bindings->key_matches(k, "Cancel"))
+	  if(bindings->key_matches(k, cancel_action))
 	    {
 	      disappear();
 
@@ -556,7 +563,7 @@ namespace cwidget
 	    }
 	  else if(!active_menus.empty())
 	    {
-	      if(bindings->key_matches(k, "Right"))
+	      if(bindings->key_matches(k, right_action))
 		{
 		  if(items.size()>0)
 		    {
@@ -576,7 +583,7 @@ namespace cwidget
 		      toplevel::update();
 		    }
 		}
-	      else if(bindings->key_matches(k, "Left"))
+	      else if(bindings->key_matches(k, left_action))
 		{
 		  if(items.size()>0)
 		    {
@@ -601,7 +608,7 @@ namespace cwidget
 	      else
 		return widget::handle_key(k);
 	    }
-	  else if(bindings->key_matches(k, "Right"))
+	  else if(bindings->key_matches(k, right_action))
 	    {
 	      if(items.size()>0)
 		{
@@ -614,7 +621,7 @@ namespace cwidget
 		  toplevel::update();
 		}
 	    }
-	  else if(bindings->key_matches(k, "Left"))
+	  else if(bindings->key_matches(k, left_action))
 	    {
 	      if(items.size()>0)
 		{
@@ -627,8 +634,8 @@ namespace cwidget
 		  toplevel::update();
 		}
 	    }
-	  else if(bindings->key_matches(k, "Down") ||
-		  bindings->key_matches(k, "Confirm"))
+	  else if(bindings->key_matches(k, down_action) ||
+		  bindings->key_matches(k, confirm_action))
 	    {
 	      if(items.size()>0)
 		items[curloc].child_menu->show();
@@ -646,6 +653,16 @@ namespace cwidget
       return true;
     }
 
+    bool menubar::handle_paste(const std::wstring &text)
+    {
+      widget_ref tmpref(this);
+
+      if(!active && subwidget.valid())
+	return subwidget->dispatch_paste(text);
+      else
+	return widget::handle_paste(text);
+    }
+
     void menubar::paint(const style &st)
     {
       widget_ref tmpref(this);
@@ -655,8 +672,11 @@ namespace cwidget
 
       if(active || always_visible)
 	{
-	  const style menubar_style=get_style("MenuBar");
-	  const style highlightedmenubar_style=get_style("HighlightedMenuBar");
+	  static const style_handle menu_bar("MenuBar");
+	  static const style_handle highlighted_menu_bar("HighlightedMenuBar");
+
+	  const style &menubar_style=get_style(menu_bar);
+	  const style &highlightedmenubar_style=get_style(highlighted_menu_bar);
 
 	  if(active)
 	    for(activemenulist::reverse_iterator i=active_menus.rbegin();
@@ -780,7 +800,7 @@ namespace cwidget
 	{
 	  always_visible=_always_visible;
 	  toplevel::update();
-	  toplevel::queuelayout();
+	  size_changed();
 	}
     }
   }
@@ -101,6 +101,7 @@ namespace cwidget
       void lost_focus();
     protected:
       virtual bool handle_key(const config::key &k);
+      virtual bool handle_paste(const std::wstring &text);
 
       menubar(bool _always_visible);
     public:
@@ -148,6 +149,8 @@ namespace cwidget
       bool get_always_visible() {return always_visible;}
       void set_always_visible(bool _always_visible);
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
       static void init_bindings();
     };
@@ -93,7 +93,7 @@ namespace cwidget
 	}
       refocus();
 
-      toplevel::queuelayout();
+      size_changed();
       toplevel::update();
     }
 
@@ -104,13 +104,13 @@ namespace cwidget
       int w=0;
 
       if(status.valid())
-	w=max(w, status->width_request());
+	w=max(w, status->get_width_request());
 
       if(header.valid())
-	w=max(w, header->width_request());
+	w=max(w, header->get_width_request());
 
       if(main_widget.valid())
-	w=max(w, main_widget->width_request());
+	w=max(w, main_widget->get_width_request());
 
       return w;
     }
@@ -122,7 +122,7 @@ namespace cwidget
       int h=2;
 
       if(main_widget.valid())
-	h=max(h, main_widget->height_request(w));
+	h=max(h, main_widget->get_height_request(w));
       return h;
     }
 
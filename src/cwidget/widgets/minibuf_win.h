@@ -88,8 +88,17 @@ namespace cwidget
 
       widget_ref get_focus();
 
-      static const style &retr_header_style() {return get_style("Header");}
-      static const style &retr_status_style() {return get_style("Status");}
+      static const style &retr_header_style()
+      {
+	static const style_handle header_style("Header");
+	return get_style(header_style);
+      }
+
+      static const style &retr_status_style()
+      {
+	static const style_handle status_style("Status");
+	return get_style(status_style);
+      }
       void display_error(std::string err);
 
       void add_widget(const widget_ref &widget);
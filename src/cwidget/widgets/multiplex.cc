@@ -81,7 +81,7 @@ namespace cwidget
     void multiplex::set_show_tabs(bool shown)
     {
       show_tabs = shown;
-      toplevel::queuelayout();
+      size_changed();
     }
 
     int multiplex::width_request()
@@ -93,7 +93,7 @@ namespace cwidget
       for(list<child_info>::iterator i=children.begin();
 	  i!=children.end(); ++i)
 	if(i->w->get_visible())
-	  rval=max(rval, i->w->width_request());
+	  rval=max(rval, i->w->get_width_request());
 
       return rval;
     }
@@ -107,7 +107,7 @@ namespace cwidget
       for(list<child_info>::iterator i=children.begin();
 	  i!=children.end(); ++i)
 	if(i->w->get_visible())
-	  rval=max(rval, i->w->height_request(width));
+	  rval=max(rval, i->w->get_height_request(width));
 
       if(tabs_visible())
 	return rval+1;
@@ -147,8 +147,11 @@ namespace cwidget
 	  int remaining_w=getmaxx();
 	  move(0, 0);
 
-	  const style tab_style=get_style("MultiplexTab");
-	  const style tabhighlighted_style=get_style("MultiplexTabHighlighted");
+	  static const style_handle multiplex_tab("MultiplexTab");
+	  static const style_handle multiplex_tab_highlighted("MultiplexTabHighlighted");
+
+	  const style &tab_style=get_style(multiplex_tab);
+	  const style &tabhighlighted_style=get_style(multiplex_tab_highlighted);
 
 	  for(list<child_info>::iterator i=children.begin();
 	      i!=children.end(); ++i)
@@ -230,7 +233,7 @@ namespace cwidget
 		if(x>=startx && x<startx+thisw)
 		  {
 		    visible_child=i;
-		    toplevel::queuelayout();
+		    queue_layout();
 		    return;
 		  }
 
@@ -308,7 +311,7 @@ namespace cwidget
       if(visible_child != old_visible)
 	{
 	  cycled();
-	  toplevel::queuelayout();
+	  size_changed();
 	  toplevel::update();
 	}
     }
@@ -363,7 +366,7 @@ namespace cwidget
 	  eassert(visible_child != old_visible);
 
 	  cycled();
-	  toplevel::queuelayout();
+	  size_changed();
 	  toplevel::update();
 	}
     }
@@ -413,7 +416,7 @@ namespace cwidget
 	  i=j;
 	}
 
-      toplevel::queuelayout();
+      size_changed();
       toplevel::update();
     }
 
@@ -511,7 +514,7 @@ namespace cwidget
 	  if(visible_child != old_visible)
 	    {
 	      cycled();
-	      toplevel::queuelayout();
+	      queue_layout();
 	      toplevel::update();
 	    }
 	}
@@ -560,7 +563,7 @@ namespace cwidget
 	    {
 	      cycled();
 
-	      toplevel::queuelayout();
+	      queue_layout();
 	      toplevel::update();
 	    }
 	}
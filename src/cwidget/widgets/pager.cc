@@ -135,7 +135,7 @@ namespace cwidget
       first_column=0;
 
       do_line_signal();
-      toplevel::queuelayout();
+      size_changed();
       toplevel::redraw();
     }
 
@@ -155,6 +155,11 @@ namespace cwidget
       column_changed(first_column, realmax);
     }
 
+    // Scrolling just moves first_line and repaints everything.  When
+    // the screen is updated, curses notices that lines moved and
+    // scrolls the terminal instead of sending them again, so only the
+    // newly exposed lines are transmitted.
+
     void pager::scroll_up(line_count nlines)
     {
       widget_ref tmpref(this);
@@ -290,23 +295,32 @@ namespace cwidget
 
     bool pager::handle_key(const config::key &k)
     {
+      static const config::action_id up_action = config::get_action_id("Up");
+      static const config::action_id down_action = config::get_action_id("Down");
+      static const config::action_id left_action = config::get_action_id("Left");
+      static const config::action_id right_action = config::get_action_id("Right");
+      static const config::action_id prev_page_action = config::get_action_id("PrevPage");
+      static const config::action_id next_page_action = config::get_action_id("NextPage");
+      static const config::action_id begin_action = config::get_action_id("Begin");
+      static const config::action_id end_action = config::get_action_id("End");
+
       widget_ref tmpref(this);
 
-      if(bindings->key_matches(k, "Up"))
-	scroll_up(1);
-      else if(bindings->key_matches(k, "Down"))
-	scroll_down(1);
-      else if(bindings->key_matches(k, "Left"))
-	scroll_left(1);
-      else if(bindings->key_matches(k, "Right"))
-	scroll_right(1);
-      else if(bindings->key_matches(k, "PrevPage"))
-	scroll_up(getmaxy());
-      else if(bindings->key_matches(k, "NextPage"))
-	scroll_down(getmaxy());
-      else if(bindings->key_matches(k, "Begin"))
+      if(bindings->key_matches(k, up_action))
+	scroll_up(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, down_action))
+	scroll_down(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, left_action))
+	scroll_left(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, right_action))
+	scroll_right(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, prev_page_action))
+	scroll_up(getmaxy() * (1 + toplevel::take_key_repeats()));
+      else if(bindings->key_matches(k, next_page_action))
+	scroll_down(getmaxy() * (1 + toplevel::take_key_repeats()));
+      else if(bindings->key_matches(k, begin_action))
 	scroll_top();
-      else if(bindings->key_matches(k, "End"))
+      else if(bindings->key_matches(k, end_action))
 	scroll_bottom();
       else
 	return widget::handle_key(k);
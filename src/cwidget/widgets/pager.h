@@ -202,6 +202,8 @@ namespace cwidget
       /** Announces that the user has scrolled horizontally. */
       sigc::signal2<void, int, int> column_changed;
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
       static void init_bindings();
     };
@@ -100,6 +100,18 @@ namespace cwidget
 	return container::handle_key(k);
     }
 
+    bool passthrough::handle_paste(const std::wstring &text)
+    {
+      widget_ref tmpref(this);
+
+      widget_ref w = get_focus();
+
+      if(w.valid() && w->get_visible() && w->focus_me())
+	return w->dispatch_paste(text);
+      else
+	return container::handle_paste(text);
+    }
+
     void passthrough::dispatch_mouse(short id, int x, int y, int z,
 					mmask_t bstate)
     {
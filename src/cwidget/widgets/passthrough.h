@@ -19,6 +19,7 @@ namespace cwidget
 
     protected:
       virtual bool handle_key(const config::key &k);
+      virtual bool handle_paste(const std::wstring &text);
 
       // These call focussed() and unfocussed() on the result of get_focus().
       // (convenience methods)
@@ -29,7 +29,7 @@ namespace cwidget
       widget_ref child = get_subwidget();
 
       if(child.valid())
-	return max(child->width_request(), min_size.w);
+	return max(child->get_width_request(), min_size.w);
       else
 	return min_size.w;
     }
@@ -41,7 +41,7 @@ namespace cwidget
       widget_ref child = get_subwidget();
 
       if(child.valid())
-	return max(child->height_request(w), min_size.h);
+	return max(child->get_height_request(w), min_size.h);
       else
 	return min_size.h;
     }
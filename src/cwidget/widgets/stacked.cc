@@ -6,6 +6,8 @@
 #include <sigc++/adaptors/bind.h>
 #include <sigc++/functors/mem_fun.h>
 
+#include <vector>
+
 namespace cwidget
 {
   namespace widgets
@@ -129,12 +131,45 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
-      // Go through the children back-to-front (reverse order)
-      for(childlist::reverse_iterator i=children.rbegin();
-	  i!=children.rend();
+      // Find the children that aren't completely hidden behind an
+      // opaque part of a higher child, working from the top down.
+      std::vector<rect> covered;
+      std::vector<widget_ref> to_paint;
+
+      for(childlist::iterator i=children.begin(); i!=children.end(); i++)
+	{
+	  if(!i->w->get_visible())
+	    continue;
+
+	  const rect area(i->w->get_startx(), i->w->get_starty(),
+			  i->w->get_width(), i->w->get_height());
+
+	  bool hidden = false;
+	  for(std::vector<rect>::const_iterator j = covered.begin();
+	      !hidden && j != covered.end(); ++j)
+	    hidden = (area.x >= j->x && area.y >= j->y &&
+		      area.x + area.w <= j->x + j->w &&
+		      area.y + area.h <= j->y + j->h);
+
+	  if(hidden)
+	    continue;
+
+	  to_paint.push_back(i->w);
+
+	  rect opaque = i->w->get_opaque_region();
+	  if(opaque.w > 0 && opaque.h > 0)
+	    {
+	      opaque.x += area.x;
+	      opaque.y += area.y;
+	      covered.push_back(opaque);
+	    }
+	}
+
+      // Paint them back-to-front (reverse order)
+      for(std::vector<widget_ref>::reverse_iterator i=to_paint.rbegin();
+	  i!=to_paint.rend();
 	  i++)
-	if(i->w->get_visible())
-	  i->w->display(st);
+	(*i)->display(st);
     }
 
     void stacked::dispatch_mouse(short id, int x, int y, int z, mmask_t bstate)
@@ -34,15 +34,18 @@ namespace cwidget
 
     bool statuschoice::handle_key(const config::key &k)
     {
+      static const config::action_id confirm_action = config::get_action_id("Confirm");
+      static const config::action_id cancel_action = config::get_action_id("Cancel");
+
       widget_ref tmpref(this);
 
-      if(bindings->key_matches(k, "Confirm"))
+      if(bindings->key_matches(k, confirm_action))
 	{
 	  chosen(0);
 	  destroy();
 	  return true;
 	}
-      else if(bindings->key_matches(k, "Cancel"))
+      else if(bindings->key_matches(k, cancel_action))
 	{
 	  destroy();
 	  return true;
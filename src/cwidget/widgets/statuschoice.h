@@ -81,6 +81,8 @@ namespace cwidget
       // Called when one of the choices is selected (the arguments is the
       // position of the choice in the "choices" string)
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
       static void init_bindings();
     };
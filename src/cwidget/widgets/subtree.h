@@ -22,7 +22,8 @@
 #ifndef SUBTREE_H
 #define SUBTREE_H
 
-#include <list>
+#include <algorithm>
+#include <vector>
 #include "treeitem.h"
 #include "tree.h"
 
@@ -40,27 +41,84 @@ namespace cwidget
     {
     protected:
 
-      typedef std::list<childtype *> child_list;
-      typedef typename std::list<childtype *>::iterator child_iterator;
+      typedef std::vector<childtype *> child_list;
+      typedef typename std::vector<childtype *>::iterator child_iterator;
 
+      // Refers to an item by its position, so that references survive
+      // adding children.  The item itself is remembered too: if a sort
+      // moves it, the reference follows it to its new position.  The
+      // end of the list is kept as npos rather than the current size,
+      // so that it stays the end.
       class levelref:public tree_levelref
       {
-	child_iterator realitem;
+	typedef typename child_list::size_type size_type;
+
+	static size_type npos() {return static_cast<size_type>(-1);}
+
+	size_type item_num;
+
+	// The item at item_num, or NULL at the end of the list.
+	childtype *item;
 
 	child_list *parent_list;
+
+	// Find the item again if the children were reordered.
+	void resync()
+	{
+	  if(item==NULL ||
+	     (item_num<parent_list->size() && (*parent_list)[item_num]==item))
+	    return;
+
+	  typename child_list::iterator found=
+	    std::find(parent_list->begin(), parent_list->end(), item);
+	  if(found!=parent_list->end())
+	    item_num=found-parent_list->begin();
+	}
+
+	void set_item_num(size_type _item_num)
+	{
+	  if(_item_num<parent_list->size())
+	    {
+	      item_num=_item_num;
+	      item=(*parent_list)[item_num];
+	    }
+	  else
+	    {
+	      item_num=npos();
+	      item=NULL;
+	    }
+	}
       public:
 	levelref(const levelref &x)
-	  :tree_levelref(x), realitem(x.realitem), parent_list(x.parent_list) {}
-	levelref(const child_iterator &_realitem, child_list *_parent_list)
-	  :realitem(_realitem), parent_list(_parent_list)
+	  :tree_levelref(x), item_num(x.item_num), item(x.item),
+	   parent_list(x.parent_list) {}
+	levelref(size_type _item_num, child_list *_parent_list)
+	  :parent_list(_parent_list)
 	{
+	  set_item_num(_item_num);
 	}
 
-	treeitem *get_item() {eassert(realitem!=parent_list->end()); return *realitem;}
-	virtual void advance_next() {++realitem;}
-	virtual void return_prev() {--realitem;}
-	bool is_begin() {return realitem==parent_list->begin();}
-	bool is_end() {return realitem==parent_list->end();}
+	treeitem *get_item()
+	{
+	  resync();
+	  eassert(item_num<parent_list->size());
+	  return (*parent_list)[item_num];
+	}
+	virtual void advance_next()
+	{
+	  resync();
+	  if(item!=NULL)
+	    set_item_num(item_num+1);
+	}
+	virtual void return_prev()
+	{
+	  resync();
+	  if(item_num>=parent_list->size())
+	    item_num=parent_list->size();
+	  set_item_num(item_num-1);
+	}
+	bool is_begin() {resync(); return item_num==0;}
+	bool is_end() {resync(); return item_num>=parent_list->size();}
 	levelref *clone() const {return new levelref(*this);}
       };
 
@@ -69,15 +127,55 @@ namespace cwidget
 
       child_list children;
 
+      // The policy of a lazy sort that hasn't reached this level yet, or
+      // NULL.
+      sortpolicy *pending_sort;
+
+      // Puts the children in order, without sorting their own children.
+      void sort_level(const std::vector<treeitem *> &items,
+		      sortpolicy &sort_method)
+      {
+	if(items.size()<2)
+	  return;
+
+	std::vector<std::vector<treeitem *>::size_type> order;
+	sort_order(items, sort_method, order);
+
+	child_list sorted;
+	sorted.reserve(children.size());
+	for(typename std::vector<std::vector<treeitem *>::size_type>::const_iterator
+	      i=order.begin(); i!=order.end(); ++i)
+	  sorted.push_back(children[*i]);
+
+	children.swap(sorted);
+      }
+
+      // Called before the children are traversed: sorts this level if a
+      // lazy sort is pending, and passes the sort down to the children.
+      void apply_pending_sort()
+      {
+	if(pending_sort==NULL)
+	  return;
+
+	sortpolicy &sort_method=*pending_sort;
+	pending_sort=NULL;
+
+	sort_level(std::vector<treeitem *>(children.begin(), children.end()),
+		   sort_method);
+
+	for(child_iterator i=children.begin(); i!=children.end(); i++)
+	  (*i)->sort_lazily(sort_method);
+      }
+
     protected:
-      child_iterator get_children_begin() {return children.begin();}
-      child_iterator get_children_end() {return children.end();}
+      child_iterator get_children_begin() {apply_pending_sort(); return children.begin();}
+      child_iterator get_children_end() {apply_pending_sort(); return children.end();}
 
     public:
       typedef treeiterator iterator;
       typedef default_sorter default_sort;
 
-      subtree(bool _expanded):treeitem(),expanded(_expanded) {}
+      subtree(bool _expanded):treeitem(),expanded(_expanded),pending_sort(NULL) {}
 
       bool get_expanded() {return expanded;}
 
@@ -167,12 +265,23 @@ namespace cwidget
       // Adds a new child item at an unspecified location -- you should call sort()
       // after adding children or the tree will have an undetermined order.  (yes,
       // you can deduce the real order.  Don't.)
+
+      // Sorts the children and everything below them.  If the policy is
+      // thread-safe, the child subtrees are sorted in parallel.
       void sort(sortpolicy &sort_method)
       {
-	for(child_iterator i=children.begin(); i!=children.end(); i++)
-	  (*i)->sort(sort_method);
+	pending_sort=NULL;
 
-	children.sort(sortpolicy_wrapper(sort_method));
+	std::vector<treeitem *> items(children.begin(), children.end());
+	sort_subtrees(items, sort_method);
+	sort_level(items, sort_method);
+      }
+
+      // Sorts each level when its children are first traversed, so that
+      // collapsed subtrees which are never shown are never sorted.
+      void sort_lazily(sortpolicy &sort_method)
+      {
+	pending_sort=&sort_method;
       }
 
       void sort()
@@ -183,12 +292,18 @@ namespace cwidget
 
       virtual bool dispatch_key(const config::key &k, tree *owner)
       {
-	if(tree::bindings->key_matches(k, "ToggleExpanded"))
+	static const config::action_id toggle_expanded_action = config::get_action_id("ToggleExpanded");
+	static const config::action_id expand_tree_action = config::get_action_id("ExpandTree");
+	static const config::action_id collapse_tree_action = config::get_action_id("CollapseTree");
+	static const config::action_id expand_all_action = config::get_action_id("ExpandAll");
+	static const config::action_id collapse_all_action = config::get_action_id("CollapseAll");
+
+	if(tree::bindings->key_matches(k, toggle_expanded_action))
 	  {
 	    expanded=!expanded;
 	    return true;
 	  }
-	else if(tree::bindings->key_matches(k, "ExpandTree"))
+	else if(tree::bindings->key_matches(k, expand_tree_action))
 	  {
 	    if(!expanded)
 	      {
@@ -198,7 +313,7 @@ namespace cwidget
 	    else
 	      return false;
 	  }
-	else if(tree::bindings->key_matches(k, "CollapseTree"))
+	else if(tree::bindings->key_matches(k, collapse_tree_action))
 	  {
 	    if(expanded)
 	      {
@@ -207,12 +322,12 @@ namespace cwidget
 	      } else
 	      return false;
 	  }
-	else if(tree::bindings->key_matches(k, "ExpandAll"))
+	else if(tree::bindings->key_matches(k, expand_all_action))
 	  {
 	    expand_all();
 	    return true;
 	  }
-	else if(tree::bindings->key_matches(k, "CollapseAll"))
+	else if(tree::bindings->key_matches(k, collapse_all_action))
 	  {
 	    collapse_all();
 	    return true;
@@ -232,21 +347,25 @@ namespace cwidget
 	  expanded=!expanded;
       }
 
-      virtual levelref *begin() {return new levelref(children.begin(), &children);}
-      virtual levelref *end() {return new levelref(children.end(), &children);}
+      virtual levelref *begin()
+      {
+	apply_pending_sort();
+	return new levelref(0, &children);
+      }
+
+      virtual levelref *end()
+      {
+	apply_pending_sort();
+	return new levelref(children.size(), &children);
+      }
 
       bool has_visible_children() {return expanded && children.size()>0;}
       bool has_children() {return children.size()>0;}
 
       virtual ~subtree()
       {
-	child_iterator i,j;
-	for(i=children.begin(); i!=children.end(); i=j)
-	  {
-	    j=i;
-	    j++;
-	    delete *i;
-	  }
+	for(child_iterator i=children.begin(); i!=children.end(); ++i)
+	  delete *i;
       }
     };
 
@@ -57,7 +57,9 @@ namespace cwidget
     }
 
     table::table()
-      :rowsep(0), colsep(0), num_rows(0), num_cols(0)
+      :rowsep(0), colsep(0), num_rows(0), num_cols(0), index_stale(true),
+       n_expandable_cols(0), n_expandable_rows(0),
+       cells_stale(true), cells_overlap(false)
     {
       do_layout.connect(sigc::mem_fun(*this, &table::layout_me));
       focus=children.end();
@@ -182,7 +184,7 @@ namespace cwidget
 	    focus->w->focussed();
 	}
 
-      toplevel::queuelayout();
+      children_changed();
     }
 
     void table::hide_widget_bare(widget &w)
@@ -220,7 +222,7 @@ namespace cwidget
 	    focus->w->focussed();
 	}
 
-      toplevel::queuelayout();
+      children_changed();
     }
 
     void table::show_widget_bare(widget &w)
@@ -246,7 +248,7 @@ namespace cwidget
 	      }
 	}
 
-      toplevel::queuelayout();
+      children_changed();
     }
 
     void table::add_widget(const widget_ref &w)
@@ -273,6 +275,93 @@ namespace cwidget
       num_cols=num_cols;
     }
 
+    class table::nrow_lt
+    {
+    public:
+      inline bool operator()(const child_info *a,
+			     const child_info *b)
+      {
+	return a->row_span<b->row_span;
+      }
+    };
+
+    class table::ncol_lt
+    {
+    public:
+      inline bool operator()(const child_info *a,
+			     const child_info *b)
+      {
+	return a->col_span<b->col_span;
+      }
+    };
+
+    void table::children_changed()
+    {
+      index_stale=true;
+      cells_stale=true;
+      size_changed();
+    }
+
+    void table::update_index()
+    {
+      if(!index_stale)
+	return;
+
+      by_col_span.clear();
+      by_row_span.clear();
+
+      for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
+	if(i->w->get_visible())
+	  by_col_span.push_back(&*i);
+
+      by_row_span=by_col_span;
+
+      stable_sort(by_col_span.begin(), by_col_span.end(), ncol_lt());
+      stable_sort(by_row_span.begin(), by_row_span.end(), nrow_lt());
+
+      col_expandable.assign(num_cols, false);
+      row_expandable.assign(num_rows, false);
+      col_fixed.assign(num_cols, false);
+      row_fixed.assign(num_rows, false);
+
+      // Decide which columns to expand: first mark smaller widgets for
+      // expansion; then, if a larger widget doesn't overlap any smaller
+      // widget that's to be expanded, mark all of its cols for expansion.
+      for(vector<child_info *>::const_iterator i=by_col_span.begin();
+	  i!=by_col_span.end(); ++i)
+	{
+	  const int start=(*i)->col_start, end=start+(*i)->col_span;
+
+	  if((*i)->expand_x &&
+	     find(col_expandable.begin()+start,
+		  col_expandable.begin()+end, true)==col_expandable.begin()+end)
+	    fill(col_expandable.begin()+start, col_expandable.begin()+end, true);
+
+	  if(!(*i)->shrink_x)
+	    fill(col_fixed.begin()+start, col_fixed.begin()+end, true);
+	}
+
+      // Likewise for the rows.
+      for(vector<child_info *>::const_iterator i=by_row_span.begin();
+	  i!=by_row_span.end(); ++i)
+	{
+	  const int start=(*i)->row_start, end=start+(*i)->row_span;
+
+	  if((*i)->expand_y &&
+	     find(row_expandable.begin()+start,
+		  row_expandable.begin()+end, true)==row_expandable.begin()+end)
+	    fill(row_expandable.begin()+start, row_expandable.begin()+end, true);
+
+	  if(!(*i)->shrink_y)
+	    fill(row_fixed.begin()+start, row_fixed.begin()+end, true);
+	}
+
+      n_expandable_cols=count(col_expandable.begin(), col_expandable.end(), true);
+      n_expandable_rows=count(row_expandable.begin(), row_expandable.end(), true);
+
+      index_stale=false;
+    }
+
     void table::rem_widget(const widget_ref &wBare)
     {
       widget_ref tmpref(this);
@@ -319,7 +408,7 @@ namespace cwidget
 	    children.erase(i);
 
 
-	    toplevel::queuelayout();
+	    children_changed();
 	    w->set_owner(NULL);
 
 	    // No better way to do this..
@@ -548,25 +637,30 @@ namespace cwidget
       eassert(dx==0 || dy==0);
       eassert(!(dx==dy));
 
-      list<childlist::iterator> sorted_children;
+      // Keep the first of the best candidates, so ties go to the
+      // widget that was added first.
+      better_fit fit(*start, dx, dy, num_cols, num_rows);
+      childlist::iterator best=start;
 
       for(childlist::iterator i=children.begin();
 	  i!=children.end();
 	  ++i)
 	if(i!=start && i->w->get_visible() &&
-	   i->w->focus_me() && lies_on_axis(*start, (dy==0), *i))
-	  sorted_children.push_back(i);
+	   i->w->focus_me() && lies_on_axis(*start, (dy==0), *i) &&
+	   (best==start || fit(i, best)))
+	  best=i;
 
-      if(sorted_children.size()==0)
-	return start;
-
-      sorted_children.sort(better_fit(*start, dx, dy, num_cols, num_rows));
-
-      return sorted_children.front();
+      return best;
     }
 
     bool table::handle_key(const config::key &k)
     {
+      static const config::action_id cycle_action = config::get_action_id("Cycle");
+      static const config::action_id left_action = config::get_action_id("Left");
+      static const config::action_id right_action = config::get_action_id("Right");
+      static const config::action_id up_action = config::get_action_id("Up");
+      static const config::action_id down_action = config::get_action_id("Down");
+
       widget_ref tmpref(this);
 
       if(focus!=children.end())
@@ -575,7 +669,7 @@ namespace cwidget
 
 	  if(w->dispatch_key(k))
 	    return true;
-	  else if(bindings->key_matches(k, "Cycle"))
+	  else if(bindings->key_matches(k, cycle_action))
 	    {
 	      childlist::iterator oldfocus=focus;
 
@@ -605,7 +699,7 @@ namespace cwidget
 
 	      return focus!=oldfocus;
 	    }
-	  else if(bindings->key_matches(k, "Left"))
+	  else if(bindings->key_matches(k, left_action))
 	    {
 	      childlist::iterator oldfocus=focus;
 
@@ -623,7 +717,7 @@ namespace cwidget
 
 	      return focus!=oldfocus;
 	    }
-	  else if(bindings->key_matches(k, "Right"))
+	  else if(bindings->key_matches(k, right_action))
 	    {
 	      childlist::iterator oldfocus=focus;
 
@@ -641,7 +735,7 @@ namespace cwidget
 
 	      return focus!=oldfocus;
 	    }
-	  else if(bindings->key_matches(k, "Up"))
+	  else if(bindings->key_matches(k, up_action))
 	    {
 	      childlist::iterator oldfocus=focus;
 
@@ -659,7 +753,7 @@ namespace cwidget
 
 	      return focus!=oldfocus;
 	    }
-	  else if(bindings->key_matches(k, "Down"))
+	  else if(bindings->key_matches(k, down_action))
 	    {
 	      childlist::iterator oldfocus=focus;
 
@@ -684,26 +778,6 @@ namespace cwidget
 	return passthrough::handle_key(k);
     }
 
-    class table::nrow_lt
-    {
-    public:
-      inline bool operator()(const child_info *a,
-			     const child_info *b)
-      {
-	return a->row_span<b->row_span;
-      }
-    };
-
-    class table::ncol_lt
-    {
-    public:
-      inline bool operator()(const child_info *a,
-			     const child_info *b)
-      {
-	return a->col_span<b->col_span;
-      }
-    };
-
     /** Allocate "ideal" widths to all widgets: make every widget as large
      *  as it wants and expand other widgets to accomodate.  This routine
      *  also calculates the width_request member of the child.
@@ -715,8 +789,7 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
-      vector<bool> col_expandable(num_cols, false);
-      vector<child_info *> sorted_children;
+      update_index();
 
 #ifdef DEBUG_TABLES
       fprintf(debug, "---------- Begin ideal width allocation for 0x%x (w=%d,h=%d) ----------\n", this, getmaxx(), getmaxy());
@@ -725,37 +798,9 @@ namespace cwidget
       for(vector<int>::iterator i=col_sizes.begin(); i!=col_sizes.end(); ++i)
 	*i=0;
 
-      for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
-	if(i->w->get_visible())
-	  sorted_children.push_back(&*i);
-
-      // Sort the children according to how many columns they span
-      sort(sorted_children.begin(), sorted_children.end(), ncol_lt());
-
-      // Decide which columns to expand: first mark smaller widgets for
-      // expansion; then, if a larger widget doesn't overlap any smaller
-      // widget that's to be expanded, mark all of its cols for expansion.
-      for(vector<child_info *>::const_iterator i=sorted_children.begin();
-	  i!=sorted_children.end(); ++i)
-	if((*i)->expand_x)
-	  {
-	    bool expanded=false;
-
-	    for(int j=0; j<(*i)->col_span; ++j)
-	      if(col_expandable[j+(*i)->col_start])
-		{
-		  expanded=true;
-		  break;
-		}
-
-	    if(!expanded)
-	      for(int j=0; j<(*i)->col_span; ++j)
-		col_expandable[j+(*i)->col_start]=true;
-	  }
-
-      // Now try to expand columns.
-      for(vector<child_info *>::const_iterator i=sorted_children.begin();
-	  i!=sorted_children.end(); ++i)
+      // Try to expand columns, narrowest widgets first.
+      for(vector<child_info *>::const_iterator i=by_col_span.begin();
+	  i!=by_col_span.end(); ++i)
 	{
 	  // If this widget doesn't have enough space, we need to expand
 	  // some of the columns it spans.  Otherwise, figure out which
@@ -777,7 +822,7 @@ namespace cwidget
 	    n_expandable=(*i)->col_span;
 
 	  if(!(*i)->ignore_size_x)
-	    (*i)->request_w=(*i)->w->width_request();
+	    (*i)->request_w=(*i)->w->get_width_request();
 	  else
 	    (*i)->request_w=0;
 	  int shortfall=(*i)->request_w-current_width;
@@ -836,41 +881,9 @@ namespace cwidget
       fprintf(debug, "**************** Expanding 0x%x (w=%d, h=%d) to %d columns ******************\n", this, getmaxx(), getmaxy(), target_w);
 #endif
 
-      // Note that this is redundant with the previous algorithm.  Merge?
-      vector<child_info *> sorted_children;
-
-      for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
-	if(i->w->get_visible() && i->expand_x)
-	  sorted_children.push_back(&*i);
-
-      // Sort the children according to how many columns they span
-      sort(sorted_children.begin(), sorted_children.end(), ncol_lt());
-
-
-      // This is also redundant; merge?
-      vector<bool> col_expandable(num_cols, false);
+      update_index();
 
-      int n_expandable=0;
-      for(vector<child_info *>::const_iterator i=sorted_children.begin();
-	  i!=sorted_children.end(); ++i)
-	{
-	  bool expanded=false;
-
-	  for(int j=0; j<(*i)->col_span; ++j)
-	    if(col_expandable[j+(*i)->col_start])
-	      {
-		expanded=true;
-		break;
-	      }
-
-	  if(!expanded)
-	    for(int j=0; j<(*i)->col_span; ++j)
-	      col_expandable[j+(*i)->col_start]=true;
-	}
-
-      for(int i=0; i<num_cols; ++i)
-	if(col_expandable[i])
-	  ++n_expandable;
+      int n_expandable=n_expandable_cols;
 
 #ifdef DEBUG_TABLES
       fprintf(debug, "Column sizes before:");
@@ -912,6 +925,8 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
+      update_index();
+
       vector<bool> col_shrinkable(num_cols, false);
       int n_shrinkable=0;
       int current_width=accumulate(col_sizes.begin(), col_sizes.end(), 0);
@@ -925,20 +940,11 @@ namespace cwidget
 #endif
 
       for(int i=0; i<num_cols; ++i)
-	col_shrinkable[i]=(col_sizes[i]>1);
-
-      for(childlist::const_iterator i=children.begin(); i!=children.end(); ++i)
-	{
-	  if(i->w->get_visible() && !i->shrink_x)
-	    {
-	      for(int j=0; j<i->col_span; ++j)
-		col_shrinkable[j+i->col_start]=false;
-	    }
-	}
-
-      for(int i=0; i<num_cols; ++i)
-	if(col_shrinkable[i])
-	  ++n_shrinkable;
+	if(col_sizes[i]>1 && !col_fixed[i])
+	  {
+	    col_shrinkable[i]=true;
+	    ++n_shrinkable;
+	  }
 
 #ifdef DEBUG_TABLES
       fprintf(debug, "Column sizes before:");
@@ -1009,8 +1015,7 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
-      vector<bool> row_expandable(num_rows, false);
-      vector<child_info *> sorted_children;
+      update_index();
 
 #ifdef DEBUG_TABLES
       fprintf(debug, "---------- Begin ideal height allocation for 0x%x (w=%d,h=%d) ----------\n", this, getmaxx(), getmaxy());
@@ -1019,37 +1024,14 @@ namespace cwidget
       for(vector<int>::iterator i=row_sizes.begin(); i!=row_sizes.end(); ++i)
 	*i=0;
 
-      for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
-	if(i->w->get_visible())
-	  sorted_children.push_back(&*i);
-
-      // Sort the children according to how many rows they span
-      sort(sorted_children.begin(), sorted_children.end(), nrow_lt());
-
-      // Decide which rows to expand: first mark smaller widgets for
-      // expansion; then, if a larger widget doesn't overlap any smaller
-      // widget that's to be expanded, mark all of its rows for expansion.
-      for(vector<child_info *>::const_iterator i=sorted_children.begin();
-	  i!=sorted_children.end(); ++i)
-	if((*i)->expand_y)
-	  {
-	    bool expanded=false;
-
-	    for(int j=0; j<(*i)->row_span; ++j)
-	      if(row_expandable[j+(*i)->row_start])
-		{
-		  expanded=true;
-		  break;
-		}
-
-	    if(!expanded)
-	      for(int j=0; j<(*i)->row_span; ++j)
-		row_expandable[j+(*i)->row_start]=true;
-	  }
+      // The columns are fixed by now, so the width of each widget can
+      // be read off their running totals.
+      vector<int> col_ends(num_cols+1, 0);
+      partial_sum(col_sizes.begin(), col_sizes.end(), col_ends.begin()+1);
 
-      // Now try to expand rows.
-      for(vector<child_info *>::const_iterator i=sorted_children.begin();
-	  i!=sorted_children.end(); ++i)
+      // Try to expand rows, shortest widgets first.
+      for(vector<child_info *>::const_iterator i=by_row_span.begin();
+	  i!=by_row_span.end(); ++i)
 	{
 	  // If this widget doesn't have enough space, we need to expand
 	  // some of the rows it spans.  Otherwise, figure out which
@@ -1057,9 +1039,7 @@ namespace cwidget
 	  // the rows are expandable, just expand each row that it
 	  // spans equally.
 
-	  int current_width=0;
-	  for(int j=(*i)->col_start; j<(*i)->col_start+(*i)->col_span; ++j)
-	    current_width+=col_sizes[j];
+	  const int current_width=col_ends[(*i)->col_start+(*i)->col_span]-col_ends[(*i)->col_start];
 
 	  int current_height=0;
 	  int n_expandable=0;
@@ -1075,7 +1055,7 @@ namespace cwidget
 	    n_expandable=(*i)->row_span;
 
 	  if(!(*i)->ignore_size_y)
-	    (*i)->request_h=(*i)->w->height_request(current_width);
+	    (*i)->request_h=(*i)->w->get_height_request(current_width);
 	  else
 	    (*i)->request_h=0;
 	  int shortfall=(*i)->request_h-current_height;
@@ -1135,41 +1115,9 @@ namespace cwidget
       fprintf(debug, "**************** Expanding 0x%x (w=%d, h=%d) to %d rows ******************\n", this, getmaxx(), getmaxy(), target_h);
 #endif
 
-      // Note that this is redundant with the previous algorithm.  Merge?
-      vector<child_info *> sorted_children;
-
-      for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
-	if(i->w->get_visible() && i->expand_y)
-	  sorted_children.push_back(&*i);
-
-      // Sort the children according to how many rows they span
-      sort(sorted_children.begin(), sorted_children.end(), nrow_lt());
-
-
-      // This is also redundant; merge?
-      vector<bool> row_expandable(num_rows, false);
-
-      int n_expandable=0;
-      for(vector<child_info *>::const_iterator i=sorted_children.begin();
-	  i!=sorted_children.end(); ++i)
-	{
-	  bool expanded=false;
-
-	  for(int j=0; j<(*i)->row_span; ++j)
-	    if(row_expandable[j+(*i)->row_start])
-	      {
-		expanded=true;
-		break;
-	      }
-
-	  if(!expanded)
-	    for(int j=0; j<(*i)->row_span; ++j)
-	      row_expandable[j+(*i)->row_start]=true;
-	}
+      update_index();
 
-      for(int i=0; i<num_rows; ++i)
-	if(row_expandable[i])
-	  ++n_expandable;
+      int n_expandable=n_expandable_rows;
 
 #ifdef DEBUG_TABLES
       fprintf(debug, "Row sizes before:");
@@ -1211,6 +1159,8 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
+      update_index();
+
       vector<bool> row_shrinkable(num_rows, false);
       int n_shrinkable=0;
       int current_height=accumulate(row_sizes.begin(), row_sizes.end(), 0);
@@ -1224,20 +1174,11 @@ namespace cwidget
 #endif
 
       for(int i=0; i<num_rows; ++i)
-	row_shrinkable[i]=(row_sizes[i]>1);
-
-      for(childlist::const_iterator i=children.begin(); i!=children.end(); ++i)
-	{
-	  if(i->w->get_visible() && !i->shrink_y)
-	    {
-	      for(int j=0; j<i->row_span; ++j)
-		row_shrinkable[j+i->row_start]=false;
-	    }
-	}
-
-      for(int i=0; i<num_rows; ++i)
-	if(row_shrinkable[i])
-	  ++n_shrinkable;
+	if(row_sizes[i]>1 && !row_fixed[i])
+	  {
+	    row_shrinkable[i]=true;
+	    ++n_shrinkable;
+	  }
 
 #ifdef DEBUG_TABLES
       fprintf(debug, "Row sizes before:");
@@ -1308,35 +1249,20 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
-      vector<int> col_starts(num_cols), row_starts(num_rows);
-
-      // partial_sum almost works...but not quite.
-      int startx=0;
-      for(int i=0; i<num_cols; ++i)
-	{
-	  col_starts[i]=startx;
-	  startx+=col_sizes[i];
-	}
+      col_offsets.assign(num_cols+1, 0);
+      row_offsets.assign(num_rows+1, 0);
+      cells_stale=true;
 
-      int starty=0;
-      for(int i=0; i<num_rows; ++i)
-	{
-	  row_starts[i]=starty;
-	  starty+=row_sizes[i];
-	}
+      partial_sum(col_sizes.begin(), col_sizes.end(), col_offsets.begin()+1);
+      partial_sum(row_sizes.begin(), row_sizes.end(), row_offsets.begin()+1);
 
       for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
 	if(i->w->get_visible())
 	  {
-	    int x=col_starts[i->col_start];
-	    int y=row_starts[i->row_start];
-	    int width=0, height=0;
-
-	    for(int j=0; j<i->col_span; ++j)
-	      width+=col_sizes[j+i->col_start];
-
-	    for(int j=0; j<i->row_span; ++j)
-	      height+=row_sizes[j+i->row_start];
+	    int x=col_offsets[i->col_start];
+	    int y=row_offsets[i->row_start];
+	    int width=col_offsets[i->col_start+i->col_span]-x;
+	    int height=row_offsets[i->row_start+i->row_span]-y;
 
 	    eassert(x+width<=getmaxx());
 	    eassert(y+height<=getmaxy());
@@ -1420,8 +1346,14 @@ namespace cwidget
 	  alloc_child_sizes(col_sizes, row_sizes);
 	}
       else
-	for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
-	  i->w->alloc_size(0, 0, 0, 0);
+	{
+	  col_offsets.clear();
+	  row_offsets.clear();
+	  cells_stale=true;
+
+	  for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
+	    i->w->alloc_size(0, 0, 0, 0);
+	}
     }
 
     void table::paint(const style &st)
@@ -1433,23 +1365,85 @@ namespace cwidget
 	  i->w->display(st);
     }
 
+    void table::update_cells()
+    {
+      if(!cells_stale)
+	return;
+
+      const int ncols=col_offsets.empty() ? 0 : col_offsets.size()-1;
+      const int nrows=row_offsets.empty() ? 0 : row_offsets.size()-1;
+
+      cell_owners.assign(ncols*nrows, NULL);
+      cells_overlap=false;
+
+      // Children added since the last layout have no space yet, so
+      // anything outside the old grid is skipped.
+      for(childlist::iterator i=children.begin();
+	  i!=children.end() && !cells_overlap; ++i)
+	if(i->w->get_visible())
+	  for(int row=i->row_start;
+	      row<i->row_start+i->row_span && row<nrows; ++row)
+	    for(int col=i->col_start;
+		col<i->col_start+i->col_span && col<ncols; ++col)
+	      {
+		child_info *&owner=cell_owners[row*ncols+col];
+
+		if(owner!=NULL)
+		  cells_overlap=true;
+		else
+		  owner=&*i;
+	      }
+
+      cells_stale=false;
+    }
+
+    table::child_info *table::child_at(int y, int x)
+    {
+      update_cells();
+
+      if(cells_overlap)
+	{
+	  // The first child in the list wins, as it always has.
+	  for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
+	    if(i->w->get_visible() && i->w->enclose(y, x))
+	      return &*i;
+
+	  return NULL;
+	}
+
+      if(col_offsets.size()<2 || row_offsets.size()<2 ||
+	 x<0 || x>=col_offsets.back() || y<0 || y>=row_offsets.back())
+	return NULL;
+
+      // Find the last column (row) that starts at or before the point;
+      // empty columns (rows) are skipped over.
+      const int col=upper_bound(col_offsets.begin(), col_offsets.end(), x)-col_offsets.begin()-1;
+      const int row=upper_bound(row_offsets.begin(), row_offsets.end(), y)-row_offsets.begin()-1;
+
+      child_info *owner=cell_owners[row*(col_offsets.size()-1)+col];
+
+      // The child might not fill its cells.
+      if(owner!=NULL && owner->w->get_visible() && owner->w->enclose(y, x))
+	return owner;
+      else
+	return NULL;
+    }
+
     void table::dispatch_mouse(short id, int x, int y, int z, mmask_t bstate)
     {
       widget_ref tmpref(this);
 
-      for(childlist::iterator i=children.begin(); i!=children.end(); ++i)
+      child_info *c=child_at(y, x);
+
+      if(c!=NULL)
 	{
-	  widget_ref w = i->w;
+	  widget_ref w = c->w;
 
-	  if(w->get_visible() && w->enclose(y, x))
-	    {
-	      if(w->focus_me())
-		focus_widget(w);
+	  if(w->focus_me())
+	    focus_widget(w);
 
-	      w->dispatch_mouse(id, x-w->get_startx(), y-w->get_starty(),
-				z, bstate);
-	      return;
-	    }
+	  w->dispatch_mouse(id, x-w->get_startx(), y-w->get_starty(),
+			    z, bstate);
 	}
     }
 
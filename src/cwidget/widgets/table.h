@@ -111,19 +111,65 @@ namespace cwidget
       void show_widget(const widget_ref &w);
       void show_widget_bare(widget &w);
 
-      /** Populates the given vector with lists of the widgets in each
-       *  row.
-       *
-       *  \param row_contents a vector of length num_rows.
+      /** \b true if the layout index below is out of date. */
+      bool index_stale;
+
+      /** The visible children, ordered by the number of columns (rows)
+       *  that they span.  Children with the same span are kept in the
+       *  order in which they were added.
        */
-      void get_row_contents(std::vector<std::vector<child_info *> > row_contents);
+      std::vector<child_info *> by_col_span, by_row_span;
 
-      /** Populates the given vector with lists of the widgets in each
-       *  column.
-       *
-       *  \param col_contents a vector of length num_cols.
+      /** Which columns (rows) receive the extra space when the table
+       *  grows: those spanned by the narrowest expandable widgets.
+       */
+      std::vector<bool> col_expandable, row_expandable;
+
+      /** The number of \b true entries in col_expandable (row_expandable). */
+      int n_expandable_cols, n_expandable_rows;
+
+      /** Which columns (rows) are spanned by a visible widget that
+       *  can't be shrunk.
+       */
+      std::vector<bool> col_fixed, row_fixed;
+
+      /** Note that the set of visible children has changed. */
+      void children_changed();
+
+      /** Rebuild the layout index if it is out of date.  Everything in
+       *  it depends only on which children are visible and how they
+       *  are placed, so the layout passes themselves don't have to
+       *  sort or scan for it.
+       */
+      void update_index();
+
+      /** The offset of each column (row) in the last layout, followed
+       *  by the total width (height) of the columns (rows).  Empty if
+       *  the table has no window.
+       */
+      std::vector<int> col_offsets, row_offsets;
+
+      /** For each cell of the last layout, in row-major order, the
+       *  visible child that covers it, or NULL.  Used to find the
+       *  widget under the mouse without testing every child.
+       */
+      std::vector<child_info *> cell_owners;
+
+      /** \b true if cell_owners is out of date. */
+      bool cells_stale;
+
+      /** \b true if some cell is covered by more than one child, in
+       *  which case cell_owners isn't used.
        */
-      void get_col_contents(std::vector<std::vector<child_info *> > col_contents);
+      bool cells_overlap;
+
+      /** Rebuild cell_owners if it is out of date. */
+      void update_cells();
+
+      /** \return the visible child that encloses the given point, or
+       *  NULL if there is none.
+       */
+      child_info *child_at(int y, int x);
 
       void alloc_ideal_widths(std::vector<int> &col_sizes);
       void expand_widths(std::vector<int> &col_sizes, int target_w);
@@ -204,6 +250,8 @@ namespace cwidget
       void paint(const style &st);
       void dispatch_mouse(short id, int x, int y, int z, mmask_t bstate);
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
       static void init_bindings();
     };
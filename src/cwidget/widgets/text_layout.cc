@@ -55,17 +55,24 @@ namespace cwidget
 
     bool text_layout::handle_key(const config::key &k)
     {
-      if(bindings->key_matches(k, "Up"))
+      static const config::action_id up_action = config::get_action_id("Up");
+      static const config::action_id down_action = config::get_action_id("Down");
+      static const config::action_id begin_action = config::get_action_id("Begin");
+      static const config::action_id end_action = config::get_action_id("End");
+      static const config::action_id prev_page_action = config::get_action_id("PrevPage");
+      static const config::action_id next_page_action = config::get_action_id("NextPage");
+
+      if(bindings->key_matches(k, up_action))
 	line_up();
-      else if(bindings->key_matches(k, "Down"))
+      else if(bindings->key_matches(k, down_action))
 	line_down();
-      else if(bindings->key_matches(k, "Begin"))
+      else if(bindings->key_matches(k, begin_action))
 	move_to_top();
-      else if(bindings->key_matches(k, "End"))
+      else if(bindings->key_matches(k, end_action))
 	move_to_bottom();
-      else if(bindings->key_matches(k, "PrevPage"))
+      else if(bindings->key_matches(k, prev_page_action))
 	page_up();
-      else if(bindings->key_matches(k, "NextPage"))
+      else if(bindings->key_matches(k, next_page_action))
 	page_down();
       else
 	return widget::handle_key(k);
@@ -131,7 +138,7 @@ namespace cwidget
 
       // Don't just do an update, because our ideal width might change,
       // which means other stuff also has to change around.
-      toplevel::queuelayout();
+      size_changed();
     }
 
     void text_layout::append_fragment(fragment *_f)
@@ -139,7 +146,7 @@ namespace cwidget
       f=sequence_fragment(f, _f, NULL);
       stale=true;
 
-      toplevel::queuelayout();
+      size_changed();
     }
 
     void text_layout::set_start(unsigned int new_start)
@@ -290,30 +297,29 @@ namespace cwidget
       // Look for the first character of the string.
       while(new_start > 0 && new_start < contents.size())
 	{
-	  fragment_line &line(contents[new_start]);
+	  const fragment_line &line(contents[new_start]);
 
 	  // Search this line and the following lines (if there's an
 	  // overrun) for our string.
-	  for(fragment_line::const_iterator i = line.begin();
-	      i != line.end(); ++i)
+	  for(size_t i = 0; i < line.size(); ++i)
 	    {
-	      if(i->ch == s[0])
+	      if(line[i].ch == s[0])
 		{
 		  size_t tmp = new_start;
-		  fragment_line::const_iterator j = i;
+		  size_t j = i;
 		  wstring::const_iterator loc = s.begin();
 
 		  while(tmp < contents.size() && loc != s.end() &&
-			j->ch == *loc)
+			j < contents[tmp].size() &&
+			contents[tmp][j].ch == *loc)
 		    {
 		      ++loc;
 		      ++j;
 
-		      if(j == contents[tmp].end())
+		      if(j == contents[tmp].size())
 			{
 			  ++tmp;
-			  if(tmp < contents.size())
-			    j = contents[tmp].begin();
+			  j = 0;
 			}
 		    }
 
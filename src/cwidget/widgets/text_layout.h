@@ -160,6 +160,8 @@ namespace cwidget
        */
       sigc::signal2<void, int, int> location_changed;
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
 
       static void init_bindings();
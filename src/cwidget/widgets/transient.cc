@@ -35,7 +35,7 @@ namespace cwidget
       widget_ref w=get_subwidget();
 
       if(w.valid())
-	return w->width_request();
+	return w->get_width_request();
       else
 	return 0;
     }
@@ -45,7 +45,7 @@ namespace cwidget
       widget_ref w=get_subwidget();
 
       if(w.valid())
-	return w->height_request(width);
+	return w->get_height_request(width);
       else
 	return 0;
     }
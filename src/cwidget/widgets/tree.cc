@@ -341,7 +341,7 @@ namespace cwidget
 	return point(0, hierarchical?line_of(selected)-1:line_of(selected));
     }
 
-    void tree::line_down()
+    void tree::line_down(int count)
     {
       if(root == NULL)
 	return;
@@ -355,43 +355,48 @@ namespace cwidget
       treeiterator orig = selected, prevtop = top;
 
       int newline = line_of(selected);
-      int scrollcount = 0;
-      bool moved = false;
 
-      while(selected != end &&
-	    scrollcount < 1 &&
-	    (!moved || !selected->get_selectable()))
+      for(int step = 0; step < count; ++step)
 	{
-	  if(hierarchical)
-	    ++selected;
-	  else
-	    selected.move_forward_level();
-
-	  ++newline;
-	  moved = true;
+	  int scrollcount = 0;
+	  bool moved = false;
 
-	  // If we fell off the end of the screen and not off the end of
-	  // the list, scroll the screen forward.
-	  if(newline > height && selected != end)
+	  while(selected != end &&
+		scrollcount < 1 &&
+		(!moved || !selected->get_selectable()))
 	    {
 	      if(hierarchical)
-		++top;
+		++selected;
 	      else
-		top.move_forward_level();
+		selected.move_forward_level();
 
-	      --newline;
-	      ++scrollcount;
+	      ++newline;
+	      moved = true;
+
+	      // If we fell off the end of the screen and not off the end of
+	      // the list, scroll the screen forward.
+	      if(newline > height && selected != end)
+		{
+		  if(hierarchical)
+		    ++top;
+		  else
+		    top.move_forward_level();
+
+		  --newline;
+		  ++scrollcount;
+		}
 	    }
-	}
 
-      if(selected == end)
-	{
-	  if(hierarchical)
-	    --selected;
-	  else
-	    selected.move_backward_level();
+	  if(selected == end)
+	    {
+	      if(hierarchical)
+		--selected;
+	      else
+		selected.move_backward_level();
 
-	  --newline;
+	      --newline;
+	      break;
+	    }
 	}
 
       if(orig != selected)
@@ -460,7 +465,7 @@ namespace cwidget
       selection_changed(NULL);
     }
 
-    void tree::line_up()
+    void tree::line_up(int count)
     {
       if(root == NULL)
 	return;
@@ -473,9 +478,6 @@ namespace cwidget
 
       treeiterator orig=selected;
 
-      bool moved = false;
-      int scrollcount = 0;
-
       // Guard against the selected entry being unexpectedly invalid (most
       // likely indicates that the tree is empty).
       if(selected == end)
@@ -488,25 +490,31 @@ namespace cwidget
 	    return;
 	}
 
-      while(selected != begin &&
-	    scrollcount < 1 &&
-	    (!moved || !selected->get_selectable()))
+      for(int step = 0; step < count && selected != begin; ++step)
 	{
-	  if(selected == top)
+	  bool moved = false;
+	  int scrollcount = 0;
+
+	  while(selected != begin &&
+		scrollcount < 1 &&
+		(!moved || !selected->get_selectable()))
 	    {
+	      if(selected == top)
+		{
+		  if(hierarchical)
+		    --top;
+		  else
+		    top.move_backward_level();
+
+		  ++scrollcount;
+		}
+
 	      if(hierarchical)
-		--top;
+		--selected;
 	      else
-		top.move_backward_level();
-
-	      ++scrollcount;
+		selected.move_backward_level();
+	      moved = true;
 	    }
-
-	  if(hierarchical)
-	    --selected;
-	  else
-	    selected.move_backward_level();
-	  moved = true;
 	}
 
       // Handle the special case where the first element of the tree is
@@ -537,7 +545,7 @@ namespace cwidget
       toplevel::update();
     }
 
-    void tree::page_down()
+    void tree::page_down(int count)
     {
       if(root == NULL)
 	return;
@@ -548,18 +556,28 @@ namespace cwidget
       if(!hierarchical)
 	--height;
 
-      int count=height;
+      // Only whole pages are scrolled.
       treeiterator newtop=top;
-      while(count>0 && newtop!=end)
+      for(int page=0; page<count; ++page)
 	{
-	  if(hierarchical)
-	    ++newtop;
+	  int lines=height;
+	  treeiterator next=newtop;
+	  while(lines>0 && next!=end)
+	    {
+	      if(hierarchical)
+		++next;
+	      else
+		next.move_forward_level();
+	      lines--;
+	    }
+
+	  if(lines==0 && next!=end)
+	    newtop=next;
 	  else
-	    newtop.move_forward_level();
-	  count--;
+	    break;
 	}
 
-      if(count==0 && newtop!=end)
+      if(newtop!=top)
 	{
 	  int l=0;
 	  (*selected).highlighted_changed(false);
@@ -577,7 +595,7 @@ namespace cwidget
 	}
     }
 
-    void tree::page_up()
+    void tree::page_up(int count)
     {
       if(root == NULL)
 	return;
@@ -588,15 +606,15 @@ namespace cwidget
       if(!hierarchical)
 	--height;
 
-      int count=height;
+      int lines=height*count;
       treeiterator newtop=top;
-      while(count>0 && newtop!=begin)
+      while(lines>0 && newtop!=begin)
 	{
 	  if(hierarchical)
 	    --newtop;
 	  else
 	    newtop.move_backward_level();
-	  count--;
+	  lines--;
 	}
 
       if(newtop!=top)
@@ -744,18 +762,31 @@ namespace cwidget
 
     bool tree::handle_key(const config::key &k)
     {
+      static const config::action_id parent_action = config::get_action_id("Parent");
+      static const config::action_id left_action = config::get_action_id("Left");
+      static const config::action_id right_action = config::get_action_id("Right");
+      static const config::action_id confirm_action = config::get_action_id("Confirm");
+      static const config::action_id down_action = config::get_action_id("Down");
+      static const config::action_id up_action = config::get_action_id("Up");
+      static const config::action_id next_page_action = config::get_action_id("NextPage");
+      static const config::action_id prev_page_action = config::get_action_id("PrevPage");
+      static const config::action_id begin_action = config::get_action_id("Begin");
+      static const config::action_id end_action = config::get_action_id("End");
+      static const config::action_id level_up_action = config::get_action_id("LevelUp");
+      static const config::action_id level_down_action = config::get_action_id("LevelDown");
+
       // umm...
       //width++;
       //height++;
 
       if(selected!=treeiterator(NULL))
 	{
-	  if(root != NULL && hierarchical && bindings->key_matches(k, "Parent"))
+	  if(root != NULL && hierarchical && bindings->key_matches(k, parent_action))
 	    {
 	      if(!selected.is_root())
 		set_selection(selected.get_up());
 	    }
-	  else if(root != NULL && !hierarchical && prev_level && bindings->key_matches(k, "Left"))
+	  else if(root != NULL && !hierarchical && prev_level && bindings->key_matches(k, left_action))
 	    {
 	      selected->highlighted_changed(false);
 
@@ -776,8 +807,8 @@ namespace cwidget
 	  else if(root != NULL && !hierarchical &&
 		  selected!=end && selected->get_selectable() &&
 		  selected->begin()!=selected->end() &&
-		  (bindings->key_matches(k, "Right") ||
-		   bindings->key_matches(k, "Confirm")))
+		  (bindings->key_matches(k, right_action) ||
+		   bindings->key_matches(k, confirm_action)))
 	    {
 	      selected->highlighted_changed(false);
 	      prev_level=new flat_frame(begin, end, top, selected, prev_level);
@@ -792,21 +823,21 @@ namespace cwidget
 
 	      toplevel::update();
 	    }
-	  else if(bindings->key_matches(k, "Down"))
-	    line_down();
-	  else if(bindings->key_matches(k, "Up"))
-	    line_up();
-	  else if(bindings->key_matches(k, "NextPage"))
-	    page_down();
-	  else if(bindings->key_matches(k, "PrevPage"))
-	    page_up();
-	  else if(bindings->key_matches(k, "Begin"))
+	  else if(bindings->key_matches(k, down_action))
+	    line_down(1 + toplevel::take_key_repeats());
+	  else if(bindings->key_matches(k, up_action))
+	    line_up(1 + toplevel::take_key_repeats());
+	  else if(bindings->key_matches(k, next_page_action))
+	    page_down(1 + toplevel::take_key_repeats());
+	  else if(bindings->key_matches(k, prev_page_action))
+	    page_up(1 + toplevel::take_key_repeats());
+	  else if(bindings->key_matches(k, begin_action))
 	    jump_to_begin();
-	  else if(bindings->key_matches(k, "End"))
+	  else if(bindings->key_matches(k, end_action))
 	    jump_to_end();
-	  else if(bindings->key_matches(k, "LevelUp"))
+	  else if(bindings->key_matches(k, level_up_action))
 	    level_line_up();
-	  else if(bindings->key_matches(k, "LevelDown"))
+	  else if(bindings->key_matches(k, level_down_action))
 	    level_line_down();
 	  /*else if(bindings->key_matches(ch, "Search"))
 	    {
@@ -1011,7 +1042,9 @@ namespace cwidget
 	  while(todisp.size()<(unsigned) width)
 	    todisp+=L" ";
 
-	  apply_style(st+get_style("Header"));
+	  static const style_handle header_style("Header");
+
+	  apply_style(st+get_style(header_style));
 	  mvaddnstr(y, 0, todisp.c_str(), width);
 
 	  ++y;
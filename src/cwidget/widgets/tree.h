@@ -204,16 +204,19 @@ namespace cwidget
        */
       sigc::signal1<void, treeitem *> selection_changed;
 
-      // Execute the given command
-      void line_up();
-      void line_down();
-      void page_up();
-      void page_down();
+      // Execute the given command; the movement commands can be
+      // repeated count times, which costs a single update.
+      void line_up(int count = 1);
+      void line_down(int count = 1);
+      void page_up(int count = 1);
+      void page_down(int count = 1);
       void jump_to_begin();
       void jump_to_end();
       void level_line_up();
       void level_line_down();
 
+      config::keybindings *get_bindings() {return bindings;}
+
       static config::keybindings *bindings;
       static void init_bindings();
       // Sets up the bindings..
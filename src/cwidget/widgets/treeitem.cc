@@ -7,12 +7,258 @@
 #include "treeitem.h"
 #include "tree.h"
 
+#include <cwidget/generic/threads/thread_pool.h>
+
+#include <algorithm>
+
 using namespace std;
 
 namespace cwidget
 {
   namespace widgets
   {
+    namespace
+    {
+      typedef vector<treeitem *>::size_type item_index;
+
+      /** Lists with fewer items than this are sorted in the calling
+       *  thread.
+       */
+      const item_index min_parallel_sort = 8192;
+
+      /** The sort key of an item and its place in the unsorted list,
+       *  which breaks ties so that sorting is stable.
+       */
+      struct keyed_item
+      {
+	wstring key;
+	item_index pos;
+
+	bool operator<(const keyed_item &other) const
+	{
+	  const int cmp = key.compare(other.key);
+	  return cmp < 0 || (cmp == 0 && pos < other.pos);
+	}
+      };
+
+      typedef vector<keyed_item>::iterator keyed_iterator;
+
+      /** Sorts one run of keyed items. */
+      class sort_run_job : public threads::thread_pool::job
+      {
+	keyed_iterator begin, end;
+
+      public:
+	sort_run_job(keyed_iterator _begin, keyed_iterator _end)
+	  :begin(_begin), end(_end)
+	{
+	}
+
+	void run()
+	{
+	  std::sort(begin, end);
+	}
+      };
+
+      /** Merges two adjacent sorted runs of keyed items. */
+      class merge_runs_job : public threads::thread_pool::job
+      {
+	keyed_iterator begin, middle, end;
+
+      public:
+	merge_runs_job(keyed_iterator _begin, keyed_iterator _middle,
+		       keyed_iterator _end)
+	  :begin(_begin), middle(_middle), end(_end)
+	{
+	}
+
+	void run()
+	{
+	  std::inplace_merge(begin, middle, end);
+	}
+      };
+
+      /** Sort the items by splitting them into one run per thread,
+       *  sorting the runs at the same time, and then merging pairs
+       *  of runs until one is left.
+       */
+      void parallel_sort(vector<keyed_item> &items,
+			 threads::thread_pool &pool)
+      {
+	const item_index num_runs = pool.get_num_threads() + 1;
+
+	vector<keyed_iterator> bounds;
+	for(item_index i = 0; i < num_runs; ++i)
+	  bounds.push_back(items.begin() + items.size() * i / num_runs);
+	bounds.push_back(items.end());
+
+	{
+	  vector<sort_run_job> jobs;
+	  for(item_index i = 0; i + 1 < bounds.size(); ++i)
+	    jobs.push_back(sort_run_job(bounds[i], bounds[i + 1]));
+
+	  vector<threads::thread_pool::job *> job_ptrs;
+	  for(vector<sort_run_job>::iterator it = jobs.begin();
+	      it != jobs.end(); ++it)
+	    job_ptrs.push_back(&*it);
+
+	  pool.run_all(job_ptrs);
+	}
+
+	while(bounds.size() > 2)
+	  {
+	    vector<merge_runs_job> jobs;
+	    vector<keyed_iterator> merged_bounds;
+
+	    item_index i = 0;
+	    for( ; i + 2 < bounds.size(); i += 2)
+	      {
+		jobs.push_back(merge_runs_job(bounds[i], bounds[i + 1],
+					      bounds[i + 2]));
+		merged_bounds.push_back(bounds[i]);
+	      }
+
+	    // An odd run out waits for the next pass.
+	    for( ; i < bounds.size(); ++i)
+	      merged_bounds.push_back(bounds[i]);
+
+	    vector<threads::thread_pool::job *> job_ptrs;
+	    for(vector<merge_runs_job>::iterator it = jobs.begin();
+		it != jobs.end(); ++it)
+	      job_ptrs.push_back(&*it);
+
+	    pool.run_all(job_ptrs);
+
+	    bounds.swap(merged_bounds);
+	  }
+      }
+
+      /** Sorts the subtree of one item. */
+      class sort_subtree_job : public threads::thread_pool::job
+      {
+	treeitem *item;
+	sortpolicy &sort_method;
+
+      public:
+	sort_subtree_job(treeitem *_item, sortpolicy &_sort_method)
+	  :item(_item), sort_method(_sort_method)
+	{
+	}
+
+	void run()
+	{
+	  item->sort(sort_method);
+	}
+      };
+
+      class policy_lt
+      {
+	const vector<treeitem *> &items;
+	sortpolicy &sort_method;
+
+      public:
+	policy_lt(const vector<treeitem *> &_items, sortpolicy &_sort_method)
+	  :items(_items), sort_method(_sort_method)
+	{
+	}
+
+	bool operator()(item_index a, item_index b) const
+	{
+	  return sort_method(items[a], items[b]);
+	}
+      };
+    }
+
+    threads::thread_pool &sortpolicy::get_thread_pool()
+    {
+      return threads::thread_pool::get_default();
+    }
+
+    parallel_tag_sort_policy::parallel_tag_sort_policy()
+      :pool(threads::thread_pool::get_default())
+    {
+    }
+
+    void sort_order(const vector<treeitem *> &items,
+		    sortpolicy &sort_method,
+		    vector<item_index> &order)
+    {
+      order.clear();
+      order.reserve(items.size());
+
+      vector<keyed_item> keyed(items.size());
+      bool have_keys = true;
+
+      for(item_index i = 0; i < items.size() && have_keys; ++i)
+	{
+	  keyed[i].pos = i;
+	  have_keys = sort_method.get_sort_key(items[i], keyed[i].key);
+	}
+
+      if(!have_keys)
+	{
+	  for(item_index i = 0; i < items.size(); ++i)
+	    order.push_back(i);
+
+	  stable_sort(order.begin(), order.end(),
+		      policy_lt(items, sort_method));
+	  return;
+	}
+
+      if(keyed.size() < min_parallel_sort)
+	std::sort(keyed.begin(), keyed.end());
+      else
+	{
+	  threads::thread_pool &pool = sort_method.get_thread_pool();
+
+	  if(pool.get_num_threads() == 0)
+	    std::sort(keyed.begin(), keyed.end());
+	  else
+	    parallel_sort(keyed, pool);
+	}
+
+      for(vector<keyed_item>::const_iterator it = keyed.begin();
+	  it != keyed.end(); ++it)
+	order.push_back(it->pos);
+    }
+
+    void sort_subtrees(const vector<treeitem *> &items,
+		       sortpolicy &sort_method)
+    {
+      threads::thread_pool *pool = NULL;
+      if(sort_method.is_thread_safe())
+	pool = &sort_method.get_thread_pool();
+
+      // Items without children have little or nothing to sort, so
+      // only subtrees are worth handing to another thread.
+      vector<sort_subtree_job> jobs;
+      if(pool != NULL && pool->get_num_threads() > 0)
+	for(vector<treeitem *>::const_iterator it = items.begin();
+	    it != items.end(); ++it)
+	  if((*it)->has_children())
+	    jobs.push_back(sort_subtree_job(*it, sort_method));
+
+      if(jobs.size() < 2)
+	{
+	  for(vector<treeitem *>::const_iterator it = items.begin();
+	      it != items.end(); ++it)
+	    (*it)->sort(sort_method);
+	  return;
+	}
+
+      vector<threads::thread_pool::job *> job_ptrs;
+      for(vector<sort_subtree_job>::iterator it = jobs.begin();
+	  it != jobs.end(); ++it)
+	job_ptrs.push_back(&*it);
+
+      pool->run_all(job_ptrs);
+
+      for(vector<treeitem *>::const_iterator it = items.begin();
+	  it != items.end(); ++it)
+	if(!(*it)->has_children())
+	  (*it)->sort(sort_method);
+    }
+
     void treeitem::paint(tree *win, int y, bool hierarchical,
 			 const wstring &str, int depth_shift)
     {
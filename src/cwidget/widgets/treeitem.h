@@ -29,6 +29,10 @@
 
 #include <stdlib.h>
 
+#include <string>
+#include <typeinfo>
+#include <vector>
+
 #include <cwidget/curses++.h>
 #include <cwidget/style.h>
 
@@ -36,6 +40,11 @@
 
 namespace cwidget
 {
+  namespace threads
+  {
+    class thread_pool;
+  }
+
   namespace widgets
   {
     class tree;
@@ -157,6 +166,15 @@ namespace cwidget
       // Sorts an item's subtree (NOP for most items) -- provided to make it easy
       // to recursively sort the list.
 
+      /** Sort this item's subtree using the given method, but put off
+       *  sorting each level until its children are first traversed.
+       *  The default is to sort immediately.
+       *
+       *  The policy must remain valid until every level has been
+       *  traversed, or until the subtree is sorted again.
+       */
+      virtual void sort_lazily(sortpolicy &sort_method) {sort(sort_method);}
+
       /** \brief A signal emitted when the tree-item is highlighted
        *  or unhighlighted.
        *
@@ -377,6 +395,35 @@ namespace cwidget
       virtual bool operator()(treeitem *item1,
 			      treeitem *item2)=0;
 
+      /** Compute a key that orders items the same way as this policy:
+       *  item1 belongs before item2 exactly when key1<key2.  Each key
+       *  is computed once per sort, instead of calling operator() for
+       *  every comparison; a policy that collates with wcscoll() can
+       *  return the result of wcsxfrm() here.
+       *
+       *  \return \b false (the default) if this policy has no keys,
+       *  in which case operator() is used.
+       */
+      virtual bool get_sort_key(treeitem *item, std::wstring &key)
+      {
+	return false;
+      }
+
+      /** \return \b true if operator() and get_sort_key() may be
+       *  called from several threads at once, on different items.  If
+       *  so, separate subtrees are sorted in parallel.  The default is
+       *  \b false.
+       */
+      virtual bool is_thread_safe()
+      {
+	return false;
+      }
+
+      /** \return the pool on which items are sorted in parallel.  The
+       *  default is threads::thread_pool::get_default().
+       */
+      virtual threads::thread_pool &get_thread_pool();
+
       virtual ~sortpolicy() {}
     };
 
@@ -389,6 +436,45 @@ namespace cwidget
       {
 	return (wcscmp(item1->tag(), item2->tag())<0);
       }
+
+      // Subclasses that only override operator() must not be sorted by
+      // tag, so the keys are only provided by this class itself.
+      bool get_sort_key(treeitem *item, std::wstring &key)
+      {
+	if(typeid(*this)!=typeid(tag_sort_policy))
+	  return false;
+
+	key=item->tag();
+	return true;
+      }
+    };
+
+    /** Sorts by tag like tag_sort_policy, but sorts separate subtrees
+     *  at the same time on a thread pool.  tag() is called from
+     *  several threads at once, and so is the sort() of each subtree,
+     *  so only use this when those are thread-safe.
+     */
+    class parallel_tag_sort_policy:public tag_sort_policy
+    {
+      threads::thread_pool &pool;
+    public:
+      /** Sort on threads::thread_pool::get_default(). */
+      parallel_tag_sort_policy();
+
+      explicit parallel_tag_sort_policy(threads::thread_pool &_pool)
+	:pool(_pool)
+      {
+      }
+
+      bool get_sort_key(treeitem *item, std::wstring &key)
+      {
+	key=item->tag();
+	return true;
+      }
+
+      bool is_thread_safe() {return true;}
+
+      threads::thread_pool &get_thread_pool() {return pool;}
     };
 
     // Hack? hmm..
@@ -410,6 +496,33 @@ namespace cwidget
 	return real_policy(item1, item2);
       }
     };
+
+    /** Find the order in which a list of items belongs.  The sort is
+     *  stable.
+     *
+     *  If the policy provides sort keys, long lists are sorted on the
+     *  policy's thread pool.  Only the keys are touched by other
+     *  threads; the items and the policy are only used in the calling
+     *  thread.
+     *
+     *  \param items the items to sort.
+     *  \param sort_method how to order the items.
+     *  \param order set to the indices of the items, in sorted order.
+     */
+    void sort_order(const std::vector<treeitem *> &items,
+		    sortpolicy &sort_method,
+		    std::vector<std::vector<treeitem *>::size_type> &order);
+
+    /** Sort the subtree of each item.  If the policy is thread-safe,
+     *  the items that have children are sorted at the same time on
+     *  the policy's thread pool; otherwise they are sorted one after
+     *  another in the calling thread.
+     *
+     *  \param items the items whose subtrees should be sorted.
+     *  \param sort_method how to order the children of each item.
+     */
+    void sort_subtrees(const std::vector<treeitem *> &items,
+		       sortpolicy &sort_method);
   }
 }
 
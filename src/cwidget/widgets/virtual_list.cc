@@ -0,0 +1,454 @@
+// virtual_list.cc
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include "virtual_list.h"
+
+#include <cwidget/config/keybindings.h>
+#include <cwidget/toplevel.h>
+
+#include <algorithm>
+
+#include <wchar.h>
+
+using namespace std;
+
+namespace cwidget
+{
+  namespace widgets
+  {
+    config::keybindings *virtual_list::bindings = NULL;
+
+    const virtual_list::size_type virtual_list::npos;
+
+    style list_provider::get_row_style(size_type row)
+    {
+      return style();
+    }
+
+    list_provider::~list_provider()
+    {
+    }
+
+    namespace
+    {
+      /** Adapts an order_slot for std::stable_sort. */
+      class order_lt
+      {
+	const virtual_list::order_slot &order;
+
+      public:
+	order_lt(const virtual_list::order_slot &_order)
+	  :order(_order)
+	{
+	}
+
+	bool operator()(virtual_list::size_type a,
+			virtual_list::size_type b) const
+	{
+	  return order(a, b);
+	}
+      };
+    }
+
+    virtual_list::virtual_list(list_provider *_provider)
+      :provider(_provider), num_rows(0), top(0), selected(npos)
+    {
+      if(provider != NULL)
+	num_rows = provider->get_size();
+
+      if(num_rows > 0)
+	selected = 0;
+    }
+
+    void virtual_list::rebuild_index()
+    {
+      index.clear();
+
+      if(!has_index())
+	return;
+
+      if(filter.empty())
+	{
+	  index.reserve(num_rows);
+	  for(size_type row = 0; row < num_rows; ++row)
+	    index.push_back(row);
+	}
+      else
+	for(size_type row = 0; row < num_rows; ++row)
+	  if(filter(row))
+	    index.push_back(row);
+
+      if(!order.empty())
+	stable_sort(index.begin(), index.end(), order_lt(order));
+    }
+
+    virtual_list::size_type virtual_list::get_view_size() const
+    {
+      return has_index() ? index.size() : num_rows;
+    }
+
+    void virtual_list::do_select(size_type pos)
+    {
+      const size_type old_row = get_selection();
+
+      selected = pos;
+      scroll_to_selection();
+
+      const size_type new_row = get_selection();
+      if(new_row != old_row)
+	selection_changed(new_row);
+    }
+
+    void virtual_list::scroll_to_selection()
+    {
+      if(selected == npos)
+	{
+	  top = 0;
+	  return;
+	}
+
+      const size_type height = max(getmaxy(), 1);
+
+      if(selected < top)
+	top = selected;
+      else if(selected >= top + height)
+	top = selected - height + 1;
+    }
+
+    void virtual_list::reload()
+    {
+      refresh(get_selection());
+    }
+
+    void virtual_list::refresh(size_type old_row)
+    {
+      widget_ref tmpref(this);
+
+      const size_type old_pos = selected;
+
+      num_rows = (provider == NULL) ? 0 : provider->get_size();
+      rebuild_index();
+
+      const size_type size = get_view_size();
+      size_type pos = npos;
+
+      // Keep the selected row if it is still shown; otherwise stay at
+      // the same position.
+      if(old_row != npos && old_row < num_rows)
+	{
+	  if(!has_index())
+	    pos = old_row;
+	  else
+	    {
+	      vector<size_type>::const_iterator found =
+		find(index.begin(), index.end(), old_row);
+	      if(found != index.end())
+		pos = found - index.begin();
+	    }
+	}
+
+      if(pos == npos && size > 0)
+	pos = (old_pos == npos) ? 0 : min(old_pos, size - 1);
+
+      // Report the change even if the same row index is selected,
+      // since it might now hold something else.
+      selected = pos;
+      scroll_to_selection();
+      selection_changed(get_selection());
+
+      toplevel::update();
+    }
+
+    void virtual_list::set_provider(list_provider *_provider)
+    {
+      widget_ref tmpref(this);
+
+      provider = _provider;
+      selected = npos;
+      top = 0;
+
+      refresh(npos);
+    }
+
+    void virtual_list::set_order(const order_slot &_order)
+    {
+      const size_type old_row = get_selection();
+
+      order = _order;
+      refresh(old_row);
+    }
+
+    void virtual_list::clear_order()
+    {
+      const size_type old_row = get_selection();
+
+      order = order_slot();
+      refresh(old_row);
+    }
+
+    void virtual_list::set_filter(const filter_slot &_filter)
+    {
+      const size_type old_row = get_selection();
+
+      filter = _filter;
+      refresh(old_row);
+    }
+
+    void virtual_list::clear_filter()
+    {
+      const size_type old_row = get_selection();
+
+      filter = filter_slot();
+      refresh(old_row);
+    }
+
+    bool virtual_list::select_row(size_type row)
+    {
+      widget_ref tmpref(this);
+
+      if(row >= num_rows)
+	return false;
+
+      size_type pos = row;
+      if(has_index())
+	{
+	  vector<size_type>::const_iterator found =
+	    find(index.begin(), index.end(), row);
+	  if(found == index.end())
+	    return false;
+
+	  pos = found - index.begin();
+	}
+
+      do_select(pos);
+      toplevel::update();
+      return true;
+    }
+
+    void virtual_list::select_position(size_type pos)
+    {
+      widget_ref tmpref(this);
+
+      const size_type size = get_view_size();
+      if(size == 0)
+	return;
+
+      do_select(min(pos, size - 1));
+      toplevel::update();
+    }
+
+    void virtual_list::line_up(int count)
+    {
+      if(selected == npos)
+	return;
+
+      select_position(selected > size_type(count) ? selected - count : 0);
+    }
+
+    void virtual_list::line_down(int count)
+    {
+      if(selected == npos)
+	return;
+
+      select_position(selected + count);
+    }
+
+    void virtual_list::page_up(int count)
+    {
+      if(selected == npos)
+	return;
+
+      const size_type amount = size_type(max(getmaxy(), 1)) * count;
+
+      if(top > amount)
+	top -= amount;
+      else
+	top = 0;
+
+      select_position(selected > amount ? selected - amount : 0);
+    }
+
+    void virtual_list::page_down(int count)
+    {
+      if(selected == npos)
+	return;
+
+      const size_type height = max(getmaxy(), 1);
+      const size_type amount = height * count;
+      const size_type size = get_view_size();
+
+      // Keep the selection on the same line of the screen, unless
+      // that would scroll past the end of the list.
+      if(top + amount + height <= size)
+	top += amount;
+      else if(size > height)
+	top = size - height;
+
+      select_position(selected + amount);
+    }
+
+    void virtual_list::jump_to_begin()
+    {
+      select_position(0);
+    }
+
+    void virtual_list::jump_to_end()
+    {
+      select_position(npos);
+    }
+
+    int virtual_list::width_request()
+    {
+      return 1;
+    }
+
+    int virtual_list::height_request(int w)
+    {
+      return 1;
+    }
+
+    bool virtual_list::get_cursorvisible()
+    {
+      return selected != npos;
+    }
+
+    point virtual_list::get_cursorloc()
+    {
+      if(selected == npos || selected < top)
+	return point(0, 0);
+      else
+	return point(0, selected - top);
+    }
+
+    bool virtual_list::handle_key(const config::key &k)
+    {
+      static const config::action_id confirm_action = config::get_action_id("Confirm");
+      static const config::action_id down_action = config::get_action_id("Down");
+      static const config::action_id up_action = config::get_action_id("Up");
+      static const config::action_id next_page_action = config::get_action_id("NextPage");
+      static const config::action_id prev_page_action = config::get_action_id("PrevPage");
+      static const config::action_id begin_action = config::get_action_id("Begin");
+      static const config::action_id end_action = config::get_action_id("End");
+
+      widget_ref tmpref(this);
+
+      if(bindings->key_matches(k, down_action))
+	line_down(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, up_action))
+	line_up(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, next_page_action))
+	page_down(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, prev_page_action))
+	page_up(1 + toplevel::take_key_repeats());
+      else if(bindings->key_matches(k, begin_action))
+	jump_to_begin();
+      else if(bindings->key_matches(k, end_action))
+	jump_to_end();
+      else if(selected != npos && bindings->key_matches(k, confirm_action))
+	activated(get_selection());
+      else
+	return widget::handle_key(k);
+
+      return true;
+    }
+
+    void virtual_list::paint(const style &st)
+    {
+      if(provider == NULL)
+	return;
+
+      int width, height;
+      getmaxyx(height, width);
+
+      // The window might have shrunk since the selection last moved.
+      scroll_to_selection();
+
+      const size_type size = get_view_size();
+
+      for(int y = 0; y < height && top + y < size; ++y)
+	{
+	  const size_type pos = top + y;
+	  const size_type row = get_row(pos);
+
+	  style row_st = st + provider->get_row_style(row);
+	  if(pos == selected && get_isfocussed())
+	    row_st += style_attrs_flip(A_REVERSE);
+
+	  apply_style(row_st);
+
+	  const wstring text = provider->get_text(row);
+
+	  move(y, 0);
+	  int x = 0;
+	  for(wstring::const_iterator i = text.begin();
+	      i != text.end() && x < width; ++i)
+	    {
+	      const int w = wcwidth(*i);
+	      if(w < 0)
+		continue;
+	      if(x + w > width)
+		break;
+
+	      add_wch(*i);
+	      x += w;
+	    }
+
+	  while(x < width)
+	    {
+	      add_wch(L' ');
+	      ++x;
+	    }
+	}
+    }
+
+    void virtual_list::dispatch_mouse(short id, int x, int y, int z, mmask_t bstate)
+    {
+      widget_ref tmpref(this);
+
+#if defined(BUTTON4_PRESSED) && defined(BUTTON5_PRESSED)
+      const int mouse_wheel_scroll_lines =
+	std::max(1, std::min(getmaxy() - 1, 3));
+
+      if((bstate & BUTTON4_PRESSED) != 0)
+	{
+	  if((bstate & BUTTON5_PRESSED) == 0)
+	    line_up(mouse_wheel_scroll_lines);
+
+	  return;
+	}
+      else if((bstate & BUTTON5_PRESSED) != 0)
+	{
+	  line_down(mouse_wheel_scroll_lines);
+	  return;
+	}
+#endif
+
+      if(y < 0 || top + y >= get_view_size())
+	return;
+
+      select_position(top + y);
+
+      if((bstate & BUTTON1_DOUBLE_CLICKED) != 0)
+	activated(get_selection());
+    }
+
+    void virtual_list::init_bindings()
+    {
+      bindings = new config::keybindings(&config::global_bindings);
+    }
+  }
+}
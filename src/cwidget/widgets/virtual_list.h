@@ -0,0 +1,255 @@
+// virtual_list.h                                         -*-c++-*-
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+//
+// A list whose rows are fetched on demand from a data provider.
+
+#ifndef VIRTUAL_LIST_H
+#define VIRTUAL_LIST_H
+
+#include "widget.h"
+
+#include <cwidget/style.h>
+
+#include <sigc++/functors/slot.h>
+#include <sigc++/signal.h>
+
+#include <string>
+#include <vector>
+
+namespace cwidget
+{
+  namespace config
+  {
+    class keybindings;
+  }
+
+  namespace widgets
+  {
+    /** \brief Supplies the rows displayed by a virtual_list.
+     *
+     *  Rows are identified by their index, from 0 to get_size()-1.  A
+     *  list only asks for the rows that are on the screen, so the
+     *  provider is free to compute them as they are needed.
+     *
+     *  The list never deletes its provider; the provider must remain
+     *  valid for as long as it is attached to the list.
+     */
+    class list_provider
+    {
+    public:
+      typedef std::vector<int>::size_type size_type;
+
+      /** \return the number of rows. */
+      virtual size_type get_size() = 0;
+
+      /** \return the text of the given row. */
+      virtual std::wstring get_text(size_type row) = 0;
+
+      /** \return the style of the given row, which is combined with
+       *  the style of the list.  The default is an empty style.
+       */
+      virtual style get_row_style(size_type row);
+
+      virtual ~list_provider();
+    };
+
+    /** \brief A scrolling list of rows that only exist on demand.
+     *
+     *  Unlike a tree, a virtual_list keeps no object for each row: it
+     *  asks its list_provider for the rows on the screen each time it
+     *  is painted.  The only per-row memory is the index used when
+     *  the rows are sorted or filtered, so a list can show millions
+     *  of rows.
+     *
+     *  Rows are referred to in two ways: by their index in the
+     *  provider (a \e row), and by where they appear in the list (a
+     *  \e position).  Without an order or filter, the two are the
+     *  same.
+     *
+     *  Call reload() when the rows of the provider change.
+     */
+    class virtual_list : public widget
+    {
+    public:
+      typedef list_provider::size_type size_type;
+
+      /** Returned when there is no row or position. */
+      static const size_type npos = static_cast<size_type>(-1);
+
+      /** Decides whether the first row belongs before the second. */
+      typedef sigc::slot2<bool, size_type, size_type> order_slot;
+
+      /** Decides whether a row is shown. */
+      typedef sigc::slot1<bool, size_type> filter_slot;
+
+    private:
+      list_provider *provider;
+
+      /** The number of rows in the provider. */
+      size_type num_rows;
+
+      order_slot order;
+      filter_slot filter;
+
+      /** The row at each position, if there is an order or a filter;
+       *  otherwise empty, and each row is at its own position.
+       */
+      std::vector<size_type> index;
+
+      /** The first visible position. */
+      size_type top;
+
+      /** The selected position, or npos if the list is empty. */
+      size_type selected;
+
+      /** Fill in index from the current order and filter. */
+      void rebuild_index();
+
+      /** Fetch the rows again, keeping the given row selected if it
+       *  is still shown.
+       */
+      void refresh(size_type old_row);
+
+      /** Select the given position (which must be valid, or npos if
+       *  the list is empty), emitting selection_changed if the
+       *  selected row changed.
+       */
+      void do_select(size_type pos);
+
+      /** Move top so that the selection is on the screen. */
+      void scroll_to_selection();
+
+    protected:
+      virtual bool handle_key(const config::key &k);
+
+      explicit virtual_list(list_provider *_provider);
+
+    public:
+      /** Create a list.
+       *
+       *  \param provider the source of the rows, or \b NULL for an
+       *  empty list.
+       */
+      static util::ref_ptr<virtual_list>
+      create(list_provider *provider = NULL)
+      {
+	util::ref_ptr<virtual_list> rval(new virtual_list(provider));
+	rval->decref();
+	return rval;
+      }
+
+      /** Show the rows of a different provider.  The order and filter
+       *  are kept, and the first row is selected.
+       */
+      void set_provider(list_provider *provider);
+
+      list_provider *get_provider() const {return provider;}
+
+      /** Fetch the number of rows from the provider again and reapply
+       *  the order and filter.  The selected row stays selected if it
+       *  is still shown.
+       */
+      void reload();
+
+      /** Sort the shown rows.  The sort is stable, so rows that the
+       *  slot considers equal stay in the provider's order.
+       */
+      void set_order(const order_slot &order);
+
+      /** Show the rows in the provider's order again. */
+      void clear_order();
+
+      /** Only show the rows for which the slot returns \b true. */
+      void set_filter(const filter_slot &filter);
+
+      /** Show every row again. */
+      void clear_filter();
+
+      /** \return the number of rows that are shown. */
+      size_type get_view_size() const;
+
+      /** \return the row shown at the given position, which must be
+       *  less than get_view_size().
+       */
+      size_type get_row(size_type pos) const
+      {
+	return has_index() ? index[pos] : pos;
+      }
+
+      /** \return \b true if rows are sorted or filtered. */
+      bool has_index() const
+      {
+	return !order.empty() || !filter.empty();
+      }
+
+      /** \return the selected row, or npos if the list is empty. */
+      size_type get_selection() const
+      {
+	return selected == npos ? npos : get_row(selected);
+      }
+
+      /** \return the selected position, or npos if the list is empty. */
+      size_type get_selected_position() const {return selected;}
+
+      /** Select the given row, if it is shown.
+       *
+       *  \return \b true if the row was selected.
+       */
+      bool select_row(size_type row);
+
+      /** Select the row at the given position, which is clamped to
+       *  the end of the list.
+       */
+      void select_position(size_type pos);
+
+      // Move the selection; each command can be repeated count times,
+      // which costs a single update.
+      void line_up(int count = 1);
+      void line_down(int count = 1);
+      void page_up(int count = 1);
+      void page_down(int count = 1);
+      void jump_to_begin();
+      void jump_to_end();
+
+      int width_request();
+      int height_request(int w);
+
+      bool get_cursorvisible();
+      point get_cursorloc();
+      bool focus_me() {return true;}
+      void paint(const style &st);
+      void dispatch_mouse(short id, int x, int y, int z, mmask_t bstate);
+
+      /** Emitted with the newly selected row, or npos if nothing is
+       *  selected.
+       */
+      sigc::signal1<void, size_type> selection_changed;
+
+      /** Emitted with the selected row when the user confirms it. */
+      sigc::signal1<void, size_type> activated;
+
+      config::keybindings *get_bindings() {return bindings;}
+
+      static config::keybindings *bindings;
+      static void init_bindings();
+    };
+
+    typedef util::ref_ptr<virtual_list> virtual_list_ref;
+  }
+}
+
+#endif // VIRTUAL_LIST_H
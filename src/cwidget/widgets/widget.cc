@@ -38,8 +38,13 @@ namespace cwidget
 	visible(false),
 	isfocussed(false),
 	pre_display_erase(true),
-	is_destroyed(false)
+	is_destroyed(false),
+	display_style_stale(true),
+	layout_stale(true),
+	laid_out_generation(layout_generation)
     {
+      clear_size_cache();
+
       focussed.connect(sigc::bind(sigc::mem_fun(*this, &widget::set_isfocussed), true));
       unfocussed.connect(sigc::bind(sigc::mem_fun(*this, &widget::set_isfocussed), false));
     }
@@ -52,13 +57,24 @@ namespace cwidget
 
     void widget::set_bg_style(const style &new_style)
     {
-      bg_style=new_style;
+      bg_style=interned_style(new_style);
+      display_style_stale=true;
     }
 
     void widget::apply_style(const style &st)
     {
-      bkgdset(st.get_attrs());
-      attrset(st.get_attrs());
+      const attr_t attrs = st.get_attrs();
+
+      bkgdset(attrs);
+      attrset(attrs);
+    }
+
+    void widget::apply_style(const interned_style &st)
+    {
+      const attr_t attrs = st.get_attrs();
+
+      bkgdset(attrs);
+      attrset(attrs);
     }
 
     void widget::set_isfocussed(bool _isfocussed)
@@ -70,6 +86,16 @@ namespace cwidget
     {
       widget_ref tmpref(this);
 
+      // If nothing changed, keep the existing window and layout.
+      if(_win && win && !layout_stale &&
+	 laid_out_generation == layout_generation &&
+	 geom.x == x && geom.y == y && geom.w == w && geom.h == h &&
+	 win.is_derived_from(_win))
+	return;
+
+      layout_stale = false;
+      laid_out_generation = layout_generation;
+
       if(_win)
 	{
 	  geom.x=x;
@@ -83,11 +109,29 @@ namespace cwidget
 	    {
 	      eassert(!is_destroyed);
 
-	      win=_win.derwin(geom.h,
-			      geom.w,
-			      geom.y,
-			      geom.x);
-	      win.keypad(true);
+	      // Reuse the current window if possible.
+	      bool reused = false;
+	      if(win && win.is_derived_from(_win))
+		{
+		  int oldy, oldx;
+		  win.getparyx(oldy, oldx);
+
+		  // curses fixes up subwindows when their parent is
+		  // resized, but not when it is moved, so a container's
+		  // window can only be resized in place.
+		  const bool moved = (oldy != geom.y || oldx != geom.x);
+		  if(!moved || dynamic_cast<container *>(this) == NULL)
+		    reused = (win.move_derived(geom.h, geom.w, geom.y, geom.x) != ERR);
+		}
+
+	      if(!reused)
+		{
+		  win=_win.derwin(geom.h,
+				  geom.w,
+				  geom.y,
+				  geom.x);
+		  win.keypad(true);
+		}
 	    }
 	}
       else
@@ -105,6 +149,77 @@ namespace cwidget
 	set_owner_window(NULL, x, y, w, h);
     }
 
+    unsigned int widget::size_generation = 0;
+
+    void widget::clear_size_cache()
+    {
+      cached_width = -1;
+      for(int i = 0; i < height_cache_size; ++i)
+	cached_heights[i].width = -1;
+      next_cached_height = 0;
+      cached_size_generation = size_generation;
+    }
+
+    int widget::get_width_request()
+    {
+      if(cached_size_generation != size_generation)
+	clear_size_cache();
+
+      if(cached_width == -1)
+	cached_width = width_request();
+
+      return cached_width;
+    }
+
+    int widget::get_height_request(int width)
+    {
+      if(cached_size_generation != size_generation)
+	clear_size_cache();
+
+      for(int i = 0; i < height_cache_size; ++i)
+	if(cached_heights[i].width == width)
+	  return cached_heights[i].height;
+
+      const int height = height_request(width);
+
+      height_request_entry &entry = cached_heights[next_cached_height];
+      entry.width = width;
+      entry.height = height;
+      next_cached_height = (next_cached_height + 1) % height_cache_size;
+
+      return height;
+    }
+
+    void widget::size_changed()
+    {
+      for(widget *w = this; w != NULL; w = w->owner)
+	w->clear_size_cache();
+
+      queue_layout();
+    }
+
+    void widget::queue_layout()
+    {
+      // Don't stop at an ancestor that is already stale: a hidden
+      // widget can stay stale after its owner is laid out.
+      for(widget *w = this; w != NULL; w = w->owner)
+	w->layout_stale = true;
+
+      toplevel::queue_relayout();
+    }
+
+    void widget::discard_size_requests()
+    {
+      ++size_generation;
+    }
+
+    unsigned int widget::layout_generation = 0;
+
+    void widget::discard_layouts()
+    {
+      ++layout_generation;
+    }
+
     void widget::set_owner(container *_owner)
     {
       owner=_owner;
@@ -204,8 +319,16 @@ namespace cwidget
 
       // Erase our window, using the composition of the surrounding style
       // and our background style.
-      style basic_st=st+bg_style;
-      int bgattr=basic_st.get_attrs();
+      if(display_style_stale || st != last_display_style)
+	{
+	  last_display_style=st;
+	  last_basic_style=interned_style(st)+bg_style;
+	  display_style_stale=false;
+	}
+
+      // Copied because painting can intern more styles.
+      const style basic_st=last_basic_style.get_style();
+      int bgattr=last_basic_style.get_attrs();
 
       if(pre_display_erase)
 	{
@@ -215,6 +338,29 @@ namespace cwidget
 
       attrset(bgattr);
       paint(basic_st);
+
+      // Changes made through a subwindow are only recorded in the
+      // subwindow; mark them in its ancestors too, so that refreshing
+      // the toplevel window picks them up without touching all of it.
+      //
+      // The toplevel window is itself a subwindow of rootwin, so
+      // syncup() marks rootwin too.  Nothing is refreshed through
+      // rootwin, but reading a key refreshes it if it is touched,
+      // which would send an extra update and move the cursor to
+      // rootwin's cursor; stop the changes at the toplevel window.
+      if(win)
+	{
+	  win.syncup();
+	  rootwin.untouch();
+	}
+    }
+
+    rect widget::get_opaque_region()
+    {
+      if(win && pre_display_erase)
+	return rect(0, 0, geom.w, geom.h);
+      else
+	return rect(0, 0, 0, 0);
     }
 
     bool widget::focus_me()
@@ -237,7 +383,7 @@ namespace cwidget
       for(key_connection i=auxillary_post_bindings.begin();
 	  i!=auxillary_post_bindings.end();
 	  i++)
-	if(i->bindings->key_matches(k, i->keyname))
+	if(i->bindings->key_matches(k, i->action))
 	  {
 	    i->slot();
 	    rval=true;
@@ -258,7 +404,7 @@ namespace cwidget
       for(key_connection i=auxillary_bindings.begin();
 	  i!=auxillary_bindings.end();
 	  i++)
-	if(i->bindings->key_matches(k, i->keyname))
+	if(i->bindings->key_matches(k, i->action))
 	  {
 	    i->slot();
 	    rval=true;
@@ -267,6 +413,21 @@ namespace cwidget
       return rval || handle_key(k);
     }
 
+    bool widget::handle_paste(const wstring &text)
+    {
+      return false;
+    }
+
+    bool widget::dispatch_paste(const wstring &text)
+    {
+      widget_ref tmpref(this);
+
+      if(is_destroyed)
+	return false;
+
+      return handle_paste(text);
+    }
+
     void widget::dispatch_mouse(short id, int x, int y, int z,
 				mmask_t bmask)
     {
@@ -296,6 +457,21 @@ namespace cwidget
       return rval;
     }
 
+    void widget::get_binding_scopes(vector<const config::keybindings *> &scopes)
+    {
+      config::keybindings *own = get_bindings();
+      if(own != NULL)
+	scopes.push_back(own);
+
+      for(key_connection i=auxillary_bindings.begin();
+	  i!=auxillary_bindings.end(); ++i)
+	scopes.push_back(i->bindings);
+
+      for(key_connection i=auxillary_post_bindings.begin();
+	  i!=auxillary_post_bindings.end(); ++i)
+	scopes.push_back(i->bindings);
+    }
+
     void widget::disconnect_key(key_connection key)
     {
       auxillary_bindings.erase(key);
@@ -40,6 +40,7 @@
 #define WIDGET_H
 
 #include <list>
+#include <vector>
 
 #include <sigc++/signal.h>
 #include <sigc++/trackable.h>
@@ -73,6 +74,8 @@ namespace cwidget
   {
     class key;
     class keybindings;
+    typedef int action_id;
+    action_id get_action_id(const std::string &tag);
   }
 
   namespace widgets
@@ -122,13 +125,17 @@ namespace cwidget
       {
 	std::string keyname;
 
+	/** The ID of keyname, looked up when the binding is made. */
+	config::action_id action;
+
 	config::keybindings *bindings;
 
 	sigc::slot0<void> slot;
 
-	binding_connection():bindings(NULL) {}
+	binding_connection():action(-1), bindings(NULL) {}
 	binding_connection(const std::string &_keyname, config::keybindings *_bindings, const sigc::slot0<void> &_slot)
-	  :keyname(_keyname), bindings(_bindings), slot(_slot) {}
+	  :keyname(_keyname), action(config::get_action_id(_keyname)),
+	   bindings(_bindings), slot(_slot) {}
       };
 
       // Bindings set via connect_key() and connect_key_post()
@@ -145,7 +152,15 @@ namespace cwidget
       rect geom;
 
       /** The basic style attached to this widget. */
-      style bg_style;
+      interned_style bg_style;
+
+      /** The style that was passed to the last call to display(), and
+       *  its composition with bg_style.  Widgets are normally redrawn
+       *  in the same surrounding style over and over, so this saves
+       *  composing the styles on every repaint.
+       */
+      style last_display_style;
+      interned_style last_basic_style;
 
       /** The number of live references to this object.  This is initially
        *  1, so that it's safe to take references in the constructor.  It
@@ -168,10 +183,56 @@ namespace cwidget
 
       bool is_destroyed:1;
 
-      // Used to set the owner-window without setting the owner.  Used only
-      // to handle the toplevel widget (which has a window but no owner)
-      // Like alloc_size
-      void set_owner_window(cwindow _win, int x, int y, int w, int h);
+      /** If \b true, last_basic_style is out of date. */
+      bool display_style_stale:1;
+
+      /** If \b true, queue_layout() was called on this widget or one
+       *  of its descendants since it was last laid out.
+       */
+      bool layout_stale:1;
+
+      /** A height_request() result remembered by get_height_request(). */
+      struct height_request_entry
+      {
+	int width;
+	int height;
+      };
+
+      /** How many heights are remembered for each widget.  A single
+       *  entry would be thrashed by containers that try out several
+       *  widths for a child before settling on one.
+       */
+      static const int height_cache_size = 4;
+
+      /** The cached result of width_request(), or -1. */
+      int cached_width;
+
+      /** Cached results of height_request(); unused entries have a
+       *  width of -1.
+       */
+      height_request_entry cached_heights[height_cache_size];
+
+      /** The entry of cached_heights that will be replaced next. */
+      int next_cached_height;
+
+      /** The value of size_generation when the cache was filled in;
+       *  the cached requests are ignored if it has changed since.
+       */
+      unsigned int cached_size_generation;
+
+      /** Bumped by discard_size_requests(). */
+      static unsigned int size_generation;
+
+      /** The value of layout_generation when this widget was last
+       *  laid out.
+       */
+      unsigned int laid_out_generation;
+
+      /** Bumped by discard_layouts(). */
+      static unsigned int layout_generation;
+
+      /** Forget the cached requests of this widget only. */
+      void clear_size_cache();
 
       // Used to update the "focussed" state
       void set_isfocussed(bool _isfocussed);
@@ -194,6 +255,16 @@ namespace cwidget
        */
       virtual bool handle_key(const config::key &k);
 
+      /** Handles text that was pasted into this widget in one piece.
+       *
+       *  \param text the pasted text.
+       *
+       *  \return \b true if the text was consumed; if \b false is
+       *  returned, it is delivered one keystroke at a time instead.
+       *  The default implementation returns \b false.
+       */
+      virtual bool handle_paste(const std::wstring &text);
+
       /** Handle cleanup when the reference count goes to 0. */
       void cleanup();
     protected:
@@ -248,6 +319,10 @@ namespace cwidget
       // keypress sent to it.
       bool dispatch_key(const config::key & k);
 
+      // This should be called when text is pasted into an arbitrary
+      // widget.
+      bool dispatch_paste(const std::wstring &text);
+
       // This should be called when an arbitrary widget is to have a mouse event
       // sent to it.  Override it to change mousing behavior.
       virtual void dispatch_mouse(short id, int x, int y, int z, mmask_t bstate);
@@ -265,6 +340,11 @@ namespace cwidget
       //
       // You can assume that the widget's state is unchanged between a
       // call to width_request() and a call to height_request().
+      //
+      // The results of width_request() and height_request() are
+      // cached; containers should ask for the size of their children
+      // with get_width_request() and get_height_request(), and a
+      // widget whose desired size changes must call size_changed().
 
       /** \return the desired width of the widget. */
       virtual int width_request()=0;
@@ -276,6 +356,48 @@ namespace cwidget
        */
       virtual int height_request(int width)=0;
 
+      /** \return the desired width of the widget, calling
+       *  width_request() only if it hasn't been called since the
+       *  widget's size last changed.
+       */
+      int get_width_request();
+
+      /** \return the desired height of the widget at the given
+       *  width, calling height_request() only if it hasn't been
+       *  called with that width since the widget's size last changed.
+       */
+      int get_height_request(int width);
+
+      /** Announce that the desired size of this widget might have
+       *  changed.  This discards the cached size requests of the
+       *  widget and all of its ancestors (whose size depends on it),
+       *  and queues a layout of the widget in which only those
+       *  widgets are measured again.
+       */
+      void size_changed();
+
+      /** Queue a layout of this widget, without changing its desired
+       *  size; for instance, because it wants to arrange its children
+       *  differently.
+       *
+       *  The widget and its ancestors are laid out again, but the
+       *  other widgets are left alone unless their allocation
+       *  changes: their windows are kept and they don't receive
+       *  do_layout.
+       */
+      void queue_layout();
+
+      /** Discard the cached size requests of every widget.  Called
+       *  by toplevel::queuelayout(), since the caller might have
+       *  changed a widget without calling size_changed().
+       */
+      static void discard_size_requests();
+
+      /** Make the next layout reach every widget, even those whose
+       *  allocation is unchanged.  Called by toplevel::queuelayout().
+       */
+      static void discard_layouts();
+
       /** Set the size and location in the parent of this widget.  This
        *  routine should be called by the parent to actually resize and/or
        *  move the widget around.  There is no guarantee that the new
@@ -293,6 +415,13 @@ namespace cwidget
        */
       void alloc_size(int x, int y, int w, int h);
 
+      /** Like alloc_size(), but places the widget in the given window
+       *  instead of its owner's.  Used for the toplevel widget, which
+       *  has a window but no owner, and to lay out a widget on its
+       *  own, e.g. in the test suite.
+       */
+      void set_owner_window(cwindow _win, int x, int y, int w, int h);
+
 
 
 
@@ -335,7 +464,10 @@ namespace cwidget
       bool get_visible() {return visible;}
 
       // Should NOT be overridden -- that was a thinko
-      void sync() {if(win) {win.touch(); win.noutrefresh();}}
+      //
+      // Only the lines that changed are copied to the screen; display()
+      // makes sure that changes made in subwindows are noticed.
+      void sync() {if(win) win.noutrefresh();}
 
       int scroll(int n=1) {return win?win.scroll(n):0;}
 
@@ -382,6 +514,11 @@ namespace cwidget
       int mvaddstr(int y, int x, const wchstring &str) {return win?win.mvaddstr(y, x, str):0;}
       int mvaddnstr(int y, int x, const wchstring &str, int n) {return win?win.mvaddnstr(y, x, str, n):0;}
 
+      int addstr(const fragment_line &str) {return win?win.addstr(str):0;}
+      int addnstr(const fragment_line &str, int n) {return win?win.addnstr(str, n):0;}
+      int mvaddstr(int y, int x, const fragment_line &str) {return win?win.mvaddstr(y, x, str):0;}
+      int mvaddnstr(int y, int x, const fragment_line &str, int n) {return win?win.mvaddnstr(y, x, str, n):0;}
+
       int addstr(const chstring &str) {return win?win.addstr(str):0;}
       int addnstr(const chstring &str, int n) {return win?win.addnstr(str, n):0;}
       int mvaddstr(int y, int x, const chstring &str) {return win?win.mvaddstr(y, x, str):0;}
@@ -463,6 +600,19 @@ namespace cwidget
 	pre_display_erase=opaque;
       }
 
+      /** \return \b true if the widget's entire area is overwritten
+       *  when it is displayed.
+       */
+      bool get_opaque() const {return pre_display_erase;}
+
+      /** \return the part of this widget, in its own coordinates,
+       *  that is certain to be overwritten when it is displayed.  By
+       *  default this is the whole widget if it is opaque, and nothing
+       *  otherwise.  Containers use this to avoid painting widgets
+       *  that are hidden behind others.
+       */
+      virtual rect get_opaque_region();
+
       /** Update this widget's basic style to the given value.  The style
        *  stack must be empty.
        */
@@ -474,6 +624,11 @@ namespace cwidget
        */
       void apply_style(const style &st);
 
+      /** Set the display attributes of our associated window from the
+       *  given interned style, using its precomputed attributes.
+       */
+      void apply_style(const interned_style &st);
+
       typedef std::list<binding_connection>::iterator key_connection;
       // This can be used to connect to a pseudo-signal for keypresses.
       // Most useful for stuff like setting up hotkeys and keyboard accelerators..
@@ -491,6 +646,19 @@ namespace cwidget
       // Eww, do I really need two of these?
       void disconnect_key_post(key_connection c);
 
+      /** \return the scope that handle_key() looks keys up in, or
+       *  \b NULL if this widget doesn't handle keys itself.
+       */
+      virtual config::keybindings *get_bindings() {return NULL;}
+
+      /** Append the scopes in which the keys sent to this widget are
+       *  looked up: get_bindings() and the scopes of connect_key()
+       *  and connect_key_post().  Key sequences are only recognized
+       *  if they are bound in the scopes of a widget that receives
+       *  keys.
+       */
+      void get_binding_scopes(std::vector<const config::keybindings *> &scopes);
+
       // Signals:
       //
       // I use signals for events that an external object (eg,
@@ -514,8 +682,9 @@ namespace cwidget
       sigc::signal0<void> do_layout;
       // Sent when the widget's layout needs to be recalculated and child windows
       // need to be re-updated (mainly when the size is altered)
-      // This should not be called directly by the user.  Use toplevel::queuelayout()
-      // instead.
+      // This should not be called directly by the user.  Use size_changed(),
+      // queue_layout() or toplevel::queuelayout() instead.  It is not sent
+      // if the widget's allocation is unchanged and it didn't queue a layout.
 
       sigc::signal0<void> focussed;
       sigc::signal0<void> unfocussed;
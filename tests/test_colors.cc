@@ -0,0 +1,105 @@
+// Tests for the color pair allocator.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/config/colors.h>
+
+namespace cw = cwidget;
+
+class ColorsTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(ColorsTest);
+
+  CPPUNIT_TEST(testGeneration);
+  CPPUNIT_TEST(testDensePairs);
+  CPPUNIT_TEST(testSparsePairs);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void tearDown()
+  {
+    // Don't leave colors on for the other tests.
+    cw::config::init_colors(0, 0);
+  }
+
+  void testGeneration()
+  {
+    const int generation = cw::config::get_color_generation();
+
+    cw::config::init_colors(8, 4);
+    CPPUNIT_ASSERT(generation != cw::config::get_color_generation());
+    CPPUNIT_ASSERT_EQUAL(8, cw::config::get_num_colors());
+
+    cw::config::init_colors(0, 0);
+    CPPUNIT_ASSERT_EQUAL(0, cw::config::get_num_colors());
+    CPPUNIT_ASSERT_EQUAL(0, cw::config::get_color_pair(COLOR_RED, COLOR_BLACK));
+  }
+
+  void testDensePairs()
+  {
+    // Room for three pairs besides pair 0.
+    cw::config::init_colors(8, 4);
+
+    const int red = cw::config::get_color_pair(COLOR_RED, COLOR_BLACK);
+    const int green = cw::config::get_color_pair(COLOR_GREEN, COLOR_BLACK);
+    const int blue = cw::config::get_color_pair(COLOR_BLUE, COLOR_WHITE);
+
+    CPPUNIT_ASSERT_EQUAL(1, red);
+    CPPUNIT_ASSERT_EQUAL(2, green);
+    CPPUNIT_ASSERT_EQUAL(3, blue);
+    CPPUNIT_ASSERT_EQUAL(red, cw::config::get_color_pair(COLOR_RED, COLOR_BLACK));
+
+    // The pairs have run out, so new combinations share the closest
+    // pair instead of redefining one.
+    CPPUNIT_ASSERT_EQUAL(red, cw::config::get_color_pair(COLOR_RED, COLOR_BLUE));
+    CPPUNIT_ASSERT_EQUAL(blue, cw::config::get_color_pair(COLOR_CYAN, COLOR_WHITE));
+
+    CPPUNIT_ASSERT_EQUAL(red, cw::config::get_color_pair(COLOR_RED, COLOR_BLACK));
+    CPPUNIT_ASSERT_EQUAL(green, cw::config::get_color_pair(COLOR_GREEN, COLOR_BLACK));
+    CPPUNIT_ASSERT_EQUAL(blue, cw::config::get_color_pair(COLOR_BLUE, COLOR_WHITE));
+    CPPUNIT_ASSERT_EQUAL(red, cw::config::get_color_pair(COLOR_RED, COLOR_BLUE));
+
+    // Mixing a color into an existing pair keeps its other color.
+    CPPUNIT_ASSERT_EQUAL((int)COLOR_PAIR(green),
+			 cw::config::mix_color(COLOR_PAIR(red), COLOR_GREEN, -2));
+  }
+
+  void testSparsePairs()
+  {
+    // A direct-color palette; the pairs are limited by the bits
+    // available in an attribute.
+    cw::config::init_colors(1 << 24, 1 << 16);
+
+    const int num_pairs = PAIR_NUMBER(A_COLOR) + 1;
+    const int base = 0x100000;
+
+    for(int i = 1; i < num_pairs; ++i)
+      CPPUNIT_ASSERT_EQUAL(i, cw::config::get_color_pair(base + i, 0));
+
+    for(int i = 1; i < num_pairs; ++i)
+      CPPUNIT_ASSERT_EQUAL(i, cw::config::get_color_pair(base + i, 0));
+
+    // base + 0x12c has the same red as all the pairs, a green of 1
+    // and a blue of 0x2c, so the closest pair is base + 0x2c.
+    CPPUNIT_ASSERT_EQUAL(0x2c, cw::config::get_color_pair(base + 0x12c, 0));
+    CPPUNIT_ASSERT_EQUAL(1, cw::config::get_color_pair(base + 1, 0));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ColorsTest);
@@ -0,0 +1,137 @@
+// Tests for background completion.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/widgets/completion.h>
+#include <cwidget/generic/threads/threads.h>
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+namespace cw = cwidget;
+namespace cww = cwidget::widgets;
+
+namespace
+{
+  // Reports each text that it is asked to complete.
+  class recording_provider : public cww::completion_provider
+  {
+  public:
+    cw::threads::box<std::wstring> seen;
+
+    // If set, complete() waits for a value here before returning.
+    // Only changed while complete() is waiting on it or not running.
+    cw::threads::box<int> *gate;
+
+    recording_provider()
+      :gate(NULL)
+    {
+    }
+
+    void complete(const std::wstring &text, cww::completion_request &req)
+    {
+      req.add_candidate(text + L"1");
+
+      // Read the gate before reporting the text: once the test has
+      // seen it, the test is free to change the gate.
+      cw::threads::box<int> * const g = gate;
+      seen.put(text);
+
+      if(g != NULL)
+	g->take();
+    }
+  };
+
+  void ignore_results(const std::vector<std::wstring> &, bool)
+  {
+  }
+}
+
+class CompletionTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CompletionTest);
+
+  CPPUNIT_TEST(testCommonPrefix);
+  CPPUNIT_TEST(testBackgroundCompletion);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testCommonPrefix()
+  {
+    std::vector<std::wstring> v;
+    CPPUNIT_ASSERT(std::wstring() == cww::common_prefix(v));
+
+    v.push_back(L"apt-get");
+    CPPUNIT_ASSERT(std::wstring(L"apt-get") == cww::common_prefix(v));
+
+    v.push_back(L"apt-cache");
+    v.push_back(L"aptitude");
+    CPPUNIT_ASSERT(std::wstring(L"apt") == cww::common_prefix(v));
+
+    v.push_back(L"bash");
+    CPPUNIT_ASSERT(std::wstring() == cww::common_prefix(v));
+  }
+
+  void testBackgroundCompletion()
+  {
+    recording_provider provider;
+    cw::threads::box<int> gate;
+    provider.gate = &gate;
+
+    const cww::completion_request::result_slot ignore(sigc::ptr_fun(&ignore_results));
+
+    cww::completion_request *first = cww::completion_request::create(ignore);
+    cww::completion_request *second = cww::completion_request::create(ignore);
+    cww::completion_request *third = cww::completion_request::create(ignore);
+
+    first->submit(&provider, L"a");
+    // The provider is now blocked in the completion thread.
+    CPPUNIT_ASSERT(std::wstring(L"a") == provider.seen.take());
+
+    second->submit(&provider, L"b");
+    third->submit(&provider, L"c");
+
+    // Cancelled requests are skipped.
+    second->cancel();
+    CPPUNIT_ASSERT(second->is_cancelled());
+    CPPUNIT_ASSERT(!third->is_cancelled());
+
+    provider.gate = NULL;
+    gate.put(0);
+    CPPUNIT_ASSERT(std::wstring(L"c") == provider.seen.take());
+
+    // Make sure that the completion thread is done with the provider
+    // before it goes away.
+    while(!third->is_finished())
+      usleep(1000);
+
+    std::wstring dummy;
+    CPPUNIT_ASSERT(!provider.seen.try_take(dummy));
+    CPPUNIT_ASSERT(first->is_finished());
+    CPPUNIT_ASSERT(!second->is_finished());
+
+    first->decref();
+    second->decref();
+    third->decref();
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CompletionTest);
@@ -0,0 +1,152 @@
+// Tests for editline histories.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/widgets/edit_history.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace cww = cwidget::widgets;
+
+class EditHistoryTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(EditHistoryTest);
+
+  CPPUNIT_TEST(testDedup);
+  CPPUNIT_TEST(testCapacity);
+  CPPUNIT_TEST(testSearch);
+  CPPUNIT_TEST(testPersistence);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  // Returns the name of a fresh, nonexistent temporary file.
+  static std::string temp_name()
+  {
+    char name[] = "/tmp/cwidget-history-XXXXXX";
+    const int fd = mkstemp(name);
+    CPPUNIT_ASSERT(fd != -1);
+    close(fd);
+    unlink(name);
+    return name;
+  }
+
+public:
+  void testDedup()
+  {
+    cww::edit_history h;
+
+    h.add(L"a");
+    h.add(L"b");
+    h.add(L"b");
+    h.add(L"");
+    CPPUNIT_ASSERT_EQUAL((size_t)2, (size_t)h.size());
+
+    // Re-entering an old string moves it to the end.
+    h.add(L"a");
+    CPPUNIT_ASSERT_EQUAL((size_t)2, (size_t)h.size());
+    CPPUNIT_ASSERT(std::wstring(L"b") == h[0]);
+    CPPUNIT_ASSERT(std::wstring(L"a") == h[1]);
+
+    h.set_dedup(false);
+    h.add(L"b");
+    CPPUNIT_ASSERT_EQUAL((size_t)3, (size_t)h.size());
+  }
+
+  void testCapacity()
+  {
+    cww::edit_history h(3);
+
+    h.add(L"a");
+    h.add(L"b");
+    h.add(L"c");
+    h.add(L"d");
+    CPPUNIT_ASSERT_EQUAL((size_t)3, (size_t)h.size());
+    CPPUNIT_ASSERT(std::wstring(L"b") == h[0]);
+
+    // "a" was dropped, so it is new again.
+    h.add(L"a");
+    CPPUNIT_ASSERT(std::wstring(L"c") == h[0]);
+    CPPUNIT_ASSERT(std::wstring(L"a") == h.back());
+
+    h.set_capacity(1);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, (size_t)h.size());
+    CPPUNIT_ASSERT(std::wstring(L"a") == h[0]);
+  }
+
+  void testSearch()
+  {
+    cww::edit_history h;
+
+    h.add(L"make all");
+    h.add(L"ls");
+    h.add(L"make check");
+    h.add(L"cd src");
+
+    CPPUNIT_ASSERT_EQUAL((size_t)2, (size_t)h.search_backward(L"make"));
+    CPPUNIT_ASSERT_EQUAL((size_t)0, (size_t)h.search_backward(L"make", 1));
+    CPPUNIT_ASSERT_EQUAL((size_t)2, (size_t)h.search_backward(L"make", 2));
+    CPPUNIT_ASSERT_EQUAL((size_t)0, (size_t)h.search_backward(L"make a"));
+    CPPUNIT_ASSERT_EQUAL(cww::edit_history::npos, h.search_backward(L"rm"));
+    CPPUNIT_ASSERT_EQUAL(cww::edit_history::npos, cww::edit_history().search_backward(L""));
+  }
+
+  void testPersistence()
+  {
+    const std::string name = temp_name();
+
+    {
+      cww::edit_history h;
+      CPPUNIT_ASSERT(h.load(name));
+      CPPUNIT_ASSERT(h.empty());
+
+      h.add(L"first");
+      h.add(L"two\nlines");
+      h.add(L"back\\slash");
+      h.add(L"first");
+    }
+
+    {
+      cww::edit_history h;
+      CPPUNIT_ASSERT(h.load(name));
+      CPPUNIT_ASSERT_EQUAL((size_t)3, (size_t)h.size());
+      CPPUNIT_ASSERT(std::wstring(L"two\nlines") == h[0]);
+      CPPUNIT_ASSERT(std::wstring(L"back\\slash") == h[1]);
+      CPPUNIT_ASSERT(std::wstring(L"first") == h[2]);
+
+      // Saving compacts the file.
+      CPPUNIT_ASSERT(h.save(name));
+      h.clear();
+      h.add(L"after clear");
+    }
+
+    {
+      cww::edit_history h;
+      CPPUNIT_ASSERT(h.load(name));
+      CPPUNIT_ASSERT_EQUAL((size_t)1, (size_t)h.size());
+      CPPUNIT_ASSERT(std::wstring(L"after clear") == h[0]);
+    }
+
+    unlink(name.c_str());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EditHistoryTest);
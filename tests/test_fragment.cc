@@ -0,0 +1,226 @@
+// Tests for fragments and fragment lines.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/fragment.h>
+#include <cwidget/fragment_contents.h>
+
+// For displaying assertion failures.
+#include <cwidget/generic/util/transcode.h>
+
+namespace cw = cwidget;
+
+CPPUNIT_NS_BEGIN
+
+template <>
+struct assertion_traits<std::wstring>
+{
+  static bool equal(const std::wstring &x, const std::wstring &y)
+  {
+    return x == y;
+  }
+
+  static std::string toString(const std::wstring &x)
+  {
+    return cwidget::util::transcode(x);
+  }
+};
+
+CPPUNIT_NS_END
+
+class FragmentTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(FragmentTest);
+
+  CPPUNIT_TEST(testLineSlice);
+  CPPUNIT_TEST(testLineIndent);
+  CPPUNIT_TEST(testLineAppend);
+  CPPUNIT_TEST(testIndentbox);
+  CPPUNIT_TEST(testColumns);
+  CPPUNIT_TEST(testFragf);
+  CPPUNIT_TEST(testFragfFormat);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  // Extract the text of a line, dropping its attributes.
+  static std::wstring text(const cw::fragment_line &l)
+  {
+    std::wstring rval;
+    for(size_t i = 0; i < l.size(); ++i)
+      rval += l[i].ch;
+    return rval;
+  }
+
+  // Lay out a fragment and return its text, one line per entry;
+  // deletes the fragment.
+  static std::wstring render(cw::fragment *f)
+  {
+    cw::fragment_contents lines = f->layout(80, 80, cw::style());
+    delete f;
+
+    std::wstring rval;
+    for(cw::fragment_contents::const_iterator it = lines.begin();
+	it != lines.end(); ++it)
+      {
+	if(it != lines.begin())
+	  rval += L'\n';
+	rval += text(*it);
+      }
+    return rval;
+  }
+
+public:
+  void testLineSlice()
+  {
+    const cw::fragment_line l(L"hello world");
+
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"world"), text(cw::fragment_line(l, 6)));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"lo w"), text(cw::fragment_line(l, 3, 4)));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(), text(cw::fragment_line(l, 11)));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"hello world"), text(l));
+  }
+
+  void testLineIndent()
+  {
+    const cw::fragment_line l(L"abc");
+    const cw::fragment_line indented = l.indented(3, cw::wchtype(L'.', 0));
+
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"...abc"), text(indented));
+    CPPUNIT_ASSERT_EQUAL((size_t)6, indented.size());
+    CPPUNIT_ASSERT_EQUAL(6, indented.width());
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"abc"), text(l));
+
+    // Slices can start and end inside the indentation.
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L".ab"), text(cw::fragment_line(indented, 2, 3)));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L".."), text(cw::fragment_line(indented, 1, 2)));
+
+    // Indenting with a different cell turns the old indentation into text.
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"  ...abc"),
+			 text(indented.indented(2, cw::wchtype(L' ', 0))));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"...abc"), text(indented.str()));
+  }
+
+  void testLineAppend()
+  {
+    cw::fragment_line a(L"ab");
+    const cw::fragment_line copy(a);
+
+    a += cw::fragment_line(L"cd");
+    a += cw::fragment_line(2, L'-', 0);
+    a += cw::fragment_line(cw::fragment_line(L"xyz"), 1);
+
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"abcd--yz"), text(a));
+    // The line that shared a's original buffer is unchanged.
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"ab"), text(copy));
+
+    cw::fragment_line empty;
+    empty += copy;
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"ab"), text(empty));
+  }
+
+  void testIndentbox()
+  {
+    cw::fragment *f = cw::indentbox(2, 4,
+				    cw::flowbox(cw::text_fragment(L"aaa bbb ccc")));
+
+    cw::fragment_contents lines = f->layout(9, 9, cw::style());
+
+    CPPUNIT_ASSERT_EQUAL((size_t)2, lines.size());
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"  aaa bbb"), text(lines[0]));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"    ccc"), text(lines[1]));
+
+    delete f;
+  }
+
+  // Enough rows that the columns are laid out on the thread pool.
+  void testColumns()
+  {
+    const size_t num_rows = 50;
+
+    std::vector<cw::fragment *> left, right;
+    for(size_t i = 0; i < num_rows; ++i)
+      {
+	left.push_back(cw::text_fragment(std::wstring(i % 3 + 1, L'a' + i % 26)));
+	right.push_back(i % 5 == 0 ? NULL : cw::flowbox(cw::text_fragment(L"xx yy")));
+      }
+
+    std::vector<cw::fragment_column_entry> columns;
+    columns.push_back(cw::fragment_column_entry(false, false, 3,
+						cw::fragment_column_entry::top,
+						left));
+    columns.push_back(cw::fragment_column_entry(false, false, 3,
+						cw::fragment_column_entry::bottom,
+						right));
+
+    cw::fragment *f = cw::fragment_columns(columns);
+    cw::fragment_contents lines = f->layout(6, 6, cw::style());
+
+    size_t y = 0;
+    for(size_t i = 0; i < num_rows; ++i)
+      {
+	const std::wstring cell(std::wstring(i % 3 + 1, L'a' + i % 26));
+	const std::wstring padded(cell + std::wstring(3 - cell.size(), L' '));
+
+	if(i % 5 == 0)
+	  CPPUNIT_ASSERT_EQUAL(padded + L"   ", text(lines[y++]));
+	else
+	  {
+	    CPPUNIT_ASSERT_EQUAL(padded + L"xx ", text(lines[y++]));
+	    CPPUNIT_ASSERT_EQUAL(std::wstring(L"   yy "), text(lines[y++]));
+	  }
+      }
+    CPPUNIT_ASSERT_EQUAL(y, lines.size());
+
+    delete f;
+  }
+
+  void testFragf()
+  {
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"a 100% b"),
+			 render(cw::fragf("a %s%% %ls", "100", L"b")));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"x\nyz"),
+			 render(cw::fragf("%F%n%By%b%s", cw::text_fragment(L"x"), "z")));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"2-1-2"),
+			 render(cw::fragf("%2$s-%1$s-%2$s", "1", "2")));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"Internal error: bad format string code 'q'"),
+			 render(cw::fragf("%q")));
+  }
+
+  void testFragfFormat()
+  {
+    const cw::fragf_format fmt("%S[%s]%N %F");
+    CPPUNIT_ASSERT_EQUAL((size_t)3, fmt.get_num_args());
+
+    // The same format can be instantiated repeatedly.
+    for(int i = 0; i < 3; ++i)
+      CPPUNIT_ASSERT_EQUAL(std::wstring(L"[ok] frag"),
+			   render(fmt("Error", "ok", cw::text_fragment(L"frag"))));
+
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"no arguments"),
+			 render(cw::fragf_format("no arguments")()));
+
+    const cw::fragf_format wide("%ls!");
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"wide!"), render(wide(L"wide")));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"Bad arguments to fragf: argument 1 has the wrong type!"),
+			 render(wide("narrow")));
+    CPPUNIT_ASSERT_EQUAL(std::wstring(L"Bad arguments to fragf: too few arguments!"),
+			 render(wide()));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FragmentTest);
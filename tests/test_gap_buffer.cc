@@ -0,0 +1,108 @@
+// Tests for the gap buffer.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/generic/util/gap_buffer.h>
+
+#include <string>
+
+namespace cwu = cwidget::util;
+
+class GapBufferTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(GapBufferTest);
+
+  CPPUNIT_TEST(testInsert);
+  CPPUNIT_TEST(testErase);
+  CPPUNIT_TEST(testScattered);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testInsert()
+  {
+    cwu::gap_buffer<wchar_t> buf;
+    CPPUNIT_ASSERT(buf.empty());
+
+    buf.insert(0, std::wstring(L"ace"));
+    buf.insert(1, L'b');
+    buf.insert(3, std::wstring(L"d"));
+    buf.insert(5, std::wstring(L"fgh"));
+
+    CPPUNIT_ASSERT_EQUAL((size_t)8, (size_t)buf.size());
+    CPPUNIT_ASSERT(std::wstring(L"abcdefgh") == buf.str());
+    CPPUNIT_ASSERT_EQUAL(L'c', buf[2]);
+    CPPUNIT_ASSERT(std::wstring(L"cde") == buf.substr(2, 3));
+    CPPUNIT_ASSERT(std::wstring(L"gh") == buf.substr(6));
+  }
+
+  void testErase()
+  {
+    cwu::gap_buffer<wchar_t> buf(std::wstring(L"abcdefgh"));
+
+    buf.erase(6);
+    CPPUNIT_ASSERT(std::wstring(L"abcdef") == buf.str());
+
+    buf.erase(1, 2);
+    CPPUNIT_ASSERT(std::wstring(L"adef") == buf.str());
+
+    buf.insert(1, std::wstring(L"xy"));
+    buf.erase(0, 1);
+    CPPUNIT_ASSERT(std::wstring(L"xydef") == buf.str());
+
+    buf = std::wstring(L"new");
+    CPPUNIT_ASSERT(std::wstring(L"new") == buf.str());
+
+    buf.clear();
+    CPPUNIT_ASSERT(buf.empty());
+    CPPUNIT_ASSERT(std::wstring() == buf.str());
+  }
+
+  // Compare a long series of edits against std::wstring.
+  void testScattered()
+  {
+    cwu::gap_buffer<wchar_t> buf;
+    std::wstring expected;
+
+    unsigned int seed = 1;
+    for(int i = 0; i < 1000; ++i)
+      {
+	seed = seed * 1103515245 + 12345;
+	const size_t pos = (seed >> 8) % (expected.size() + 1);
+
+	if(expected.empty() || (seed >> 20) % 3 != 0)
+	  {
+	    const std::wstring s((seed >> 4) % 5 + 1, L'a' + i % 26);
+	    buf.insert(pos, s);
+	    expected.insert(pos, s);
+	  }
+	else
+	  {
+	    const size_t n = (seed >> 4) % 4;
+	    buf.erase(pos, n);
+	    expected.erase(pos, n);
+	  }
+
+	CPPUNIT_ASSERT_EQUAL(expected.size(), (size_t)buf.size());
+      }
+
+    CPPUNIT_ASSERT(expected == buf.str());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GapBufferTest);
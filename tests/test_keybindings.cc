@@ -0,0 +1,222 @@
+// Tests for the keybinding tables.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/config/keybindings.h>
+
+namespace cw = cwidget;
+
+class KeybindingsTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(KeybindingsTest);
+
+  CPPUNIT_TEST(testActionIds);
+  CPPUNIT_TEST(testKeyMatches);
+  CPPUNIT_TEST(testEquivalentKeys);
+  CPPUNIT_TEST(testParseSequence);
+  CPPUNIT_TEST(testSequences);
+  CPPUNIT_TEST(testAmbiguousSequences);
+  CPPUNIT_TEST(testSequenceScopes);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testActionIds()
+  {
+    const cw::config::action_id a = cw::config::get_action_id("TestAction");
+
+    CPPUNIT_ASSERT_EQUAL(a, cw::config::get_action_id("TestAction"));
+    CPPUNIT_ASSERT_EQUAL(a, cw::config::get_action_id("testaction"));
+    CPPUNIT_ASSERT(a != cw::config::get_action_id("OtherTestAction"));
+  }
+
+  void testKeyMatches()
+  {
+    const cw::config::key a(L'a', false), b(L'b', false), c(L'c', false);
+
+    cw::config::keybindings parent;
+    parent.set("First", a);
+    parent.set("Second", b);
+
+    cw::config::keybindings child(&parent);
+    child.set("second", c);
+
+    const cw::config::action_id first = cw::config::get_action_id("First");
+    const cw::config::action_id second = cw::config::get_action_id("Second");
+
+    CPPUNIT_ASSERT(child.key_matches(a, first));
+    CPPUNIT_ASSERT(!child.key_matches(a, second));
+    // The child's binding of Second hides the parent's.
+    CPPUNIT_ASSERT(child.key_matches(c, second));
+    CPPUNIT_ASSERT(!child.key_matches(b, second));
+    CPPUNIT_ASSERT(parent.key_matches(b, "SECOND"));
+    CPPUNIT_ASSERT(!parent.key_matches(c, "Second"));
+
+    // Modifying the parent is seen by the child.
+    parent.set("First", b);
+    CPPUNIT_ASSERT(!child.key_matches(a, first));
+    CPPUNIT_ASSERT(child.key_matches(b, first));
+  }
+
+  void testEquivalentKeys()
+  {
+    cw::config::keybindings bindings;
+    bindings.set("Confirm", cw::config::key(L'\r', false));
+
+    CPPUNIT_ASSERT(bindings.key_matches(cw::config::key(KEY_ENTER, true), "Confirm"));
+    CPPUNIT_ASSERT(bindings.key_matches(cw::config::key(L'\n', false), "Confirm"));
+    CPPUNIT_ASSERT(!bindings.key_matches(cw::config::key(L' ', false), "Confirm"));
+  }
+
+  void testParseSequence()
+  {
+    const cw::config::key_sequence seq =
+      cw::config::parse_key_sequence(L" C-x  s ");
+
+    CPPUNIT_ASSERT_EQUAL((size_t)2, seq.size());
+    CPPUNIT_ASSERT(cw::config::KEY_CTRL(L'x') == seq[0]);
+    CPPUNIT_ASSERT(cw::config::key(L's', false) == seq[1]);
+    CPPUNIT_ASSERT(cw::config::keyname(seq) == cw::config::keyname(seq[0]) + L" s");
+  }
+
+  static std::vector<cw::config::matched_key> feed(cw::config::key_sequence_matcher &matcher,
+						   const std::wstring &keys)
+  {
+    std::vector<cw::config::matched_key> rval;
+    for(std::wstring::const_iterator it = keys.begin(); it != keys.end(); ++it)
+      matcher.feed(cw::config::key(*it, false), rval);
+    return rval;
+  }
+
+  void testSequences()
+  {
+    cw::config::keybindings bindings;
+    std::vector<cw::config::key_sequence> seqs;
+    seqs.push_back(cw::config::parse_key_sequence(L"q w e"));
+    bindings.set_sequences("TestSequence", seqs);
+
+    CPPUNIT_ASSERT(bindings.keyname("TestSequence") == L"q w e");
+
+    cw::config::key_sequence_matcher matcher;
+    matcher.set_scopes(std::vector<const cw::config::keybindings *>(1, &bindings));
+
+    // Keys that can't start a sequence pass straight through.
+    std::vector<cw::config::matched_key> out = feed(matcher, L"x");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(cw::config::key(L'x', false) == out[0].k);
+    CPPUNIT_ASSERT(out[0].typed.empty());
+
+    out = feed(matcher, L"qw");
+    CPPUNIT_ASSERT(out.empty());
+    CPPUNIT_ASSERT(matcher.is_pending());
+
+    out = feed(matcher, L"e");
+    CPPUNIT_ASSERT(!matcher.is_pending());
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(bindings.key_matches(out[0].k, "TestSequence"));
+    CPPUNIT_ASSERT(!bindings.key_matches(cw::config::key(L'q', false), "TestSequence"));
+    CPPUNIT_ASSERT(out[0].typed == cw::config::parse_key_sequence(L"q w e"));
+
+    // A broken sequence is released as ordinary keys.
+    out = feed(matcher, L"qx");
+    CPPUNIT_ASSERT(!matcher.is_pending());
+    CPPUNIT_ASSERT_EQUAL((size_t)2, out.size());
+    CPPUNIT_ASSERT(cw::config::key(L'q', false) == out[0].k);
+    CPPUNIT_ASSERT(cw::config::key(L'x', false) == out[1].k);
+
+    // Unbinding the sequence removes it from the trie.
+    bindings.set_sequences("TestSequence", std::vector<cw::config::key_sequence>());
+    out = feed(matcher, L"q");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+  }
+
+  void testAmbiguousSequences()
+  {
+    cw::config::keybindings bindings;
+    std::vector<cw::config::key_sequence> seqs;
+    seqs.push_back(cw::config::parse_key_sequence(L"z z"));
+    bindings.set_sequences("Short", seqs);
+    seqs.clear();
+    seqs.push_back(cw::config::parse_key_sequence(L"z z y"));
+    bindings.set_sequences("Long", seqs);
+
+    cw::config::key_sequence_matcher matcher;
+    matcher.set_scopes(std::vector<const cw::config::keybindings *>(1, &bindings));
+
+    std::vector<cw::config::matched_key> out = feed(matcher, L"zz");
+    CPPUNIT_ASSERT(out.empty());
+    matcher.flush(out);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(bindings.key_matches(out[0].k, "Short"));
+
+    out = feed(matcher, L"zzy");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(bindings.key_matches(out[0].k, "Long"));
+
+    // The longest complete sequence wins, and the rest is reprocessed.
+    out = feed(matcher, L"zzz");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(bindings.key_matches(out[0].k, "Short"));
+    CPPUNIT_ASSERT(out[0].typed == cw::config::parse_key_sequence(L"z z"));
+    CPPUNIT_ASSERT(matcher.is_pending());
+    out.clear();
+    matcher.flush(out);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(cw::config::key(L'z', false) == out[0].k);
+  }
+
+  void testSequenceScopes()
+  {
+    cw::config::keybindings parent;
+    cw::config::keybindings child(&parent);
+    cw::config::keybindings other;
+
+    std::vector<cw::config::key_sequence> seqs;
+    seqs.push_back(cw::config::parse_key_sequence(L"g g"));
+    parent.set_sequences("Top", seqs);
+
+    cw::config::key_sequence_matcher matcher;
+
+    // With no scopes, nothing is held back.
+    std::vector<cw::config::matched_key> out = feed(matcher, L"gg");
+    CPPUNIT_ASSERT_EQUAL((size_t)2, out.size());
+
+    // Sequences bound in an unrelated scope are not matched.
+    matcher.set_scopes(std::vector<const cw::config::keybindings *>(1, &other));
+    out = feed(matcher, L"g");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(!matcher.is_pending());
+
+    // A scope sees the sequences that it inherits.
+    matcher.set_scopes(std::vector<const cw::config::keybindings *>(1, &child));
+    out = feed(matcher, L"gg");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+    CPPUNIT_ASSERT(child.key_matches(out[0].k, "Top"));
+
+    // Keys held back when the scopes change are matched again.
+    out = feed(matcher, L"g");
+    CPPUNIT_ASSERT(matcher.is_pending());
+    matcher.set_scopes(std::vector<const cw::config::keybindings *>(1, &other));
+    out = feed(matcher, L"x");
+    CPPUNIT_ASSERT_EQUAL((size_t)2, out.size());
+    CPPUNIT_ASSERT(cw::config::key(L'g', false) == out[0].k);
+    CPPUNIT_ASSERT(cw::config::key(L'x', false) == out[1].k);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(KeybindingsTest);
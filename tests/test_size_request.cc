@@ -0,0 +1,150 @@
+// Tests for the size request cache.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/widgets/frame.h>
+#include <cwidget/widgets/widget.h>
+
+namespace cw = cwidget;
+namespace cww = cwidget::widgets;
+
+namespace
+{
+  // A widget that counts how often it is measured.
+  class counting_widget : public cww::widget
+  {
+  protected:
+    counting_widget()
+      :width_calls(0), height_calls(0), w(10)
+    {
+    }
+
+  public:
+    int width_calls;
+    int height_calls;
+
+    // The desired width; the desired height is 100/width.
+    int w;
+
+    static cw::util::ref_ptr<counting_widget> create()
+    {
+      cw::util::ref_ptr<counting_widget> rval(new counting_widget);
+      rval->decref();
+      return rval;
+    }
+
+    int width_request()
+    {
+      ++width_calls;
+      return w;
+    }
+
+    int height_request(int width)
+    {
+      ++height_calls;
+      return width > 0 ? 100 / width : 0;
+    }
+
+    void paint(const cw::style &st)
+    {
+    }
+
+    bool get_cursorvisible()
+    {
+      return false;
+    }
+
+    cww::point get_cursorloc()
+    {
+      return cww::point(0, 0);
+    }
+  };
+}
+
+class SizeRequestTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(SizeRequestTest);
+
+  CPPUNIT_TEST(testCache);
+  CPPUNIT_TEST(testSizeChanged);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testCache()
+  {
+    cw::util::ref_ptr<counting_widget> w = counting_widget::create();
+
+    CPPUNIT_ASSERT_EQUAL(10, w->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(10, w->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(1, w->width_calls);
+
+    CPPUNIT_ASSERT_EQUAL(10, w->get_height_request(10));
+    CPPUNIT_ASSERT_EQUAL(20, w->get_height_request(5));
+    CPPUNIT_ASSERT_EQUAL(10, w->get_height_request(10));
+    CPPUNIT_ASSERT_EQUAL(20, w->get_height_request(5));
+    CPPUNIT_ASSERT_EQUAL(2, w->height_calls);
+
+    // Fill the cache up, pushing out the height at width 10.
+    w->get_height_request(1);
+    w->get_height_request(2);
+    w->get_height_request(3);
+    CPPUNIT_ASSERT_EQUAL(5, w->height_calls);
+    CPPUNIT_ASSERT_EQUAL(10, w->get_height_request(10));
+    CPPUNIT_ASSERT_EQUAL(6, w->height_calls);
+
+    // Everything is measured again after a global invalidation.
+    cww::widget::discard_size_requests();
+    CPPUNIT_ASSERT_EQUAL(10, w->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(2, w->width_calls);
+    CPPUNIT_ASSERT_EQUAL(10, w->get_height_request(10));
+    CPPUNIT_ASSERT_EQUAL(7, w->height_calls);
+
+    w->destroy();
+  }
+
+  void testSizeChanged()
+  {
+    cw::util::ref_ptr<counting_widget> inner = counting_widget::create();
+    cw::util::ref_ptr<counting_widget> other = counting_widget::create();
+    inner->show();
+
+    cww::widget_ref f = cww::frame::create(inner);
+
+    CPPUNIT_ASSERT_EQUAL(12, f->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(12, f->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(10, other->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(1, inner->width_calls);
+    CPPUNIT_ASSERT_EQUAL(1, other->width_calls);
+
+    // The change is seen through the frame, and unrelated widgets
+    // keep their cached sizes.
+    inner->w = 20;
+    inner->size_changed();
+    CPPUNIT_ASSERT_EQUAL(22, f->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(10, other->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(2, inner->width_calls);
+    CPPUNIT_ASSERT_EQUAL(1, other->width_calls);
+
+    f->destroy();
+    inner->destroy();
+    other->destroy();
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SizeRequestTest);
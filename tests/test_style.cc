@@ -0,0 +1,113 @@
+// Tests for styles and the style tables.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/curses++.h>
+#include <cwidget/style.h>
+
+namespace cw = cwidget;
+
+class StyleTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(StyleTest);
+
+  CPPUNIT_TEST(testIntern);
+  CPPUNIT_TEST(testInternedComposition);
+  CPPUNIT_TEST(testApplyStyle);
+  CPPUNIT_TEST(testStyleHandle);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testIntern()
+  {
+    const cw::style bold = cw::style_attrs_on(A_BOLD);
+    const cw::interned_style a(bold), b(bold);
+
+    CPPUNIT_ASSERT(a == b);
+    CPPUNIT_ASSERT(a != cw::interned_style());
+    CPPUNIT_ASSERT(cw::interned_style(cw::style()) == cw::interned_style());
+    CPPUNIT_ASSERT(bold == a.get_style());
+    CPPUNIT_ASSERT_EQUAL(bold.get_attrs(), a.get_attrs());
+  }
+
+  void testInternedComposition()
+  {
+    const cw::style bold = cw::style_attrs_on(A_BOLD);
+    const cw::style reverse = cw::style_attrs_flip(A_REVERSE);
+    const cw::interned_style ibold(bold), ireverse(reverse);
+
+    const cw::interned_style composed = ibold + ireverse;
+    CPPUNIT_ASSERT(bold + reverse == composed.get_style());
+    // The second composition comes from the cache.
+    CPPUNIT_ASSERT(composed == ibold + ireverse);
+    CPPUNIT_ASSERT(reverse + bold == (ireverse + ibold).get_style());
+
+    CPPUNIT_ASSERT(ibold == ibold + cw::interned_style());
+    CPPUNIT_ASSERT(ibold == cw::interned_style() + ibold);
+
+    cw::interned_style acc;
+    acc += ibold;
+    acc += ireverse;
+    CPPUNIT_ASSERT(composed == acc);
+  }
+
+  void testApplyStyle()
+  {
+    cw::wchstring s(L"abcd");
+    s[1].attrs = A_BOLD;
+    s[2].attrs = A_BOLD;
+
+    const cw::style st = cw::style_attrs_flip(A_REVERSE | A_BOLD);
+
+    cw::wchstring expected(s);
+    for(size_t i = 0; i < expected.size(); ++i)
+      expected[i] = st.apply_to(expected[i]);
+
+    s.apply_style(st);
+
+    CPPUNIT_ASSERT(expected == s);
+    CPPUNIT_ASSERT_EQUAL((attr_t)(A_REVERSE | A_BOLD), s[0].attrs);
+    CPPUNIT_ASSERT_EQUAL((attr_t)A_REVERSE, s[1].attrs);
+  }
+
+  void testStyleHandle()
+  {
+    const cw::style_handle h("TestStyleHandle");
+
+    // Undefined styles are null.
+    CPPUNIT_ASSERT(cw::style() == cw::get_style(h));
+    CPPUNIT_ASSERT(cw::style() == cw::get_style("TestStyleHandle"));
+
+    const cw::style bold = cw::style_attrs_on(A_BOLD);
+    cw::set_style("TestStyleHandle", bold);
+    CPPUNIT_ASSERT(bold == cw::get_style(h));
+    CPPUNIT_ASSERT(bold == cw::get_style("TestStyleHandle"));
+
+    // Handles follow redefinitions.
+    const cw::style dim = cw::style_attrs_on(A_DIM);
+    cw::set_style("TestStyleHandle", dim);
+    CPPUNIT_ASSERT(dim == cw::get_style(h));
+    CPPUNIT_ASSERT(cw::interned_style(dim) == h.get_interned());
+
+    const cw::style_handle h2("TestStyleHandle");
+    CPPUNIT_ASSERT_EQUAL(h.get_index(), h2.get_index());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StyleTest);
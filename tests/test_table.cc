@@ -0,0 +1,532 @@
+// Tests for the table layout.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/config/keybindings.h>
+#include <cwidget/curses++.h>
+#include <cwidget/widgets/table.h>
+#include <cwidget/widgets/widget.h>
+
+#include <stdio.h>
+
+namespace cw = cwidget;
+namespace cww = cwidget::widgets;
+
+namespace
+{
+  // A widget that wants a fixed amount of space, and remembers where
+  // it was last clicked.
+  class fixed_widget : public cww::widget
+  {
+    int w, h;
+    bool focusable;
+
+  protected:
+    fixed_widget(int _w, int _h, bool _focusable)
+      :w(_w), h(_h), focusable(_focusable),
+       clicks(0), click_x(-1), click_y(-1)
+    {
+    }
+
+  public:
+    int clicks, click_x, click_y;
+
+    static cw::util::ref_ptr<fixed_widget> create(int w, int h,
+						    bool focusable = false)
+    {
+      cw::util::ref_ptr<fixed_widget> rval(new fixed_widget(w, h, focusable));
+      rval->decref();
+      return rval;
+    }
+
+    bool focus_me()
+    {
+      return focusable;
+    }
+
+    int width_request()
+    {
+      return w;
+    }
+
+    int height_request(int width)
+    {
+      return h;
+    }
+
+    void paint(const cw::style &st)
+    {
+    }
+
+    bool get_cursorvisible()
+    {
+      return false;
+    }
+
+    cww::point get_cursorloc()
+    {
+      return cww::point(0, 0);
+    }
+
+    void dispatch_mouse(short id, int x, int y, int z, mmask_t bstate)
+    {
+      ++clicks;
+      click_x = x;
+      click_y = y;
+    }
+  };
+
+  typedef cw::util::ref_ptr<fixed_widget> fixed_widget_ref;
+
+  /** Lay out a table as if it filled a w by h screen.
+   *
+   *  Curses can only create windows once a screen is open, so the
+   *  first call opens one on /dev/null.  It is never closed, since
+   *  destroyed widgets can hold on to their windows for a while.
+   */
+  void layout(const cww::table_ref &t, int w, int h)
+  {
+    static SCREEN *screen = NULL;
+
+    if(screen == NULL)
+      {
+	// Take the size from the terminal description, not from the
+	// environment of whoever runs the tests.
+	use_env(FALSE);
+	screen = newterm(const_cast<char *>("vt100"),
+			 fopen("/dev/null", "w"), fopen("/dev/null", "r"));
+	CPPUNIT_ASSERT(screen != NULL);
+      }
+
+    WINDOW *win = newwin(h, w, 0, 0);
+    CPPUNIT_ASSERT(win != NULL);
+
+    t->set_owner_window(cw::cwindow(win), 0, 0, w, h);
+  }
+
+  void click(const cww::table_ref &t, int x, int y)
+  {
+    t->dispatch_mouse(0, x, y, 0, BUTTON1_CLICKED);
+  }
+
+  /** Bind the arrow keys as toplevel::init() does, and press one. */
+  bool press(const cww::table_ref &t, int keycode)
+  {
+    if(cww::table::bindings == NULL)
+      cww::table::init_bindings();
+
+    cw::config::global_bindings.set("Left", cw::config::key(KEY_LEFT, true));
+    cw::config::global_bindings.set("Right", cw::config::key(KEY_RIGHT, true));
+
+    return t->dispatch_key(cw::config::key(keycode, true));
+  }
+
+  void assert_geometry(const fixed_widget_ref &w,
+		       int x, int y, int width, int height)
+  {
+    CPPUNIT_ASSERT_EQUAL(x, w->get_startx());
+    CPPUNIT_ASSERT_EQUAL(y, w->get_starty());
+    CPPUNIT_ASSERT_EQUAL(width, w->get_width());
+    CPPUNIT_ASSERT_EQUAL(height, w->get_height());
+  }
+}
+
+class TableTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TableTest);
+
+  CPPUNIT_TEST(testRequest);
+  CPPUNIT_TEST(testSpans);
+  CPPUNIT_TEST(testVisibility);
+  CPPUNIT_TEST(testMouseInChild);
+  CPPUNIT_TEST(testMouseInMargin);
+  CPPUNIT_TEST(testMouseEmptyColumn);
+  CPPUNIT_TEST(testMouseOverlap);
+  CPPUNIT_TEST(testExpandWidths);
+  CPPUNIT_TEST(testExpandHeights);
+  CPPUNIT_TEST(testShrinkWidths);
+  CPPUNIT_TEST(testShrinkHeights);
+  CPPUNIT_TEST(testFocusTies);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testRequest()
+  {
+    cww::table_ref t = cww::table::create();
+
+    // Two rows of two columns; each column is as wide as its widest
+    // widget and each row as tall as its tallest.
+    t->add_widget(fixed_widget::create(3, 1), 0, 0);
+    t->add_widget(fixed_widget::create(5, 2), 0, 1);
+    t->add_widget(fixed_widget::create(4, 3), 1, 0);
+    t->add_widget(fixed_widget::create(1, 1), 1, 1);
+    t->show_all();
+
+    CPPUNIT_ASSERT_EQUAL(9, t->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(5, t->get_height_request(9));
+
+    t->destroy();
+  }
+
+  void testSpans()
+  {
+    cww::table_ref t = cww::table::create();
+
+    // A wide widget spanning two narrow ones only adds the width that
+    // they don't already provide.
+    t->add_widget(fixed_widget::create(2, 1), 0, 0);
+    t->add_widget(fixed_widget::create(2, 1), 0, 1);
+    t->add_widget(fixed_widget::create(10, 1), 1, 0, 1, 2);
+    t->show_all();
+
+    CPPUNIT_ASSERT_EQUAL(10, t->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(2, t->get_height_request(10));
+
+    t->destroy();
+  }
+
+  void testVisibility()
+  {
+    cww::table_ref t = cww::table::create();
+
+    cww::widget_ref wide = fixed_widget::create(10, 4);
+
+    t->add_widget(fixed_widget::create(2, 1), 0, 0);
+    t->add_widget(wide, 1, 0);
+    t->show_all();
+
+    CPPUNIT_ASSERT_EQUAL(10, t->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(5, t->get_height_request(10));
+
+    // Hidden widgets take no space.
+    wide->hide();
+    CPPUNIT_ASSERT_EQUAL(2, t->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(1, t->get_height_request(2));
+
+    wide->show();
+    CPPUNIT_ASSERT_EQUAL(10, t->get_width_request());
+    CPPUNIT_ASSERT_EQUAL(5, t->get_height_request(10));
+
+    t->destroy();
+  }
+
+  void testMouseInChild()
+  {
+    cww::table_ref t = cww::table::create();
+
+    fixed_widget_ref a = fixed_widget::create(3, 1);
+    fixed_widget_ref b = fixed_widget::create(5, 2);
+    fixed_widget_ref c = fixed_widget::create(4, 3);
+    fixed_widget_ref d = fixed_widget::create(1, 1);
+
+    // The columns are 4 and 5 wide; the rows are 2 and 3 high.
+    t->add_widget(a, 0, 0);
+    t->add_widget(b, 0, 1);
+    t->add_widget(c, 1, 0);
+    t->add_widget(d, 1, 1);
+    t->show_all();
+    layout(t, 9, 5);
+
+    CPPUNIT_ASSERT_EQUAL(4, d->get_startx());
+    CPPUNIT_ASSERT_EQUAL(2, d->get_starty());
+
+    // Clicks are passed on relative to the child.
+    click(t, 6, 3);
+    CPPUNIT_ASSERT_EQUAL(1, d->clicks);
+    CPPUNIT_ASSERT_EQUAL(2, d->click_x);
+    CPPUNIT_ASSERT_EQUAL(1, d->click_y);
+
+    click(t, 3, 1);
+    CPPUNIT_ASSERT_EQUAL(1, a->clicks);
+    CPPUNIT_ASSERT_EQUAL(3, a->click_x);
+    CPPUNIT_ASSERT_EQUAL(1, a->click_y);
+
+    // The first row and column of a cell.
+    click(t, 4, 0);
+    CPPUNIT_ASSERT_EQUAL(1, b->clicks);
+    CPPUNIT_ASSERT_EQUAL(0, b->click_x);
+    CPPUNIT_ASSERT_EQUAL(0, b->click_y);
+
+    // Outside the table.
+    click(t, 9, 0);
+    click(t, 0, 5);
+    CPPUNIT_ASSERT_EQUAL(1, a->clicks);
+    CPPUNIT_ASSERT_EQUAL(1, b->clicks);
+    CPPUNIT_ASSERT_EQUAL(0, c->clicks);
+    CPPUNIT_ASSERT_EQUAL(1, d->clicks);
+
+    t->destroy();
+  }
+
+  void testMouseInMargin()
+  {
+    cww::table_ref t = cww::table::create();
+
+    // The small widget is left-aligned in a column that the wide one
+    // makes 6 wide, so it doesn't fill its cell.
+    fixed_widget_ref small = fixed_widget::create(2, 1);
+    fixed_widget_ref wide = fixed_widget::create(6, 1);
+
+    t->add_widget_opts(small, 0, 0, 1, 1,
+		       cww::table::ALIGN_LEFT, cww::table::ALIGN_LEFT);
+    t->add_widget(wide, 1, 0);
+    t->show_all();
+    layout(t, 6, 2);
+
+    CPPUNIT_ASSERT_EQUAL(0, small->get_startx());
+    CPPUNIT_ASSERT_EQUAL(2, small->get_width());
+
+    click(t, 1, 0);
+    CPPUNIT_ASSERT_EQUAL(1, small->clicks);
+    CPPUNIT_ASSERT_EQUAL(1, small->click_x);
+
+    // The rest of the cell belongs to nobody.
+    click(t, 2, 0);
+    click(t, 5, 0);
+    CPPUNIT_ASSERT_EQUAL(1, small->clicks);
+    CPPUNIT_ASSERT_EQUAL(0, wide->clicks);
+
+    click(t, 5, 1);
+    CPPUNIT_ASSERT_EQUAL(1, wide->clicks);
+    CPPUNIT_ASSERT_EQUAL(5, wide->click_x);
+    CPPUNIT_ASSERT_EQUAL(0, wide->click_y);
+
+    t->destroy();
+  }
+
+  void testMouseEmptyColumn()
+  {
+    cww::table_ref t = cww::table::create();
+
+    // The middle column has no width, so the left and right columns
+    // are next to each other.
+    fixed_widget_ref left = fixed_widget::create(2, 1);
+    fixed_widget_ref empty = fixed_widget::create(0, 1);
+    fixed_widget_ref right = fixed_widget::create(3, 1);
+
+    t->add_widget(left, 0, 0);
+    t->add_widget(empty, 0, 1);
+    t->add_widget(right, 0, 2);
+    t->show_all();
+    layout(t, 5, 1);
+
+    CPPUNIT_ASSERT_EQUAL(0, empty->get_width());
+    CPPUNIT_ASSERT_EQUAL(2, right->get_startx());
+
+    click(t, 1, 0);
+    CPPUNIT_ASSERT_EQUAL(1, left->clicks);
+    CPPUNIT_ASSERT_EQUAL(1, left->click_x);
+
+    click(t, 2, 0);
+    CPPUNIT_ASSERT_EQUAL(1, right->clicks);
+    CPPUNIT_ASSERT_EQUAL(0, right->click_x);
+
+    CPPUNIT_ASSERT_EQUAL(0, empty->clicks);
+
+    t->destroy();
+  }
+
+  void testMouseOverlap()
+  {
+    cww::table_ref t = cww::table::create();
+
+    // The wide widget spans both columns, so it shares the second
+    // with the narrow one; the widget added first gets the click.
+    fixed_widget_ref wide = fixed_widget::create(4, 1);
+    fixed_widget_ref narrow = fixed_widget::create(2, 1);
+
+    t->add_widget(wide, 0, 0, 1, 2);
+    t->add_widget(narrow, 0, 1);
+    t->show_all();
+    layout(t, 4, 1);
+
+    CPPUNIT_ASSERT(narrow->get_width() > 0);
+    CPPUNIT_ASSERT_EQUAL(4, narrow->get_startx() + narrow->get_width());
+
+    click(t, 3, 0);
+    CPPUNIT_ASSERT_EQUAL(1, wide->clicks);
+    CPPUNIT_ASSERT_EQUAL(3, wide->click_x);
+    CPPUNIT_ASSERT_EQUAL(0, narrow->clicks);
+
+    t->destroy();
+
+    // The same table with the children added the other way around.
+    t = cww::table::create();
+
+    wide = fixed_widget::create(4, 1);
+    narrow = fixed_widget::create(2, 1);
+
+    t->add_widget(narrow, 0, 1);
+    t->add_widget(wide, 0, 0, 1, 2);
+    t->show_all();
+    layout(t, 4, 1);
+
+    click(t, 3, 0);
+    CPPUNIT_ASSERT_EQUAL(1, narrow->clicks);
+    CPPUNIT_ASSERT_EQUAL(3 - narrow->get_startx(), narrow->click_x);
+    CPPUNIT_ASSERT_EQUAL(0, wide->clicks);
+
+    t->destroy();
+  }
+
+  void testExpandWidths()
+  {
+    cww::table_ref t = cww::table::create();
+
+    // Only the first and last columns hold expandable widgets of
+    // their own; the widget spanning all three doesn't make the
+    // middle one expandable.
+    fixed_widget_ref a = fixed_widget::create(2, 1);
+    fixed_widget_ref b = fixed_widget::create(2, 1);
+    fixed_widget_ref c = fixed_widget::create(2, 1);
+    fixed_widget_ref d = fixed_widget::create(6, 1);
+
+    t->add_widget_opts(a, 0, 0, 1, 1, cww::table::EXPAND|cww::table::FILL, cww::table::FILL);
+    t->add_widget_opts(b, 0, 1, 1, 1, cww::table::FILL, cww::table::FILL);
+    t->add_widget_opts(c, 0, 2, 1, 1, cww::table::EXPAND|cww::table::FILL, cww::table::FILL);
+    t->add_widget_opts(d, 1, 0, 1, 3, cww::table::EXPAND|cww::table::FILL, cww::table::FILL);
+    t->show_all();
+
+    CPPUNIT_ASSERT_EQUAL(6, t->get_width_request());
+
+    // The extra space is split between the expandable columns.
+    layout(t, 12, 2);
+
+    assert_geometry(a, 0, 0, 5, 1);
+    assert_geometry(b, 5, 0, 2, 1);
+    assert_geometry(c, 7, 0, 5, 1);
+    assert_geometry(d, 0, 1, 12, 1);
+
+    t->destroy();
+  }
+
+  void testExpandHeights()
+  {
+    cww::table_ref t = cww::table::create();
+
+    fixed_widget_ref a = fixed_widget::create(1, 2);
+    fixed_widget_ref b = fixed_widget::create(1, 2);
+
+    t->add_widget_opts(a, 0, 0, 1, 1, cww::table::FILL, cww::table::EXPAND|cww::table::FILL);
+    t->add_widget_opts(b, 1, 0, 1, 1, cww::table::FILL, cww::table::FILL);
+    t->show_all();
+
+    CPPUNIT_ASSERT_EQUAL(4, t->get_height_request(1));
+
+    layout(t, 1, 10);
+
+    assert_geometry(a, 0, 0, 1, 8);
+    assert_geometry(b, 0, 8, 1, 2);
+
+    t->destroy();
+  }
+
+  void testShrinkWidths()
+  {
+    cww::table_ref t = cww::table::create();
+
+    // Only the first column can be shrunk.
+    fixed_widget_ref a = fixed_widget::create(4, 1);
+    fixed_widget_ref b = fixed_widget::create(4, 1);
+
+    t->add_widget_opts(a, 0, 0, 1, 1, cww::table::SHRINK|cww::table::FILL, cww::table::FILL);
+    t->add_widget_opts(b, 0, 1, 1, 1, cww::table::FILL, cww::table::FILL);
+    t->show_all();
+
+    layout(t, 6, 1);
+
+    assert_geometry(a, 0, 0, 2, 1);
+    assert_geometry(b, 2, 0, 4, 1);
+
+    // Once the first column is down to one cell, the end of the
+    // table is cut off.
+    layout(t, 3, 1);
+
+    assert_geometry(a, 0, 0, 1, 1);
+    assert_geometry(b, 1, 0, 2, 1);
+
+    t->destroy();
+  }
+
+  void testShrinkHeights()
+  {
+    cww::table_ref t = cww::table::create();
+
+    fixed_widget_ref a = fixed_widget::create(1, 4);
+    fixed_widget_ref b = fixed_widget::create(1, 4);
+
+    t->add_widget_opts(a, 0, 0, 1, 1, cww::table::FILL, cww::table::SHRINK|cww::table::FILL);
+    t->add_widget_opts(b, 1, 0, 1, 1, cww::table::FILL, cww::table::FILL);
+    t->show_all();
+
+    layout(t, 1, 6);
+
+    assert_geometry(a, 0, 0, 1, 2);
+    assert_geometry(b, 0, 2, 1, 4);
+
+    layout(t, 1, 3);
+
+    assert_geometry(a, 0, 0, 1, 1);
+    assert_geometry(b, 0, 1, 1, 2);
+
+    t->destroy();
+  }
+
+  void testFocusTies()
+  {
+    cww::table_ref t = cww::table::create();
+    const cww::passthrough_ref p = t;
+
+    // The two middle widgets are in the same cell, so neither is a
+    // better fit than the other; the one added first wins.
+    fixed_widget_ref first = fixed_widget::create(1, 1, true);
+    fixed_widget_ref last = fixed_widget::create(1, 1, true);
+    fixed_widget_ref tie1 = fixed_widget::create(1, 1, true);
+    fixed_widget_ref tie2 = fixed_widget::create(1, 1, true);
+
+    t->add_widget(first, 0, 0);
+    t->add_widget(last, 0, 2);
+    t->add_widget(tie1, 0, 1);
+    t->add_widget(tie2, 0, 1);
+    t->show_all();
+
+    t->focus_widget(first);
+    CPPUNIT_ASSERT(p->get_focus() == first);
+
+    CPPUNIT_ASSERT(press(t, KEY_RIGHT));
+    CPPUNIT_ASSERT(p->get_focus() == tie1);
+
+    CPPUNIT_ASSERT(press(t, KEY_RIGHT));
+    CPPUNIT_ASSERT(p->get_focus() == last);
+
+    // Moving off the end wraps around.
+    CPPUNIT_ASSERT(press(t, KEY_RIGHT));
+    CPPUNIT_ASSERT(p->get_focus() == first);
+
+    CPPUNIT_ASSERT(press(t, KEY_LEFT));
+    CPPUNIT_ASSERT(p->get_focus() == last);
+
+    CPPUNIT_ASSERT(press(t, KEY_LEFT));
+    CPPUNIT_ASSERT(p->get_focus() == tie1);
+
+    t->destroy();
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TableTest);
@@ -23,6 +23,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <cwidget/generic/threads/event_queue.h>
+#include <cwidget/generic/threads/thread_pool.h>
 #include <cwidget/generic/threads/threads.h>
 #include <cwidget/generic/util/ssprintf.h>
 
@@ -43,6 +44,8 @@ class TestThreads : public CppUnit::TestFixture
   CPPUNIT_TEST(testTimedTake);
   CPPUNIT_TEST(testEventQueue);
   CPPUNIT_TEST(testAutoDetach);
+  CPPUNIT_TEST(testThreadPool);
+  CPPUNIT_TEST(testThreadPoolFailure);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -240,6 +243,99 @@ public:
   {
     cw::threads::thread t(do_nothing());
   }
+
+  // Sums a range of numbers, optionally submitting the second half
+  // of the range to the pool as a nested batch.
+  class sum_job : public cw::threads::thread_pool::job
+  {
+    cw::threads::thread_pool &pool;
+    int first, last;
+    bool nest;
+    long result;
+
+  public:
+    sum_job(cw::threads::thread_pool &_pool, int _first, int _last, bool _nest)
+      :pool(_pool), first(_first), last(_last), nest(_nest), result(0)
+    {
+    }
+
+    long get_result() const { return result; }
+
+    void run()
+    {
+      int mid = nest ? (first + last) / 2 : last;
+      for(int i = first; i < mid; ++i)
+	result += i;
+
+      if(nest)
+	{
+	  sum_job rest(pool, mid, last, false);
+	  std::vector<cw::threads::thread_pool::job *> jobs;
+	  jobs.push_back(&rest);
+	  pool.run_all(jobs);
+	  result += rest.get_result();
+	}
+    }
+  };
+
+  void do_testThreadPool(int num_threads)
+  {
+    const int num_jobs = 40;
+    const int job_size = 1000;
+
+    cw::threads::thread_pool pool(num_threads);
+    CPPUNIT_ASSERT_EQUAL(num_threads, pool.get_num_threads());
+
+    std::vector<sum_job> jobs;
+    for(int i = 0; i < num_jobs; ++i)
+      jobs.push_back(sum_job(pool, i * job_size, (i + 1) * job_size,
+			     i % 2 == 0));
+
+    std::vector<cw::threads::thread_pool::job *> job_ptrs;
+    for(std::vector<sum_job>::iterator it = jobs.begin();
+	it != jobs.end(); ++it)
+      job_ptrs.push_back(&*it);
+
+    pool.run_all(job_ptrs);
+
+    for(int i = 0; i < num_jobs; ++i)
+      {
+	const long first = i * job_size, last = (i + 1) * job_size;
+	CPPUNIT_ASSERT_EQUAL((last * (last - 1) - first * (first - 1)) / 2,
+			     jobs[i].get_result());
+      }
+  }
+
+  void testThreadPool()
+  {
+    do_testThreadPool(0);
+    do_testThreadPool(1);
+    do_testThreadPool(4);
+  }
+
+  class failing_job : public cw::threads::thread_pool::job
+  {
+  public:
+    void run()
+    {
+      throw cw::threads::ThreadCreateException(EAGAIN);
+    }
+  };
+
+  void testThreadPoolFailure()
+  {
+    cw::threads::thread_pool pool(2);
+
+    failing_job bad;
+    sum_job good(pool, 0, 100, false);
+    std::vector<cw::threads::thread_pool::job *> jobs;
+    jobs.push_back(&bad);
+    jobs.push_back(&good);
+
+    CPPUNIT_ASSERT_THROW(pool.run_all(jobs), cw::threads::JobFailedException);
+    // The rest of the batch still ran.
+    CPPUNIT_ASSERT_EQUAL(4950L, good.get_result());
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestThreads);
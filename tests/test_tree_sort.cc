@@ -0,0 +1,305 @@
+// Tests for sorting tree items.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/generic/threads/thread_pool.h>
+#include <cwidget/widgets/subtree.h>
+#include <cwidget/widgets/treeitem.h>
+
+#include <algorithm>
+
+namespace cww = cwidget::widgets;
+
+namespace
+{
+  class named_item : public cww::treeitem
+  {
+    std::wstring name;
+
+  public:
+    named_item(const std::wstring &_name)
+      :name(_name)
+    {
+    }
+
+    void paint(cww::tree *win, int y, bool hierarchical,
+	       const cwidget::style &st)
+    {
+    }
+
+    const wchar_t *tag() {return name.c_str();}
+    const wchar_t *label() {return name.c_str();}
+  };
+
+  class named_subtree : public cww::subtree_generic
+  {
+    std::wstring name;
+
+  public:
+    named_subtree(const std::wstring &_name)
+      :subtree_generic(true), name(_name)
+    {
+    }
+
+    void paint(cww::tree *win, int y, bool hierarchical,
+	       const cwidget::style &st)
+    {
+    }
+
+    const wchar_t *tag() {return name.c_str();}
+    const wchar_t *label() {return name.c_str();}
+  };
+
+  // Sorts by tag, backwards, without providing keys.
+  class reverse_tag_policy : public cww::sortpolicy
+  {
+  public:
+    bool operator()(cww::treeitem *item1, cww::treeitem *item2)
+    {
+      return wcscmp(item1->tag(), item2->tag()) > 0;
+    }
+  };
+
+  // Reverses the tag order by overriding only the comparison.
+  class reverse_tag_subclass : public cww::tag_sort_policy
+  {
+  public:
+    bool operator()(cww::treeitem *item1, cww::treeitem *item2)
+    {
+      return wcscmp(item1->tag(), item2->tag()) > 0;
+    }
+  };
+
+  // Sorts by tag, counting the items whose keys it is asked for.
+  class counting_tag_policy : public cww::sortpolicy
+  {
+  public:
+    int keys;
+
+    counting_tag_policy()
+      :keys(0)
+    {
+    }
+
+    bool operator()(cww::treeitem *item1, cww::treeitem *item2)
+    {
+      return wcscmp(item1->tag(), item2->tag()) < 0;
+    }
+
+    bool get_sort_key(cww::treeitem *item, std::wstring &key)
+    {
+      ++keys;
+      key = item->tag();
+      return true;
+    }
+  };
+
+  // The tags of the children of t, in order.
+  std::wstring child_tags(cww::treeitem &t)
+  {
+    std::wstring rval;
+
+    cww::tree_levelref *i = t.begin();
+    for( ; !i->is_end(); i->advance_next())
+      rval += i->get_item()->tag();
+    delete i;
+
+    return rval;
+  }
+
+  class tag_lt
+  {
+  public:
+    bool operator()(cww::treeitem *item1, cww::treeitem *item2) const
+    {
+      return wcscmp(item1->tag(), item2->tag()) < 0;
+    }
+  };
+}
+
+class TreeSortTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TreeSortTest);
+
+  CPPUNIT_TEST(testSubtreeSort);
+  CPPUNIT_TEST(testEndSurvivesAdd);
+  CPPUNIT_TEST(testRefFollowsSort);
+  CPPUNIT_TEST(testLargeSort);
+  CPPUNIT_TEST(testParallelSort);
+  CPPUNIT_TEST(testLazySort);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testSubtreeSort()
+  {
+    named_subtree root(L"root");
+    named_subtree *inner = new named_subtree(L"b");
+
+    root.add_child(new named_item(L"c"));
+    root.add_child(inner);
+    root.add_child(new named_item(L"a"));
+
+    inner->add_child(new named_item(L"z"));
+    inner->add_child(new named_item(L"y"));
+
+    root.sort();
+    CPPUNIT_ASSERT(child_tags(root) == L"abc");
+    CPPUNIT_ASSERT(child_tags(*inner) == L"yz");
+
+    reverse_tag_policy reverse;
+    root.sort(reverse);
+    CPPUNIT_ASSERT(child_tags(root) == L"cba");
+    CPPUNIT_ASSERT(child_tags(*inner) == L"zy");
+
+    // A subclass that only changes the comparison isn't sorted by tag.
+    root.sort();
+    reverse_tag_subclass reverse_subclass;
+    root.sort(reverse_subclass);
+    CPPUNIT_ASSERT(child_tags(root) == L"cba");
+  }
+
+  void testEndSurvivesAdd()
+  {
+    named_subtree root(L"root");
+    root.add_child(new named_item(L"a"));
+
+    cww::tree_levelref *end = root.end();
+    CPPUNIT_ASSERT(end->is_end());
+
+    root.add_child(new named_item(L"b"));
+    CPPUNIT_ASSERT(end->is_end());
+
+    end->return_prev();
+    CPPUNIT_ASSERT(!end->is_end());
+    CPPUNIT_ASSERT(std::wstring(end->get_item()->tag()) == L"b");
+
+    delete end;
+  }
+
+  void testRefFollowsSort()
+  {
+    named_subtree root(L"root");
+    root.add_child(new named_item(L"c"));
+    root.add_child(new named_item(L"a"));
+    root.add_child(new named_item(L"b"));
+
+    cww::tree_levelref *ref = root.begin();
+    CPPUNIT_ASSERT(std::wstring(ref->get_item()->tag()) == L"c");
+
+    // The reference stays on the same item when it moves.
+    root.sort();
+    CPPUNIT_ASSERT(std::wstring(ref->get_item()->tag()) == L"c");
+    CPPUNIT_ASSERT(!ref->is_begin());
+    ref->return_prev();
+    CPPUNIT_ASSERT(std::wstring(ref->get_item()->tag()) == L"b");
+
+    delete ref;
+  }
+
+  void testLargeSort()
+  {
+    // Enough items to be sorted in parallel, with plenty of ties.
+    std::vector<named_item *> owned;
+    std::vector<cww::treeitem *> items;
+    for(int i = 0; i < 50000; ++i)
+      {
+	wchar_t buf[16];
+	swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"%d", (i * 7919) % 1000);
+	owned.push_back(new named_item(buf));
+	items.push_back(owned.back());
+      }
+
+    std::vector<cww::treeitem *> expected(items);
+    std::stable_sort(expected.begin(), expected.end(), tag_lt());
+
+    // Use a pool with workers even on a single processor.
+    cwidget::threads::thread_pool pool(3);
+    std::vector<std::vector<cww::treeitem *>::size_type> order;
+    cww::parallel_tag_sort_policy sorter(pool);
+    cww::sort_order(items, sorter, order);
+
+    CPPUNIT_ASSERT_EQUAL(items.size(), order.size());
+    for(std::vector<cww::treeitem *>::size_type i = 0; i < order.size(); ++i)
+      CPPUNIT_ASSERT(items[order[i]] == expected[i]);
+
+    for(std::vector<named_item *>::iterator it = owned.begin();
+	it != owned.end(); ++it)
+      delete *it;
+  }
+
+  void testParallelSort()
+  {
+    named_subtree root(L"root");
+    std::vector<named_subtree *> inner;
+
+    for(int i = 0; i < 20; ++i)
+      {
+	named_subtree *s = new named_subtree(std::wstring(1, L'a' + (i * 7) % 20));
+	for(int j = 0; j < 5; ++j)
+	  s->add_child(new named_item(std::wstring(1, L'e' - j)));
+
+	root.add_child(s);
+	inner.push_back(s);
+      }
+
+    // Sorting in parallel is only done when it is asked for.
+    CPPUNIT_ASSERT(!cww::tag_sort_policy().is_thread_safe());
+
+    cwidget::threads::thread_pool pool(3);
+    cww::parallel_tag_sort_policy sorter(pool);
+    CPPUNIT_ASSERT(sorter.is_thread_safe());
+    root.sort(sorter);
+
+    CPPUNIT_ASSERT(child_tags(root) == L"abcdefghijklmnopqrst");
+    for(std::vector<named_subtree *>::const_iterator it = inner.begin();
+	it != inner.end(); ++it)
+      CPPUNIT_ASSERT(child_tags(**it) == L"abcde");
+  }
+
+  void testLazySort()
+  {
+    named_subtree root(L"root");
+    named_subtree *inner = new named_subtree(L"b");
+
+    root.add_child(new named_item(L"c"));
+    root.add_child(inner);
+    root.add_child(new named_item(L"a"));
+
+    inner->add_child(new named_item(L"z"));
+    inner->add_child(new named_item(L"y"));
+
+    counting_tag_policy sorter;
+    root.sort_lazily(sorter);
+    CPPUNIT_ASSERT_EQUAL(0, sorter.keys);
+
+    // Traversing the root sorts it, but not the subtree below it.
+    CPPUNIT_ASSERT(child_tags(root) == L"abc");
+    CPPUNIT_ASSERT_EQUAL(3, sorter.keys);
+
+    CPPUNIT_ASSERT(child_tags(*inner) == L"yz");
+    CPPUNIT_ASSERT_EQUAL(5, sorter.keys);
+
+    // Each level is only sorted once.
+    child_tags(root);
+    child_tags(*inner);
+    CPPUNIT_ASSERT_EQUAL(5, sorter.keys);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TreeSortTest);
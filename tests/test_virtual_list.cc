@@ -0,0 +1,183 @@
+// Tests for the virtual list widget.
+//
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//   General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program; see the file COPYING.  If not, write to
+//   the Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+//   Boston, MA 02111-1307, USA.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cwidget/widgets/virtual_list.h>
+
+#include <sigc++/functors/ptr_fun.h>
+
+namespace cw = cwidget;
+namespace cww = cwidget::widgets;
+
+namespace
+{
+  typedef cww::virtual_list::size_type size_type;
+
+  // The rows are the numbers from 0 to size-1.
+  class number_provider : public cww::list_provider
+  {
+  public:
+    size_type size;
+    int text_calls;
+
+    number_provider(size_type _size)
+      :size(_size), text_calls(0)
+    {
+    }
+
+    size_type get_size()
+    {
+      return size;
+    }
+
+    std::wstring get_text(size_type row)
+    {
+      ++text_calls;
+      return std::wstring(row % 10 + 1, L'x');
+    }
+  };
+
+  bool is_even(size_type row)
+  {
+    return row % 2 == 0;
+  }
+
+  bool descending(size_type a, size_type b)
+  {
+    return a > b;
+  }
+
+  size_type last_selection;
+
+  void note_selection(size_type row)
+  {
+    last_selection = row;
+  }
+}
+
+class VirtualListTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(VirtualListTest);
+
+  CPPUNIT_TEST(testIdentity);
+  CPPUNIT_TEST(testOrderAndFilter);
+  CPPUNIT_TEST(testReload);
+  CPPUNIT_TEST(testNavigation);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testIdentity()
+  {
+    number_provider p(1000000);
+    cww::virtual_list_ref l = cww::virtual_list::create(&p);
+
+    // Without an order or filter, nothing is stored for each row.
+    CPPUNIT_ASSERT(!l->has_index());
+    CPPUNIT_ASSERT_EQUAL(size_type(1000000), l->get_view_size());
+    CPPUNIT_ASSERT_EQUAL(size_type(123456), l->get_row(123456));
+    CPPUNIT_ASSERT_EQUAL(size_type(0), l->get_selection());
+    CPPUNIT_ASSERT_EQUAL(0, p.text_calls);
+
+    l->destroy();
+  }
+
+  void testOrderAndFilter()
+  {
+    number_provider p(10);
+    cww::virtual_list_ref l = cww::virtual_list::create(&p);
+
+    CPPUNIT_ASSERT(l->select_row(4));
+
+    l->set_filter(sigc::ptr_fun(&is_even));
+    CPPUNIT_ASSERT_EQUAL(size_type(5), l->get_view_size());
+    CPPUNIT_ASSERT_EQUAL(size_type(8), l->get_row(4));
+    // The selected row is still shown, so it stays selected.
+    CPPUNIT_ASSERT_EQUAL(size_type(4), l->get_selection());
+    CPPUNIT_ASSERT_EQUAL(size_type(2), l->get_selected_position());
+    CPPUNIT_ASSERT(!l->select_row(3));
+
+    l->set_order(sigc::ptr_fun(&descending));
+    CPPUNIT_ASSERT_EQUAL(size_type(8), l->get_row(0));
+    CPPUNIT_ASSERT_EQUAL(size_type(0), l->get_row(4));
+    CPPUNIT_ASSERT_EQUAL(size_type(4), l->get_selection());
+
+    l->clear_filter();
+    CPPUNIT_ASSERT_EQUAL(size_type(10), l->get_view_size());
+    CPPUNIT_ASSERT_EQUAL(size_type(9), l->get_row(0));
+
+    l->clear_order();
+    CPPUNIT_ASSERT(!l->has_index());
+    CPPUNIT_ASSERT_EQUAL(size_type(4), l->get_selection());
+    CPPUNIT_ASSERT_EQUAL(size_type(4), l->get_selected_position());
+
+    l->destroy();
+  }
+
+  void testReload()
+  {
+    number_provider p(10);
+    cww::virtual_list_ref l = cww::virtual_list::create(&p);
+    l->selection_changed.connect(sigc::ptr_fun(&note_selection));
+
+    l->select_row(8);
+    CPPUNIT_ASSERT_EQUAL(size_type(8), last_selection);
+
+    // The selected row went away, so the last row is selected.
+    p.size = 5;
+    l->reload();
+    CPPUNIT_ASSERT_EQUAL(size_type(4), l->get_selection());
+    CPPUNIT_ASSERT_EQUAL(size_type(4), last_selection);
+
+    p.size = 0;
+    l->reload();
+    CPPUNIT_ASSERT_EQUAL(cww::virtual_list::npos, l->get_selection());
+    CPPUNIT_ASSERT_EQUAL(cww::virtual_list::npos, last_selection);
+
+    p.size = 3;
+    l->reload();
+    CPPUNIT_ASSERT_EQUAL(size_type(0), l->get_selection());
+
+    l->destroy();
+  }
+
+  void testNavigation()
+  {
+    number_provider p(100);
+    cww::virtual_list_ref l = cww::virtual_list::create(&p);
+
+    l->line_up();
+    CPPUNIT_ASSERT_EQUAL(size_type(0), l->get_selection());
+
+    l->line_down(3);
+    CPPUNIT_ASSERT_EQUAL(size_type(3), l->get_selection());
+
+    l->jump_to_end();
+    CPPUNIT_ASSERT_EQUAL(size_type(99), l->get_selection());
+
+    l->line_down();
+    CPPUNIT_ASSERT_EQUAL(size_type(99), l->get_selection());
+
+    l->line_up(200);
+    CPPUNIT_ASSERT_EQUAL(size_type(0), l->get_selection());
+
+    l->destroy();
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(VirtualListTest);